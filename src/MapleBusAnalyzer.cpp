@@ -4,10 +4,22 @@
 #include <string>
 #include <sstream>
 
-MapleBusAnalyzer::MapleBusAnalyzer() : Analyzer2(), mSettings(new MapleBusAnalyzerSettings()), mSimulationInitilized(false)
+//! Minimum number of samples per bit at the target bus bit rate: 2 for each of a bit's 3 phases, the same margin as the
+//! fixed 12 MHz required at 2 Mbps before the bit rate was configurable. With only one sample per phase, a phase and a
+//! glitch look alike, so neither the bit timing check nor the glitch filter could tell them apart
+static const U32 MIN_SAMPLES_PER_BIT = 6;
+
+MapleBusAnalyzer::MapleBusAnalyzer()
+    : Analyzer2(),
+      mSettings(new MapleBusAnalyzerSettings()),
+      mProgressSample(0),
+      mFrameStyle(MAPLE_BUS_FRAMES_EACH_WORD),
+      mPartialPacket(),
+      mPacketStream(),
+      mPacketFrames(),
+      mSimulationInitilized(false)
 {
     SetAnalyzerSettings(mSettings.get());
-    ResetPacketData();
 }
 
 MapleBusAnalyzer::~MapleBusAnalyzer()
@@ -32,339 +44,282 @@ void MapleBusAnalyzer::SetupResults()
         analyzerType = MapleBusAnalyzerResults::DataFormat::WORD_BYTES;
         break;
 
+    case MapleBusAnalyzerSettings::OUTPUT_STYLE_EACH_PACKET:
+        analyzerType = MapleBusAnalyzerResults::DataFormat::PACKET;
+        break;
+
     default:
     case MapleBusAnalyzerSettings::OUTPUT_STYLE_WORD_BYTES_LE:
         analyzerType = MapleBusAnalyzerResults::DataFormat::WORD_BYTES_LE;
         break;
     }
+
+    // Word styles only differ in how values are written, so they share the same frames
+    if (analyzerType == MapleBusAnalyzerResults::DataFormat::BYTE)
+    {
+        mFrameStyle = MAPLE_BUS_FRAMES_EACH_BYTE;
+    }
+    else if (analyzerType == MapleBusAnalyzerResults::DataFormat::PACKET)
+    {
+        mFrameStyle = MAPLE_BUS_FRAMES_EACH_PACKET;
+    }
+    else
+    {
+        mFrameStyle = MAPLE_BUS_FRAMES_EACH_WORD;
+    }
     mResults.reset(new MapleBusAnalyzerResults(this, mSettings.get(), analyzerType));
     SetAnalyzerResults(mResults.get());
     mResults->AddChannelBubblesWillAppearOn(mSettings->mInputChannelA);
     mResults->AddChannelBubblesWillAppearOn(mSettings->mInputChannelB);
+
+    // Saleae's frames can't be dropped, only the records they refer to; frames whose record was dropped say so
+    mResults->mPacketStore.SetMaxPackets(mSettings->mRetainedPackets);
+    mResults->mPacketIndex.SetMaxPackets(mSettings->mRetainedPackets);
+    mResults->mTransactions.SetMaxTransactions(mSettings->mRetainedPackets);
+    mResults->mErrors.SetMaxErrors(mSettings->mRetainedPackets);
 }
 
-void MapleBusAnalyzer::LogError()
+void MapleBusAnalyzer::OnError(const MapleBusDecodeError& error)
 {
-    // TODO
+    mResults->mErrors.AddError(error);
+
+    if (mFrameStyle != MAPLE_BUS_FRAMES_EACH_PACKET)
+    {
+        AddPacketFrames(mPartialPacket, false, 0);
+    }
+    mPartialPacket.bytes.clear();
+    mPartialPacket.byteEndSamples.clear();
+
+    // Frames of a failed packet don't belong to any packet
+    mResults->CancelPacketAndStartNewPacket();
+
+    mResults->AddMarker(error.sample, AnalyzerResults::ErrorX, mSettings->mInputChannelA);
+    mResults->AddMarker(error.sample, AnalyzerResults::ErrorX, mSettings->mInputChannelB);
 }
 
-void MapleBusAnalyzer::AlignSerialMarkers()
+void MapleBusAnalyzer::OnResync(U64 errorSample, U64 resumeSample)
 {
-    // Align the two sample numbers
-    U64 aSample = mSerialA->GetSampleNumber();
-    U64 bSample = mSerialB->GetSampleNumber();
-    if (aSample > bSample)
+    // Nothing was decoded between the X added by OnError() and this dot
+    if (resumeSample > errorSample)
     {
-        mSerialB->AdvanceToAbsPosition(aSample);
+        mResults->AddMarker(resumeSample, AnalyzerResults::ErrorDot, mSettings->mInputChannelA);
+        mResults->AddMarker(resumeSample, AnalyzerResults::ErrorDot, mSettings->mInputChannelB);
     }
-    else if (bSample > aSample)
+    else
     {
-        mSerialA->AdvanceToAbsPosition(bSample);
+        resumeSample = errorSample;
     }
+    mResults->mErrors.EndError(resumeSample);
+
+    // The skipped span is a frame of its own, referring to the stored error
+    Frame frame;
+    frame.mData1 = mResults->mErrors.GetNumErrors() - 1;
+    frame.mData2 = 0;
+    frame.mType = MapleBusAnalyzerResults::FRAME_DATA_TYPE_ERROR;
+    frame.mFlags = DISPLAY_AS_ERROR_FLAG;
+    frame.mStartingSampleInclusive = errorSample;
+    frame.mEndingSampleInclusive = resumeSample;
+    AddResultFrame(frame);
+    mResults->CancelPacketAndStartNewPacket();
 }
 
-void MapleBusAnalyzer::AdvanceToNeutral()
+void MapleBusAnalyzer::OnPacketStart(U64 startSample, U64 endSample)
 {
-    AlignSerialMarkers();
+    mResults->AddMarker(startSample, AnalyzerResults::Start, mSettings->mInputChannelA);
+    mResults->AddMarker(startSample, AnalyzerResults::Start, mSettings->mInputChannelB);
+
+    mPartialPacket.startSample = startSample;
+    mPartialPacket.dataStartSample = endSample;
+    mPartialPacket.endSample = endSample;
+    mPartialPacket.bytes.clear();
+    mPartialPacket.byteEndSamples.clear();
+    mPartialPacket.crcValid = false;
+}
 
-    // Wait until both serial lines are high
-    while (mSerialA->GetBitState() == BIT_LOW || mSerialB->GetBitState() == BIT_LOW)
-    {
-        if (mSerialA->GetBitState() == BIT_LOW)
-        {
-            mSerialA->AdvanceToNextEdge();
-            mSerialB->AdvanceToAbsPosition(mSerialA->GetSampleNumber());
-        }
+void MapleBusAnalyzer::OnBit(U64 clockEdgeSample, bool clockIsA, bool value)
+{
+    // let's put markers exactly where we sample this bit
+    Channel& clockChannel = clockIsA ? mSettings->mInputChannelA : mSettings->mInputChannelB;
+    mResults->AddMarker(clockEdgeSample, AnalyzerResults::DownArrow, clockChannel);
+}
 
-        if (mSerialB->GetBitState() == BIT_LOW)
-        {
-            mSerialB->AdvanceToNextEdge();
-            mSerialA->AdvanceToAbsPosition(mSerialB->GetSampleNumber());
-        }
+void MapleBusAnalyzer::OnByte(const MapleBusDecodedByte& decodedByte)
+{
+    // Frames are only laid out once the packet ends or fails, the same way for every output style
+    mPartialPacket.bytes.push_back(decodedByte.value);
+    mPartialPacket.byteEndSamples.push_back(decodedByte.endSample);
+    if (decodedByte.type == MAPLE_BUS_DATA_CRC && decodedByte.crcValid)
+    {
+        mPartialPacket.crcValid = true;
     }
 }
 
-void MapleBusAnalyzer::ResetPacketData()
+void MapleBusAnalyzer::OnPacketEnd(const MapleBusPacket& packet)
 {
-    mTotalBytesExpected = -1;
-    mTotalWordsExpected = -1;
-    mNumBytesLeftExpected = -1;
-    mNumWordsLeftExpected = -1;
-    mByteCount = 0;
-    mCurrentWord = 0;
-    mWordStartingSample = 0;
+    U64 packetIndex = mResults->mPacketStore.AddPacket(packet);
+    mPacketStream.AddPacket(packet);
+    mResults->mErrors.CountPacket(packet);
+    AddPacketFrames(packet, true, packetIndex);
+    mPartialPacket.bytes.clear();
+    mPartialPacket.byteEndSamples.clear();
+
+    mResults->AddMarker(packet.endSample, AnalyzerResults::Stop, mSettings->mInputChannelA);
+    mResults->AddMarker(packet.endSample, AnalyzerResults::Stop, mSettings->mInputChannelB);
+
+    // Exactly one packet is committed per stored packet, so packet IDs match packet store indices
+    U64 packetId = mResults->CommitPacketAndStartNewPacket();
+    MapleBusPacketInfo info;
+    mResults->mPacketStore.GetPacketInfo(packetIndex, info);
+    mResults->mPacketIndex.AddPacket(packet.startSample, packet.endSample, info);
+    U64 transactionId = mResults->mTransactions.AddPacket(packetId, info, packet.startSample, packet.endSample);
+    mResults->AddPacketToTransaction(transactionId, packetId);
+
+    mProgressSample = packet.endSample;
+    if (mCommitScheduler->EndPacket())
+    {
+        CommitPendingResults(mProgressSample);
+    }
 }
 
-void MapleBusAnalyzer::AdvanceToNextStart()
+void MapleBusAnalyzer::OnWaitForData()
 {
-    bool startFound = false;
-    while (!startFound)
+    if (mCommitScheduler->HasPending())
     {
-        AdvanceToNeutral();
-
-        mSerialA->AdvanceToNextEdge(); // falling edge -- beginning of the start sequence
-        U64 startSample = mSerialA->GetSampleNumber();
-        U64 endSample = mSerialA->GetSampleOfNextEdge(); // rising edge -- end of the start sequence
-
-        // Advance B to just before the start
-        mSerialB->AdvanceToAbsPosition(startSample - 1);
-
-        // Ensure B clocks 4 times within the start and end without advancing more than we need to
-        bool errorDetected = false;
-        for (U32 i = 0; i < 8 && !errorDetected; ++i)
-        {
-            U64 bSample = mSerialB->GetSampleOfNextEdge();
-
-            if (bSample >= endSample)
-            {
-                // B clocking didn't fall within the expected start sequence
-                errorDetected = true;
-            }
-            else
-            {
-                mSerialB->AdvanceToNextEdge();
-            }
-        }
-
-        // make sure there isn't another clock before endSample
-        if (!errorDetected && !mSerialB->WouldAdvancingToAbsPositionCauseTransition(endSample))
-        {
-            // If we made it here, a valid start sequence was detected
-            mSerialA->AdvanceToAbsPosition(endSample);
-            mSerialB->AdvanceToAbsPosition(endSample);
-            mResults->AddMarker(startSample, AnalyzerResults::Start, mSettings->mInputChannelA);
-            mResults->AddMarker(startSample, AnalyzerResults::Start, mSettings->mInputChannelB);
-            startFound = true;
-        }
-        else
-        {
-            LogError();
-        }
+        CommitPendingResults(mProgressSample);
     }
+    mPacketStream.WritePending();
 }
 
-S32 MapleBusAnalyzer::CheckForEnd(AnalyzerChannelData* clock, AnalyzerChannelData* data, U32 numDataEdges)
+void MapleBusAnalyzer::AddPacketFrames(const MapleBusPacket& packet, bool isStored, U64 packetIndex)
 {
-    bool endDetected = false;
-    bool errorDetected = false;
-
-    if (numDataEdges == 2)
+    MapleBusFrameLayout::LayOut(packet, packetIndex, mFrameStyle, mPacketFrames);
+    for (std::vector<MapleBusFrameSpec>::const_iterator iter = mPacketFrames.begin(); iter != mPacketFrames.end(); ++iter)
     {
-        // Either we are reaching the end or error detected
-
-        U64 markerEnd = data->GetSampleOfNextEdge();
-        U32 numClockEdges = 0;
-
-        for (; numClockEdges < 3 && clock->GetSampleOfNextEdge() < markerEnd; ++numClockEdges)
+        Frame frame;
+        frame.mData1 = iter->value;
+        frame.mData2 = static_cast<U32>(iter->numLeft);
+        frame.mType = MapleBusAnalyzerResults::FRAME_DATA_TYPE_PAYLOAD;
+        if (iter->kind == MAPLE_BUS_FRAME_KIND_PACKET)
         {
-            // Go to rising then falling then rising
-            clock->AdvanceToNextEdge();
+            // A single frame refers to the stored packet
+            frame.mType = MapleBusAnalyzerResults::FRAME_DATA_TYPE_PACKET;
         }
-
-        if (numClockEdges == 3 && !clock->WouldAdvancingToAbsPositionCauseTransition(markerEnd))
+        else if (iter->type == MAPLE_BUS_DATA_FRAME)
         {
-            endDetected = true;
-            mResults->AddMarker(markerEnd, AnalyzerResults::Stop, mSettings->mInputChannelA);
-            mResults->AddMarker(markerEnd, AnalyzerResults::Stop, mSettings->mInputChannelB);
-            clock->AdvanceToAbsPosition(markerEnd);
-            data->AdvanceToAbsPosition(markerEnd);
+            frame.mType = MapleBusAnalyzerResults::FRAME_DATA_TYPE_FRAME;
         }
-        else
+        else if (iter->type == MAPLE_BUS_DATA_CRC)
         {
-            errorDetected = true;
+            frame.mType = MapleBusAnalyzerResults::FRAME_DATA_TYPE_CRC;
         }
-    }
-    else if (numDataEdges > 2)
-    {
-        errorDetected = true;
-    }
+        frame.mFlags = iter->error ? DISPLAY_AS_ERROR_FLAG : 0;
+        if (isStored && iter->startsPacket && packetIndex <= MapleBusAnalyzerResults::MAX_FRAME_PACKET_INDEX)
+        {
+            // Lets the search list describe the packet without looking it up by sample; beyond 2^32 packets, the frame
+            // is only listed as shown in bubble text
+            frame.mData2 |= packetIndex << 32;
+            frame.mFlags |= MapleBusAnalyzerResults::FRAME_FLAG_PACKET_START;
+        }
+        frame.mStartingSampleInclusive = iter->startSample;
+        frame.mEndingSampleInclusive = iter->endSample;
 
-    if (errorDetected)
-    {
-        return -1;
+        AddResultFrame(frame);
     }
-    else if (endDetected)
-    {
-        return 1;
-    }
-    else
+}
+
+void MapleBusAnalyzer::AddResultFrame(const Frame& frame)
+{
+    mResults->AddFrame(frame);
+    mProgressSample = frame.mEndingSampleInclusive;
+    if (mCommitScheduler->AddFrame())
     {
-        return 0;
+        CommitPendingResults(mProgressSample);
     }
 }
 
-void MapleBusAnalyzer::SaveByte(U64 startingSample, U8 theByte)
+void MapleBusAnalyzer::CommitPendingResults(U64 progressSample)
 {
-    ++mByteCount;
-
-    // Build word (little endian)
-    mCurrentWord = mCurrentWord >> 8;
-    mCurrentWord |= (static_cast<U32>(theByte) << 24);
+    mResults->CommitResults();
+    ReportProgress(progressSample);
+    mCommitScheduler->Committed();
+}
 
-    if (mByteCount == 1)
-    {
-        // This is the first byte which tells us how many extra 32-bit words to expect
-        mTotalBytesExpected = theByte * 4;
-        // Add 4 bytes for the first frame
-        mTotalBytesExpected += 4;
-        // Add 1 byte for the CRC value
-        mTotalBytesExpected += 1;
-
-        mNumBytesLeftExpected = mTotalBytesExpected - 1;
-    }
-    else if (mNumBytesLeftExpected > 0)
+void MapleBusAnalyzer::WorkerThread()
+{
+    MapleBusCommitPolicy commitPolicy = MAPLE_BUS_COMMIT_BATCHED;
+    switch (mSettings->mCommitResults)
     {
-        --mNumBytesLeftExpected;
+    case MapleBusAnalyzerSettings::COMMIT_RESULTS_EACH_FRAME:
+        commitPolicy = MAPLE_BUS_COMMIT_EACH_FRAME;
+        break;
+
+    case MapleBusAnalyzerSettings::COMMIT_RESULTS_EACH_PACKET:
+        commitPolicy = MAPLE_BUS_COMMIT_EACH_PACKET;
+        break;
+
+    default:
+    case MapleBusAnalyzerSettings::COMMIT_RESULTS_BATCHED:
+        commitPolicy = MAPLE_BUS_COMMIT_BATCHED;
+        break;
     }
+    mCommitScheduler.reset(
+        new MapleBusCommitScheduler(commitPolicy, mSettings->mCommitBatchFrames, mSettings->mCommitBatchMilliseconds));
+    mProgressSample = 0;
 
-    if (mResults->mDataFormat == MapleBusAnalyzerResults::DataFormat::BYTE || mNumBytesLeftExpected == 0)
+    // The stream of a previous run is closed here, since the thread is killed rather than returning
+    mPacketStream.Close();
+    if (!mSettings->mPacketStreamPath.empty())
     {
-        Frame frame;
-        frame.mData1 = theByte;
-        MapleBusAnalyzerResults::FrameDataType wordType = MapleBusAnalyzerResults::FRAME_DATA_TYPE_PAYLOAD;
-        if (mByteCount < 5)
-        {
-            wordType = MapleBusAnalyzerResults::FRAME_DATA_TYPE_FRAME;
-        }
-        else if (mNumBytesLeftExpected == 0)
-        {
-            wordType = MapleBusAnalyzerResults::FRAME_DATA_TYPE_CRC;
-        }
-        frame.mData2 = mNumBytesLeftExpected;
-        frame.mType = wordType;
-        frame.mFlags = 0;
-        frame.mStartingSampleInclusive = startingSample;
-        frame.mEndingSampleInclusive = mSerialB->GetSampleNumber();
-
-        mResults->AddFrame(frame);
-        mResults->CommitResults();
-        ReportProgress(frame.mEndingSampleInclusive);
+        mPacketStream.Open(mSettings->mPacketStreamPath.c_str());
     }
 
-    if (mByteCount == 1)
+    MapleBusChannelTransitionSource source(GetAnalyzerChannelData(mSettings->mInputChannelA),
+                                           GetAnalyzerChannelData(mSettings->mInputChannelB), this);
+    MapleBusDecoder decoder(this);
+    switch (mSettings->mBitMarkers)
     {
-        mTotalWordsExpected = theByte + 1;
-        mNumWordsLeftExpected = mTotalWordsExpected;
+    case MapleBusAnalyzerSettings::BIT_MARKERS_NONE:
+        decoder.SetBitReporting(MAPLE_BUS_BITS_NONE);
+        break;
+
+    case MapleBusAnalyzerSettings::BIT_MARKERS_ERRORS_ONLY:
+        decoder.SetBitReporting(MAPLE_BUS_BITS_ON_ERROR);
+        break;
+
+    default:
+    case MapleBusAnalyzerSettings::BIT_MARKERS_ALL:
+        decoder.SetBitReporting(MAPLE_BUS_BITS_ALL);
+        break;
     }
-    else if (mByteCount % 4 == 0)
+
+    switch (mSettings->mTimingCheck)
     {
-        // We have a word to save
-        if (mNumWordsLeftExpected > 0)
-        {
-            --mNumWordsLeftExpected;
-        }
+    case MapleBusAnalyzerSettings::TIMING_CHECK_OFF:
+        decoder.SetTimingCheck(MAPLE_BUS_TIMING_OFF, mSettings->mTimingTolerancePercent);
+        break;
 
-        if (mResults->mDataFormat == MapleBusAnalyzerResults::DataFormat::WORD ||
-            mResults->mDataFormat == MapleBusAnalyzerResults::DataFormat::WORD_BYTES ||
-            mResults->mDataFormat == MapleBusAnalyzerResults::DataFormat::WORD_BYTES_LE)
-        {
-            Frame frame;
-            frame.mData1 = mCurrentWord;
-            MapleBusAnalyzerResults::FrameDataType wordType = MapleBusAnalyzerResults::FRAME_DATA_TYPE_PAYLOAD;
-            if (mByteCount == 4)
-            {
-                wordType = MapleBusAnalyzerResults::FRAME_DATA_TYPE_FRAME;
-            }
-            frame.mData2 = mNumWordsLeftExpected;
-            frame.mType = wordType;
-            frame.mStartingSampleInclusive = mWordStartingSample;
-            frame.mEndingSampleInclusive = mSerialB->GetSampleNumber();
-
-            mResults->AddFrame(frame);
-            mResults->CommitResults();
-        }
-        mCurrentWord = 0;
+    case MapleBusAnalyzerSettings::TIMING_CHECK_REJECT:
+        decoder.SetTimingCheck(MAPLE_BUS_TIMING_REJECT, mSettings->mTimingTolerancePercent);
+        break;
+
+    default:
+    case MapleBusAnalyzerSettings::TIMING_CHECK_FLAG:
+        decoder.SetTimingCheck(MAPLE_BUS_TIMING_FLAG, mSettings->mTimingTolerancePercent);
+        break;
     }
 
-    if (mByteCount % 4 == 1)
+    // Saleae's channel data blocks for more edges, so this only returns once the thread is killed
+    U32 sampleRateHz = GetSampleRate();
+    U32 minWidthA = MapleBusGlitchFilter::NanosecondsToSamples(mSettings->mGlitchFilterANs, sampleRateHz);
+    U32 minWidthB = MapleBusGlitchFilter::NanosecondsToSamples(mSettings->mGlitchFilterBNs, sampleRateHz);
+    if (minWidthA > 0 || minWidthB > 0)
     {
-        mWordStartingSample = startingSample;
+        MapleBusGlitchFilter filter(&source, minWidthA, minWidthB);
+        decoder.Run(&filter);
     }
-}
-
-void MapleBusAnalyzer::WorkerThread()
-{
-    mSerialA = GetAnalyzerChannelData(mSettings->mInputChannelA);
-    mSerialB = GetAnalyzerChannelData(mSettings->mInputChannelB);
-
-    bool errorDetected = false;
-    while (true)
+    else
     {
-        if (errorDetected)
-        {
-            LogError();
-            errorDetected = false;
-        }
-
-        // Wait for the start of the next packet
-        AdvanceToNextStart();
-        ResetPacketData();
-
-        bool endDetected = false;
-        while (!endDetected && !errorDetected)
-        {
-            // Get the next byte
-
-            U64 startingSample = mSerialA->GetSampleNumber();
-            bool aIsClock = true;
-            U8 currentByte = 0;
-            U8 mask = 1 << 7;
-            for (U32 i = 0; i < 8 && !endDetected && !errorDetected; i++, aIsClock = !aIsClock, mask = mask >> 1)
-            {
-                // Data and clock flip flop on each bit
-                AnalyzerChannelData* clock = aIsClock ? mSerialA : mSerialB;
-                Channel clockChannel = aIsClock ? mSettings->mInputChannelA : mSettings->mInputChannelB;
-                AnalyzerChannelData* data = aIsClock ? mSerialB : mSerialA;
-                Channel dataChannel = aIsClock ? mSettings->mInputChannelB : mSettings->mInputChannelA;
-
-                if (clock->GetBitState() == BIT_LOW)
-                {
-                    // Need to wait for clock to transition to high first
-                    clock->AdvanceToNextEdge();
-                }
-
-                // Go to clock falling edge
-                clock->AdvanceToNextEdge();
-                U64 clockEdgeSample = clock->GetSampleNumber();
-                U32 numDataEdges = data->AdvanceToAbsPosition(clockEdgeSample);
-
-                if (i == 0)
-                {
-                    U32 checkStatus = CheckForEnd(clock, data, numDataEdges);
-                    if (checkStatus < 0)
-                    {
-                        errorDetected = true;
-                    }
-                    else if (checkStatus > 0)
-                    {
-                        endDetected = true;
-                    }
-                }
-                else if (numDataEdges > 1)
-                {
-                    // More than 1 data edge before clock is not expected
-                    errorDetected = true;
-                }
-
-                if (!endDetected && !errorDetected)
-                {
-                    // Valid bit detected
-                    if (data->GetBitState() == BIT_HIGH)
-                    {
-                        currentByte |= mask;
-                    }
-                    // let's put markers exactly where we sample this bit:
-                    // mResults->AddMarker( clockEdgeSample, AnalyzerResults::Dot, dataChannel );
-                    mResults->AddMarker(clockEdgeSample, AnalyzerResults::DownArrow, clockChannel);
-                }
-            }
-
-            if (!endDetected && !errorDetected)
-            {
-                // we have a byte to save!
-                SaveByte(startingSample, currentByte);
-            }
-        }
+        decoder.Run(&source);
     }
 }
 
@@ -387,8 +342,7 @@ U32 MapleBusAnalyzer::GenerateSimulationData(U64 minimum_sample_index, U32 devic
 
 U32 MapleBusAnalyzer::GetMinimumSampleRateHz()
 {
-    // Somewhat arbitrary
-    return 12000000;
+    return mSettings->mBusBitRateKbps * 1000 * MIN_SAMPLES_PER_BIT;
 }
 
 const char* MapleBusAnalyzer::GetAnalyzerName() const
@@ -4,9 +4,15 @@
 #include <Analyzer.h>
 #include "MapleBusAnalyzerResults.h"
 #include "MapleBusSimulationDataGenerator.h"
+#include "MapleBusDecoder.h"
+#include "MapleBusChannelTransitionSource.h"
+#include "MapleBusCommitScheduler.h"
+#include "MapleBusFrameLayout.h"
+#include "MapleBusGlitchFilter.h"
+#include "MapleBusPacketStream.h"
 
 class MapleBusAnalyzerSettings;
-class ANALYZER_EXPORT MapleBusAnalyzer : public Analyzer2
+class ANALYZER_EXPORT MapleBusAnalyzer : public Analyzer2, private MapleBusDecoderListener, private MapleBusChannelWaitListener
 {
   public:
     //! Constructor
@@ -21,8 +27,7 @@ class ANALYZER_EXPORT MapleBusAnalyzer : public Analyzer2
     virtual void WorkerThread();
 
     //! API: Simulation data generator
-    //! This feature is currently not implemented
-    //! @returns 0
+    //! @returns the number of simulated channels
     virtual U32 GenerateSimulationData(U64 newest_sample_requested, U32 sample_rate, SimulationChannelDescriptor** simulation_channels);
     //! API: returns the minumum sample rate needed for this analyzer to Saleae's SDK
     virtual U32 GetMinimumSampleRateHz();
@@ -33,63 +38,60 @@ class ANALYZER_EXPORT MapleBusAnalyzer : public Analyzer2
     //! @returns false always
     virtual bool NeedsRerun();
 
-  private:
-    //! Logs information about the current markers to debug log file 
-    void LogError();
-    //! Aligns the two serial positions to the same sample number
-    void AlignSerialMarkers();
-    //! Advances the two serial positions to the point where both signals are BIT_HIGH
-    void AdvanceToNeutral();
-    //! Resets all packet state data
-    void ResetPacketData();
-    //! Advances the two serial markers just past the next starting sequence
-    void AdvanceToNextStart();
-    //! Checks if the end sequence is detected just past the current positions.
-    //! @param[in,out] clock  the analyzer channel of the current clock positioned at a falling edge; 
-    //!                       this is advanced iff error or end detected
-    //! @param[in,out] data  the analyzer channel of the current data; 
-    //!                      this is advanced iff error or end detected
-    //! @param[in] numDataEdges  number of data edges detected between last sample and current clock edge
-    //! @returns -1 if error was detected
-    //! @returns 0 if end was not detected
-    //! @returns 1 if end was detected
-    S32 CheckForEnd(AnalyzerChannelData* clock, AnalyzerChannelData* data, U32 numDataEdges);
-    //! Saves the next byte
-    //! @param[in] startingSample  the starting sample number where the first bit of this byte was read
-    //! @param[in] theByte  value of the byte to save
-    void SaveByte(U64 startingSample, U8 theByte);
+  private: // MapleBusDecoderListener
+    //! Adds start markers for the detected packet and starts collecting its bytes
+    virtual void OnPacketStart(U64 startSample, U64 endSample);
+    //! Adds a marker where the bit was sampled
+    virtual void OnBit(U64 clockEdgeSample, bool clockIsA, bool value);
+    //! Collects the byte in case the packet fails
+    virtual void OnByte(const MapleBusDecodedByte& decodedByte);
+    //! Stores and streams the completed packet, counts it if faulty, saves the frames the output style calls for, adds stop markers, and
+    //! groups the packet's frames into a packet and transaction
+    virtual void OnPacketEnd(const MapleBusPacket& packet);
+    //! Stores the error, saves the frames of the bytes the failed packet received, outside of any packet grouping, and
+    //! marks the error
+    virtual void OnError(const MapleBusDecodeError& error);
+    //! Marks where the span skipped after an error ends and saves an error frame over the span
+    virtual void OnResync(U64 errorSample, U64 resumeSample);
+
+  private: // MapleBusChannelWaitListener
+    //! Commits anything held back and writes out streamed packets before waiting for more data
+    virtual void OnWaitForData();
+
+  private: // functions
+    //! Adds the frames the output style calls for
+    //! @param[in] packet  the packet, complete or not
+    //! @param[in] isStored  true iff the packet completed and was stored
+    //! @param[in] packetIndex  the index the packet was stored at; only used if isStored is true
+    void AddPacketFrames(const MapleBusPacket& packet, bool isStored, U64 packetIndex);
+    //! Adds a frame, committing results when the commit schedule calls for it
+    //! @param[in] frame  the frame to add
+    void AddResultFrame(const Frame& frame);
+    //! Commits results and reports progress
+    //! @param[in] progressSample  the sample number decoded up to
+    void CommitPendingResults(U64 progressSample);
 
   protected: // vars
     //! Pointer to my input settings
     std::auto_ptr<MapleBusAnalyzerSettings> mSettings;
     //! Pointer to my output results
     std::auto_ptr<MapleBusAnalyzerResults> mResults;
-    //! Pointer to the selected serial A channel
-    AnalyzerChannelData* mSerialA;
-    //! Pointer to the selected serial B channel
-    AnalyzerChannelData* mSerialB;
-
+    //! Decides when to commit results; created at the start of each run
+    std::auto_ptr<MapleBusCommitScheduler> mCommitScheduler;
+    //! The sample number results were last decoded up to
+    U64 mProgressSample;
+    //! Which frames the output style shows
+    MapleBusFrameStyle mFrameStyle;
+    //! Bytes of the packet being received, kept so that a failed packet's bytes can still be shown
+    MapleBusPacket mPartialPacket;
+    //! Where each packet is streamed as it is decoded, if a path is set; opened at the start of each run
+    MapleBusPacketStreamWriter mPacketStream;
+    //! Frames of the latest packet; kept to reuse its memory
+    std::vector<MapleBusFrameSpec> mPacketFrames;
     //! Simulation data generated called by GenerateSimulationData()
     MapleBusSimulationDataGenerator mSimulationDataGenerator;
     //! false until first call to GenerateSimulationData()
     bool mSimulationInitilized;
-
-    // Packet state variables
-    //
-    //! Total number of bytes expected in the current packet
-    S32 mTotalBytesExpected;
-    //! Total number of 32-bit words expected in the current packet
-    S32 mTotalWordsExpected;
-    //! Expected number of bytes left to sample in the current packet
-    S32 mNumBytesLeftExpected;
-    //! Expected number of 32-bit words left to sample in the current packet
-    S32 mNumWordsLeftExpected;
-    //! Number of bytes sampled in the current packet
-    U32 mByteCount;
-    //! The current 32-bit word state of this packet
-    U32 mCurrentWord;
-    //! The sample number of the start of the current word
-    U64 mWordStartingSample;
 };
 
 extern "C" ANALYZER_EXPORT const char* __cdecl GetAnalyzerName();
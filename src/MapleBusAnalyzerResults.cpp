@@ -2,12 +2,53 @@
 #include <AnalyzerHelpers.h>
 #include "MapleBusAnalyzer.h"
 #include "MapleBusAnalyzerSettings.h"
+#include "MapleBusNumberFormat.h"
+#include "MapleBusProtocol.h"
 #include <stdio.h>
-#include <iostream>
-#include <fstream>
+#include <string.h>
+#include <vector>
+
+//! Shown in place of a packet or error which was dropped to bound memory (see MapleBusAnalyzerSettings::mRetainedPackets)
+static const char* const NOT_RETAINED_STR = "(not retained)";
+
+//! Same as AnalyzerHelpers::GetNumberString(), but hex and decimal are formatted through lookup tables
+static void GetNumberString(U64 number, DisplayBase display_base, U32 num_data_bits, char* result_string, U32 result_string_max_length)
+{
+    char number_str[MapleBusNumberFormat::MAX_HEX_CHARS + MapleBusNumberFormat::MAX_DECIMAL_CHARS];
+    U32 number_len = 0;
+    switch (display_base)
+    {
+    case Hexadecimal:
+        number_len = MapleBusNumberFormat::FormatHex(number, num_data_bits, number_str);
+        break;
+
+    case Decimal:
+        number_len = MapleBusNumberFormat::FormatDecimal(number, number_str);
+        break;
+
+    default:
+        AnalyzerHelpers::GetNumberString(number, display_base, num_data_bits, result_string, result_string_max_length);
+        return;
+    }
+
+    number_len = (number_len < result_string_max_length) ? number_len : (result_string_max_length - 1);
+    memcpy(result_string, number_str, number_len);
+    result_string[number_len] = '\0';
+}
 
 MapleBusAnalyzerResults::MapleBusAnalyzerResults(MapleBusAnalyzer* analyzer, MapleBusAnalyzerSettings* settings, DataFormat type)
-    : AnalyzerResults(), mDataFormat(type), mSettings(settings), mAnalyzer(analyzer)
+    : AnalyzerResults(),
+      mDataFormat(type),
+      mSettings(settings),
+      mAnalyzer(analyzer),
+      mExportBlocks(),
+      mExportNumFrames(0),
+      mExportDisplayBase(Hexadecimal),
+      mExportTriggerSample(0),
+      mExportSampleRate(0),
+      mExportPreviousNumItemsLeft(0),
+      mExportPreviousWordType(FRAME_DATA_TYPE_NONE),
+      mBubbleTextCache()
 {
 }
 
@@ -15,14 +56,14 @@ MapleBusAnalyzerResults::~MapleBusAnalyzerResults()
 {
 }
 
-void MapleBusAnalyzerResults::GenerateNumberStr(char* str, U32 len, const Frame& frame, DisplayBase display_base, bool forExport) const
+void MapleBusAnalyzerResults::GenerateNumberStr(char* str, U32 len, const Frame& frame, DisplayBase display_base) const
 {
     switch (mDataFormat)
     {
     default:
     case DataFormat::BYTE:
     {
-        AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 8, str, len);
+        GetNumberString(frame.mData1, display_base, 8, str, len);
     }
     break;
 
@@ -34,7 +75,7 @@ void MapleBusAnalyzerResults::GenerateNumberStr(char* str, U32 len, const Frame&
             // CRC byte
             numDataBits = 8;
         }
-        AnalyzerHelpers::GetNumberString(frame.mData1, display_base, numDataBits, str, len);
+        GetNumberString(frame.mData1, display_base, numDataBits, str, len);
     }
     break;
 
@@ -44,16 +85,7 @@ void MapleBusAnalyzerResults::GenerateNumberStr(char* str, U32 len, const Frame&
         if (frame.mType == FRAME_DATA_TYPE_CRC)
         {
             // CRC byte
-            if (forExport)
-            {
-                char number_str[32];
-                AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 8, number_str, sizeof(number_str));
-                snprintf(str, len, "%s,,,", number_str);
-            }
-            else
-            {
-                AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 8, str, len);
-            }
+            GetNumberString(frame.mData1, display_base, 8, str, len);
         }
         else
         {
@@ -61,24 +93,15 @@ void MapleBusAnalyzerResults::GenerateNumberStr(char* str, U32 len, const Frame&
             U32 data = static_cast<U32>(frame.mData1);
             for (U32 i = 0; i < 4; ++i, data = data >> 8)
             {
-                AnalyzerHelpers::GetNumberString(data & 0xFF, display_base, 8, number_strs[i], sizeof(number_strs[i]));
-            }
-            const char* format = NULL;
-            if (forExport)
-            {
-                format = "%s,%s,%s,%s";
-            }
-            else
-            {
-                format = "%s %s %s %s";
+                GetNumberString(data & 0xFF, display_base, 8, number_strs[i], sizeof(number_strs[i]));
             }
             if (mDataFormat == DataFormat::WORD_BYTES)
             {
-                snprintf(str, len, format, number_strs[0], number_strs[1], number_strs[2], number_strs[3]);
+                snprintf(str, len, "%s %s %s %s", number_strs[0], number_strs[1], number_strs[2], number_strs[3]);
             }
             else
             {
-                snprintf(str, len, format, number_strs[3], number_strs[2], number_strs[1], number_strs[0]);
+                snprintf(str, len, "%s %s %s %s", number_strs[3], number_strs[2], number_strs[1], number_strs[0]);
             }
         }
     }
@@ -131,15 +154,93 @@ void MapleBusAnalyzerResults::GenerateExtraInfoStr(char* str, U32 len, const Fra
     }
 }
 
+void MapleBusAnalyzerResults::GeneratePacketStr(char* str, U32 len, U64 packetIndex, U32 maxBytes, DisplayBase display_base) const
+{
+    std::vector<U8> bytes;
+    if (!mPacketStore.GetPacketBytes(packetIndex, bytes))
+    {
+        snprintf(str, len, "%s", (packetIndex < mPacketStore.GetNumPackets()) ? NOT_RETAINED_STR : "");
+        return;
+    }
+
+    U32 pos = 0;
+    str[0] = '\0';
+    for (U32 i = 0; i < bytes.size(); ++i)
+    {
+        char number_str[32];
+        GetNumberString(bytes[i], display_base, 8, number_str, sizeof(number_str));
+        U32 needed = static_cast<U32>(strlen(number_str)) + ((i > 0) ? 1 : 0);
+        // Always leave room for a separator, "..." and the terminator
+        if (i >= maxBytes || pos + needed + 5 > len)
+        {
+            snprintf(str + pos, len - pos, "%s...", (i > 0) ? " " : "");
+            return;
+        }
+        snprintf(str + pos, len - pos, "%s%s", (i > 0) ? " " : "", number_str);
+        pos += needed;
+    }
+}
+
+void MapleBusAnalyzerResults::GeneratePacketDescriptionStr(char* str, U32 len, U64 packetIndex) const
+{
+    MapleBusPacketRecord record;
+    MapleBusPacketInfo info;
+    if (!mPacketStore.GetPacket(packetIndex, record) || !mPacketStore.GetPacketInfo(packetIndex, info))
+    {
+        snprintf(str, len, "%s", (packetIndex < mPacketStore.GetNumPackets()) ? NOT_RETAINED_STR : "");
+        return;
+    }
+
+    char description_str[256];
+    MapleBusProtocol::GetDescription(info, description_str, sizeof(description_str));
+    snprintf(str, len, "%s%s", description_str, record.crcValid ? "" : " (bad CRC)");
+}
+
 void MapleBusAnalyzerResults::GenerateBubbleText(char* str, U32 len, U64 frame_index, DisplayBase display_base)
+{
+    // Frames never change once added, so their text only needs formatting once per display base; but the packets and
+    // errors they refer to may be dropped, and only ever oldest first, so the cache is invalidated whenever that happens
+    mBubbleTextCache.SetGeneration(mPacketStore.GetFirstPacketIndex() + mErrors.GetFirstErrorIndex());
+    if (mBubbleTextCache.Get(frame_index, display_base, str, len))
+    {
+        return;
+    }
+    FormatBubbleText(str, len, frame_index, display_base);
+    mBubbleTextCache.Add(frame_index, display_base, str);
+}
+
+void MapleBusAnalyzerResults::FormatBubbleText(char* str, U32 len, U64 frame_index, DisplayBase display_base)
 {
     Frame frame = GetFrame(frame_index);
 
+    if (frame.mType == FRAME_DATA_TYPE_ERROR)
+    {
+        MapleBusErrorRecord record;
+        if (!mErrors.GetError(frame.mData1, record))
+        {
+            snprintf(str, len, "%s", (frame.mData1 < mErrors.GetNumErrors()) ? NOT_RETAINED_STR : "");
+            return;
+        }
+        MapleBusErrorLog::GetDescription(record, str, len);
+        return;
+    }
+
+    const char* crc_error_str = ((frame.mFlags & DISPLAY_AS_ERROR_FLAG) != 0) ? " (bad CRC)" : "";
+
+    if (mDataFormat == DataFormat::PACKET)
+    {
+        // Keep room for the CRC error note at the end
+        U32 packet_len = len - static_cast<U32>(strlen(crc_error_str));
+        GeneratePacketStr(str, packet_len, frame.mData1, static_cast<U32>(frame.mData2), display_base);
+        strncat(str, crc_error_str, len - strlen(str) - 1);
+        return;
+    }
+
     char number_str[64];
-    GenerateNumberStr(number_str, sizeof(number_str), frame, display_base, false);
+    GenerateNumberStr(number_str, sizeof(number_str), frame, display_base);
     char extra_info_str[32];
     GenerateExtraInfoStr(extra_info_str, sizeof(extra_info_str), frame);
-    snprintf(str, len, "%s (%s)", number_str, extra_info_str);
+    snprintf(str, len, "%s (%s)%s", number_str, extra_info_str, crc_error_str);
 }
 
 void MapleBusAnalyzerResults::GenerateBubbleText(U64 frame_index, Channel& channel, DisplayBase display_base)
@@ -147,80 +248,395 @@ void MapleBusAnalyzerResults::GenerateBubbleText(U64 frame_index, Channel& chann
     char output_str[128];
     GenerateBubbleText(output_str, sizeof(output_str), frame_index, display_base);
     ClearResultStrings();
+    Frame frame = GetFrame(frame_index);
+    if (frame.mType == FRAME_DATA_TYPE_ERROR)
+    {
+        // Just the error type when zoomed out
+        MapleBusErrorRecord record;
+        if (mErrors.GetError(frame.mData1, record))
+        {
+            char type_str[32];
+            MapleBusErrorLog::GetTypeString(static_cast<MapleBusErrorType>(record.type), type_str, sizeof(type_str));
+            AddResultString(type_str);
+        }
+    }
+    else if (mDataFormat == DataFormat::PACKET)
+    {
+        // Just the command when zoomed out, then the whole description
+        MapleBusPacketInfo info;
+        if (mPacketStore.GetPacketInfo(frame.mData1, info))
+        {
+            char command_str[32];
+            MapleBusProtocol::GetCommandString(info.command, command_str, sizeof(command_str));
+            AddResultString(command_str);
+        }
+        char description_str[256];
+        GeneratePacketDescriptionStr(description_str, sizeof(description_str), frame.mData1);
+        AddResultString(description_str);
+    }
     AddResultString(output_str);
 }
 
-void MapleBusAnalyzerResults::GenerateExportFile(const char* file, DisplayBase display_base, U32 export_type_user_id)
+void MapleBusAnalyzerResults::AddExportNumber(MapleBusExportWriter& writer, U64 value, DisplayBase display_base, U32 numBits) const
+{
+    switch (display_base)
+    {
+    case Hexadecimal:
+        writer.AddHex(value, numBits);
+        break;
+
+    case Decimal:
+        writer.AddDecimal(value);
+        break;
+
+    default:
+    {
+        char number_str[128];
+        AnalyzerHelpers::GetNumberString(value, display_base, numBits, number_str, sizeof(number_str));
+        writer.AddString(number_str);
+    }
+    break;
+    }
+}
+
+void MapleBusAnalyzerResults::AddExportFrameData(MapleBusExportWriter& writer, const Frame& frame, DisplayBase display_base) const
+{
+    switch (mDataFormat)
+    {
+    default:
+    case DataFormat::BYTE:
+        AddExportNumber(writer, frame.mData1, display_base, 8);
+        break;
+
+    case DataFormat::WORD:
+        AddExportNumber(writer, frame.mData1, display_base, (frame.mType == FRAME_DATA_TYPE_CRC) ? 8 : 8 * 4);
+        break;
+
+    case DataFormat::WORD_BYTES:
+    case DataFormat::WORD_BYTES_LE:
+    {
+        if (frame.mType == FRAME_DATA_TYPE_CRC)
+        {
+            // CRC byte, keeping the columns of a word
+            AddExportNumber(writer, frame.mData1, display_base, 8);
+            writer.AddString(",,,", 3);
+        }
+        else
+        {
+            bool lsbFirst = (mDataFormat == DataFormat::WORD_BYTES);
+            for (U32 i = 0; i < 4; ++i)
+            {
+                U32 shift = lsbFirst ? (8 * i) : (8 * (3 - i));
+                if (i > 0)
+                {
+                    writer.AddChar(',');
+                }
+                AddExportNumber(writer, (frame.mData1 >> shift) & 0xFF, display_base, 8);
+            }
+        }
+    }
+    break;
+    }
+}
+
+void MapleBusAnalyzerResults::GeneratePacketFile(const char* file)
 {
-    std::ofstream file_stream(file, std::ios::out);
+    // Only the retained packets can be written
+    U64 first_packet = mPacketStore.GetFirstPacketIndex();
+    U64 num_packets = mPacketStore.GetNumPackets() - first_packet;
+    MapleBusPacketFileWriter writer;
+    if (!writer.Open(file, num_packets, mAnalyzer->GetSampleRate(), mAnalyzer->GetTriggerSample()))
+    {
+        return;
+    }
+
+    MapleBusPacketRecord record;
+    std::vector<U8> bytes;
+    for (U64 i = 0; i < num_packets; i++)
+    {
+        if (!mPacketStore.GetPacket(first_packet + i, record) || !mPacketStore.GetPacketBytes(first_packet + i, bytes))
+        {
+            // Dropped while exporting; Close() records how many were written
+            break;
+        }
+        writer.AddPacket(record, bytes);
+
+        if ((i % EXPORT_PROGRESS_INTERVAL) == 0 && UpdateExportProgressAndCheckForCancel(i, num_packets) == true)
+        {
+            return;
+        }
+    }
+
+    writer.Close();
+}
+
+void MapleBusAnalyzerResults::GenerateErrorStatsFile(const char* file)
+{
+    MapleBusExportWriter writer;
+    if (!writer.Open(file))
+    {
+        return;
+    }
 
     U64 trigger_sample = mAnalyzer->GetTriggerSample();
     U32 sample_rate = mAnalyzer->GetSampleRate();
+    char type_str[32];
+
+    writer.AddString("Error Type,Count\n");
+    for (U32 i = 0; i < MAPLE_BUS_NUM_ERROR_TYPES; ++i)
+    {
+        MapleBusErrorLog::GetTypeString(static_cast<MapleBusErrorType>(i), type_str, sizeof(type_str));
+        writer.AddString(type_str);
+        writer.AddChar(',');
+        writer.AddDecimal(mErrors.GetCount(static_cast<MapleBusErrorType>(i)));
+        writer.AddChar('\n');
+    }
+    writer.AddString("Samples Skipped,");
+    writer.AddDecimal(mErrors.GetNumSkippedSamples());
+    writer.AddString("\n\nTime [s],Resume Time [s],Error Type,Packet Start Time [s],Byte,Bit,Expected Edges,Observed Edges");
+
+    // The counts above cover every error, the records only those retained
+    U64 first_error = mErrors.GetFirstErrorIndex();
+    U64 num_errors = mErrors.GetNumErrors() - first_error;
+    MapleBusErrorRecord record;
+    for (U64 i = 0; i < num_errors; ++i)
+    {
+        if (!mErrors.GetError(first_error + i, record))
+        {
+            break;
+        }
+        MapleBusErrorLog::GetTypeString(static_cast<MapleBusErrorType>(record.type), type_str, sizeof(type_str));
+        writer.AddChar('\n');
+        writer.AddTime(record.sample, trigger_sample, sample_rate);
+        writer.AddChar(',');
+        writer.AddTime(record.resumeSample, trigger_sample, sample_rate);
+        writer.AddChar(',');
+        writer.AddString(type_str);
+        writer.AddChar(',');
+        writer.AddTime(record.startSample, trigger_sample, sample_rate);
+        writer.AddChar(',');
+        writer.AddDecimal(record.byteIndex);
+        writer.AddChar(',');
+        writer.AddDecimal(record.bitIndex);
+        writer.AddChar(',');
+        writer.AddDecimal(record.expectedEdges);
+        writer.AddChar(',');
+        writer.AddDecimal(record.observedEdges);
+
+        if ((i % EXPORT_PROGRESS_INTERVAL) == 0 && UpdateExportProgressAndCheckForCancel(i, num_errors) == true)
+        {
+            return;
+        }
+    }
+
+    writer.Close();
+}
+
+void MapleBusAnalyzerResults::AddExportPacket(MapleBusExportWriter& writer, const Frame& frame, DisplayBase display_base,
+                                              std::vector<U8>& bytes) const
+{
+    // Interpreted fields first; none of them hold a comma
+    MapleBusPacketInfo info;
+    if (!mPacketStore.GetPacketInfo(frame.mData1, info) || !mPacketStore.GetPacketBytes(frame.mData1, bytes))
+    {
+        writer.AddString(NOT_RETAINED_STR);
+        return;
+    }
+    char command_str[32];
+    char sender_str[16];
+    char recipient_str[16];
+    MapleBusProtocol::GetCommandString(info.command, command_str, sizeof(command_str));
+    MapleBusProtocol::GetAddressString(info.sender, sender_str, sizeof(sender_str));
+    MapleBusProtocol::GetAddressString(info.recipient, recipient_str, sizeof(recipient_str));
+    writer.AddString(command_str);
+    writer.AddChar(',');
+    writer.AddString(sender_str);
+    writer.AddChar(',');
+    writer.AddString(recipient_str);
+    writer.AddChar(',');
+    if (info.hasFunction)
+    {
+        char function_str[128];
+        MapleBusProtocol::GetFunctionString(info.function, function_str, sizeof(function_str));
+        writer.AddString(function_str);
+    }
+    writer.AddChar(',');
+
+    for (U32 i = 0; i < bytes.size(); ++i)
+    {
+        if (i > 0)
+        {
+            writer.AddChar(',');
+        }
+        AddExportNumber(writer, bytes[i], display_base, 8);
+    }
+    if ((frame.mFlags & DISPLAY_AS_ERROR_FLAG) != 0)
+    {
+        writer.AddString(",bad CRC", 8);
+    }
+}
 
-    file_stream << "Time [s],";
+void MapleBusAnalyzerResults::GenerateExportFile(const char* file, DisplayBase display_base, U32 export_type_user_id)
+{
+    if (export_type_user_id == MapleBusAnalyzerSettings::EXPORT_TYPE_PACKET_FILE)
+    {
+        GeneratePacketFile(file);
+        return;
+    }
+    else if (export_type_user_id == MapleBusAnalyzerSettings::EXPORT_TYPE_ERROR_STATS)
+    {
+        GenerateErrorStatsFile(file);
+        return;
+    }
+
+    MapleBusExportWriter writer;
+    if (!writer.Open(file))
+    {
+        return;
+    }
+
+    writer.AddString("Time [s],");
 
     switch (mDataFormat)
     {
     default:
     case DataFormat::BYTE:
-        file_stream << "Num Words, Sender Addr, Recipient Addr, Command, Data & CRC ->";
+        writer.AddString("Num Words, Sender Addr, Recipient Addr, Command, Data & CRC ->");
         break;
 
     case DataFormat::WORD:
-        file_stream << "Frame Word (little endian), Data & CRC ->";
+        writer.AddString("Frame Word (little endian), Data & CRC ->");
         break;
 
     case DataFormat::WORD_BYTES:
-        file_stream << "Num Words, Sender Addr, Recipient Addr, Command, Data & CRC ->";
+        writer.AddString("Num Words, Sender Addr, Recipient Addr, Command, Data & CRC ->");
+        break;
+
+    case DataFormat::PACKET:
+        writer.AddString("Command Name, Sender, Recipient, Function, Num Words, Sender Addr, Recipient Addr, Command, Data & CRC ->");
         break;
 
     case DataFormat::WORD_BYTES_LE:
-        file_stream << "Command, Recipient Addr, Sender Addr, Num Words, Data (little endian) & CRC ->";
+        writer.AddString("Command, Recipient Addr, Sender Addr, Num Words, Data (little endian) & CRC ->");
         break;
     }
 
-    U64 num_frames = GetNumFrames();
-    U32 previousNumItemsLeft = 0;
-    U8 previousWordType = FRAME_DATA_TYPE_NONE;
-    for (U32 i = 0; i < num_frames; i++)
-    {
-        Frame frame = GetFrame(i);
+    // Hex and decimal are formatted by the writer on any thread; the SDK's number formatting isn't documented as
+    // thread safe, so other bases are formatted by a single worker
+    MapleBusExportPipeline pipeline((display_base == Hexadecimal || display_base == Decimal) ? 0 : 1);
+    mExportBlocks.resize(pipeline.GetNumSlots());
+    mExportNumFrames = GetNumFrames();
+    mExportDisplayBase = display_base;
+    mExportTriggerSample = mAnalyzer->GetTriggerSample();
+    mExportSampleRate = mAnalyzer->GetSampleRate();
+    mExportPreviousNumItemsLeft = 0;
+    mExportPreviousWordType = FRAME_DATA_TYPE_NONE;
+
+    U64 num_blocks = (mExportNumFrames + EXPORT_BLOCK_FRAMES - 1) / EXPORT_BLOCK_FRAMES;
+    pipeline.Run(this, num_blocks, writer);
+    std::vector<ExportBlock>().swap(mExportBlocks);
+    writer.Close();
+}
 
-        char time_str[128];
-        AnalyzerHelpers::GetTimeString(frame.mStartingSampleInclusive, trigger_sample, sample_rate, time_str, 128);
+void MapleBusAnalyzerResults::PrepareBlock(U64 blockIndex, U32 slot)
+{
+    ExportBlock& block = mExportBlocks[slot];
+    U64 first_frame = blockIndex * EXPORT_BLOCK_FRAMES;
+    U64 num_frames = mExportNumFrames - first_frame;
+    num_frames = (num_frames < EXPORT_BLOCK_FRAMES) ? num_frames : EXPORT_BLOCK_FRAMES;
+    block.frames.resize(static_cast<size_t>(num_frames));
+    block.lineStarts.resize(static_cast<size_t>(num_frames));
+
+    for (U32 i = 0; i < num_frames; ++i)
+    {
+        Frame& frame = block.frames[i];
+        frame = GetFrame(first_frame + i);
 
-        char number_str[64];
-        GenerateNumberStr(number_str, sizeof(number_str), frame, display_base, true);
+        // Each packet and error frame is a line; otherwise a line starts wherever a frame doesn't continue the last one's
+        // packet
         U32 numItemsLeft = static_cast<U32>(frame.mData2);
+        block.lineStarts[i] = (mDataFormat == DataFormat::PACKET || first_frame + i == 0 || frame.mType == FRAME_DATA_TYPE_ERROR ||
+                               mExportPreviousWordType == FRAME_DATA_TYPE_ERROR ||
+                               (numItemsLeft > 0 && mExportPreviousNumItemsLeft == 0) ||
+                               (mExportPreviousNumItemsLeft > 0 && mExportPreviousNumItemsLeft - 1 != numItemsLeft) ||
+                               (mExportPreviousWordType == FRAME_DATA_TYPE_CRC && frame.mType != FRAME_DATA_TYPE_CRC));
+        mExportPreviousNumItemsLeft = numItemsLeft;
+        mExportPreviousWordType = frame.mType;
+    }
+}
 
-        if (i == 0 || (numItemsLeft > 0 && previousNumItemsLeft == 0) ||
-            (previousNumItemsLeft > 0 && previousNumItemsLeft - 1 != numItemsLeft) ||
-            (previousWordType == FRAME_DATA_TYPE_CRC && frame.mType != FRAME_DATA_TYPE_CRC))
+void MapleBusAnalyzerResults::FormatBlock(U32 slot, MapleBusExportWriter& text)
+{
+    const ExportBlock& block = mExportBlocks[slot];
+    std::vector<U8> bytes;
+    MapleBusErrorRecord record;
+    for (size_t i = 0; i < block.frames.size(); ++i)
+    {
+        const Frame& frame = block.frames[i];
+        if (block.lineStarts[i])
         {
-            file_stream << std::endl << time_str << ",";
+            text.AddChar('\n');
+            text.AddTime(frame.mStartingSampleInclusive, mExportTriggerSample, mExportSampleRate);
+            text.AddChar(',');
         }
-        previousNumItemsLeft = numItemsLeft;
-        previousWordType = frame.mType;
-
-        file_stream << number_str << ",";
 
-        if (UpdateExportProgressAndCheckForCancel(i, num_frames) == true)
+        if (frame.mType == FRAME_DATA_TYPE_ERROR)
         {
-            file_stream.close();
-            return;
+            if (mErrors.GetError(frame.mData1, record))
+            {
+                char description_str[128];
+                MapleBusErrorLog::GetDescription(record, description_str, sizeof(description_str));
+                text.AddString(description_str);
+            }
+            else
+            {
+                text.AddString(NOT_RETAINED_STR);
+            }
+        }
+        else if (mDataFormat == DataFormat::PACKET)
+        {
+            AddExportPacket(text, frame, mExportDisplayBase, bytes);
+        }
+        else
+        {
+            AddExportFrameData(text, frame, mExportDisplayBase);
+            text.AddChar(',');
+            if ((frame.mFlags & DISPLAY_AS_ERROR_FLAG) != 0)
+            {
+                text.AddString("bad CRC,", 8);
+            }
         }
     }
+}
 
-    file_stream.close();
+bool MapleBusAnalyzerResults::OnBlockWritten(U64 numBlocksWritten)
+{
+    U64 num_frames_written = numBlocksWritten * EXPORT_BLOCK_FRAMES;
+    num_frames_written = (num_frames_written < mExportNumFrames) ? num_frames_written : mExportNumFrames;
+    return UpdateExportProgressAndCheckForCancel(num_frames_written, mExportNumFrames);
 }
 
 void MapleBusAnalyzerResults::GenerateFrameTabularText(U64 frame_index, DisplayBase display_base)
 {
 #ifdef SUPPORTS_PROTOCOL_SEARCH
-    Frame frame = GetFrame(frame_index);
     ClearTabularText();
 
-    // Use the same value generated for bubble text
+    // Search describes each packet on its first frame, so that its fields may be searched for
+    Frame frame = GetFrame(frame_index);
+    MapleBusPacketIndexEntry entry;
+    U64 packet_index = frame.mData2 >> 32;
+    bool is_retained = (packet_index >= mPacketIndex.GetFirstPacketIndex());
+    if ((frame.mFlags & FRAME_FLAG_PACKET_START) != 0 && is_retained && mPacketIndex.GetEntry(packet_index, entry))
+    {
+        char description_str[256];
+        GeneratePacketDescriptionStr(description_str, sizeof(description_str), packet_index);
+        char output_str[320];
+        snprintf(output_str, sizeof(output_str), "%s, %u words", description_str, entry.numWords);
+        AddTabularText(output_str);
+        return;
+    }
+
+    // Every other frame is listed as shown in bubble text, so that no row is left empty
     char output_str[128];
     GenerateBubbleText(output_str, sizeof(output_str), frame_index, display_base);
     AddTabularText(output_str);
@@ -229,10 +645,113 @@ void MapleBusAnalyzerResults::GenerateFrameTabularText(U64 frame_index, DisplayB
 
 void MapleBusAnalyzerResults::GeneratePacketTabularText(U64 packet_id, DisplayBase display_base)
 {
-    // not supported
+    // Packet IDs match packet store indices (see MapleBusAnalyzer::OnPacketEnd())
+    char description_str[256];
+    GeneratePacketDescriptionStr(description_str, sizeof(description_str), packet_id);
+    ClearResultStrings();
+    MapleBusPacketRecord record;
+    char timing_str[160];
+    timing_str[0] = '\0';
+    if (mPacketStore.GetPacket(packet_id, record))
+    {
+        GenerateBitTimingStr(timing_str, sizeof(timing_str), record.timing);
+    }
+    if (timing_str[0] != '\0')
+    {
+        char packet_str[448];
+        snprintf(packet_str, sizeof(packet_str), "%s; %s", description_str, timing_str);
+        AddResultString(packet_str);
+    }
+    else
+    {
+        AddResultString(description_str);
+    }
 }
 
 void MapleBusAnalyzerResults::GenerateTransactionTabularText(U64 transaction_id, DisplayBase display_base)
 {
-    // not supported
-}
\ No newline at end of file
+    ClearResultStrings();
+    MapleBusTransactionRecord record;
+    if (!mTransactions.GetTransaction(transaction_id, record))
+    {
+        return;
+    }
+
+    char command_str[256];
+    GeneratePacketDescriptionStr(command_str, sizeof(command_str), record.id);
+    char command_duration_str[32];
+    GenerateDurationStr(command_duration_str, sizeof(command_duration_str), record.commandEndSample - record.commandStartSample);
+
+    char transaction_str[768];
+    if (record.hasResponse)
+    {
+        char response_str[256];
+        GeneratePacketDescriptionStr(response_str, sizeof(response_str), record.responseIndex);
+        char response_duration_str[32];
+        GenerateDurationStr(response_duration_str, sizeof(response_duration_str),
+                            record.responseEndSample - record.responseStartSample);
+        char turnaround_str[32];
+        GenerateDurationStr(turnaround_str, sizeof(turnaround_str), record.GetTurnaroundSamples());
+        snprintf(transaction_str, sizeof(transaction_str), "%s (%s); %s (%s); turnaround %s, utilization %.0f%%", command_str,
+                 command_duration_str, response_str, response_duration_str, turnaround_str, record.GetUtilization() * 100);
+    }
+    else
+    {
+        snprintf(transaction_str, sizeof(transaction_str), "%s (%s)%s", command_str, command_duration_str,
+                 record.isCommand ? "; no response" : "");
+    }
+    AddResultString(transaction_str);
+}
+
+void MapleBusAnalyzerResults::GenerateBitTimingStr(char* str, U32 len, const MapleBusBitTiming& timing) const
+{
+    if (timing.numPeriods == 0)
+    {
+        str[0] = '\0';
+        return;
+    }
+
+    char setup_str[48];
+    setup_str[0] = '\0';
+    char tolerance_str[48];
+    tolerance_str[0] = '\0';
+    if (timing.numOutOfTolerance > 0)
+    {
+        snprintf(tolerance_str, sizeof(tolerance_str), ", %u bits out of tolerance", timing.numOutOfTolerance);
+    }
+    U32 sample_rate = mAnalyzer->GetSampleRate();
+    if (sample_rate > 0)
+    {
+        double us_per_sample = 1000000.0 / sample_rate;
+        if (timing.minSetup != MapleBusBitTiming::NO_SETUP)
+        {
+            snprintf(setup_str, sizeof(setup_str), ", setup %.3f us", timing.minSetup * us_per_sample);
+        }
+        snprintf(str, len, "%.3f Mbit/s, bit period %.3f/%.3f/%.3f us, jitter %.3f us%s%s",
+                 sample_rate / timing.GetMeanPeriod() / 1000000.0, timing.minPeriod * us_per_sample,
+                 timing.GetMeanPeriod() * us_per_sample, timing.maxPeriod * us_per_sample, timing.GetJitter() * us_per_sample,
+                 setup_str, tolerance_str);
+    }
+    else
+    {
+        if (timing.minSetup != MapleBusBitTiming::NO_SETUP)
+        {
+            snprintf(setup_str, sizeof(setup_str), ", setup %u samples", timing.minSetup);
+        }
+        snprintf(str, len, "bit period %u/%.1f/%u samples, jitter %.1f samples%s%s", timing.minPeriod, timing.GetMeanPeriod(),
+                 timing.maxPeriod, timing.GetJitter(), setup_str, tolerance_str);
+    }
+}
+
+void MapleBusAnalyzerResults::GenerateDurationStr(char* str, U32 len, U64 numSamples) const
+{
+    U32 sample_rate = mAnalyzer->GetSampleRate();
+    if (sample_rate > 0)
+    {
+        snprintf(str, len, "%.3f us", numSamples * 1000000.0 / sample_rate);
+    }
+    else
+    {
+        snprintf(str, len, "%llu samples", numSamples);
+    }
+}
@@ -2,11 +2,19 @@
 #define MAPLEBUS_ANALYZER_RESULTS
 
 #include <AnalyzerResults.h>
+#include "MapleBusExportPipeline.h"
+#include "MapleBusErrorLog.h"
+#include "MapleBusExportWriter.h"
+#include "MapleBusPacketFile.h"
+#include "MapleBusPacketIndex.h"
+#include "MapleBusPacketStore.h"
+#include "MapleBusTextCache.h"
+#include "MapleBusTransactionTracker.h"
 
 class MapleBusAnalyzer;
 class MapleBusAnalyzerSettings;
 
-class MapleBusAnalyzerResults : public AnalyzerResults
+class MapleBusAnalyzerResults : public AnalyzerResults, private MapleBusExportBlockFormatter
 {
   public:
     //! Determines how to handle Frame::mData1
@@ -23,7 +31,10 @@ class MapleBusAnalyzerResults : public AnalyzerResults
         WORD_BYTES,
         //! Expect each frame is a 32-bit word in little endian order except 8-bit CRC codes.
         //! Each word is processed in order and such that the MSB is printed first.
-        WORD_BYTES_LE
+        WORD_BYTES_LE,
+        //! Expect each frame is a whole packet where Frame::mData1 is the packet's index within mPacketStore.
+        //! Bytes are printed in the order they are received.
+        PACKET
     };
 
     //! Data type for the data in a result frame (Frame::mType values)
@@ -36,9 +47,24 @@ class MapleBusAnalyzerResults : public AnalyzerResults
         //! Data within the frame is Maple Bus frame data
         FRAME_DATA_TYPE_FRAME,
         //! Data within the frame is a CRC byte
-        FRAME_DATA_TYPE_CRC
+        FRAME_DATA_TYPE_CRC,
+        //! The frame spans a whole packet
+        FRAME_DATA_TYPE_PACKET,
+        //! The frame spans what was skipped after a decode failure; Frame::mData1 is the error's index within mErrors
+        FRAME_DATA_TYPE_ERROR
     };
 
+    //! Flags of a result frame, besides the SDK's display flags (Frame::mFlags bits)
+    enum FrameFlag
+    {
+        //! The frame is the first of a stored packet; the upper 32 bits of Frame::mData2 hold the packet's store index,
+        //! while the lower 32 bits keep the count of items left. Only set for packet indices up to MAX_FRAME_PACKET_INDEX
+        FRAME_FLAG_PACKET_START = 0x01
+    };
+
+    //! Largest packet index a frame can carry (see FRAME_FLAG_PACKET_START)
+    static const U64 MAX_FRAME_PACKET_INDEX = 0xFFFFFFFF;
+
     //! Constructor
     MapleBusAnalyzerResults(MapleBusAnalyzer* analyzer, MapleBusAnalyzerSettings* settings, DataFormat type);
     //! Destructor
@@ -55,29 +81,117 @@ class MapleBusAnalyzerResults : public AnalyzerResults
 
     //! Determines how this object will handle Frame::mData1
     const DataFormat mDataFormat;
+    //! All packets decoded so far
+    MapleBusPacketStore mPacketStore;
+    //! The start and searchable fields of every stored packet, at the same indices as mPacketStore
+    MapleBusPacketIndex mPacketIndex;
+    //! Host commands paired with device responses, identified by the index of their first packet
+    MapleBusTransactionTracker mTransactions;
+    //! Every decode failure so far along with counts of each error type
+    MapleBusErrorLog mErrors;
 
   protected: // functions
-    //! Generate bubble text into given string
+    //! Generate bubble text into given string, from the cache if it was generated before
     void GenerateBubbleText(char* str, U32 len, U64 frame_index, DisplayBase display_base);
-    //! Generates the number string for bubble text and export file
+    //! Formats bubble text into given string
+    void FormatBubbleText(char* str, U32 len, U64 frame_index, DisplayBase display_base);
+    //! Generates the number string for bubble text
     //! @param[out] str  output string buffer
     //! @param[in] len  byte length of str
     //! @param[in] frame  frame from which contains the data to generate data
     //! @param[in] display_base  contains string formatting information
-    //! @param[in] forExport  true iff the string is being generated for export;
-    //!                       this will add comma separation to byte values when true
-    void GenerateNumberStr(char* str, U32 len, const Frame& frame, DisplayBase display_base, bool forExport) const;
+    void GenerateNumberStr(char* str, U32 len, const Frame& frame, DisplayBase display_base) const;
     //! Generate extra information about a frame for bubble text
     //! @param[out] str  output string buffer
     //! @param[in] len  byte length of str
     //! @param[in] frame  frame from which contains the data to generate data
     void GenerateExtraInfoStr(char* str, U32 len, const Frame& frame) const;
+    //! Generates the bytes of a stored packet for bubble text
+    //! @param[out] str  output string buffer; ends with "..." if too short to hold every byte
+    //! @param[in] len  byte length of str
+    //! @param[in] packetIndex  index of the packet within mPacketStore
+    //! @param[in] maxBytes  the maximum number of bytes to print
+    //! @param[in] display_base  contains string formatting information
+    void GeneratePacketStr(char* str, U32 len, U64 packetIndex, U32 maxBytes, DisplayBase display_base) const;
+    //! Generates the protocol level description of a stored packet, noting a bad CRC
+    //! @param[out] str  output string buffer
+    //! @param[in] len  byte length of str
+    //! @param[in] packetIndex  index of the packet within mPacketStore
+    void GeneratePacketDescriptionStr(char* str, U32 len, U64 packetIndex) const;
+    //! Generates the bit rate, bit period, jitter and shortest setup time of a packet
+    //! @param[out] str  output string buffer; empty if no bit period was measured
+    //! @param[in] len  byte length of str
+    //! @param[in] timing  the packet's bit timing
+    void GenerateBitTimingStr(char* str, U32 len, const MapleBusBitTiming& timing) const;
+    //! Generates a duration in microseconds
+    //! @param[out] str  output string buffer
+    //! @param[in] len  byte length of str
+    //! @param[in] numSamples  the duration in samples
+    void GenerateDurationStr(char* str, U32 len, U64 numSamples) const;
+    //! Exports every stored packet to a columnar binary packet file, whatever the output style
+    //! @param[in] file  the file path to write
+    void GeneratePacketFile(const char* file);
+    //! Exports the count of each error type followed by every stored error to a csv file, whatever the output style
+    //! @param[in] file  the file path to write
+    void GenerateErrorStatsFile(const char* file);
+    //! Adds a number to an export file; hex and decimal are formatted by the writer, other bases by the SDK
+    //! @param[in] writer  the export file
+    //! @param[in] value  the value to add
+    //! @param[in] display_base  contains string formatting information
+    //! @param[in] numBits  the number of bits the value holds
+    void AddExportNumber(MapleBusExportWriter& writer, U64 value, DisplayBase display_base, U32 numBits) const;
+    //! Adds the data of a byte or word frame to an export file, comma separating bytes of a word
+    //! @param[in] writer  the export file
+    //! @param[in] frame  frame from which contains the data to add
+    //! @param[in] display_base  contains string formatting information
+    void AddExportFrameData(MapleBusExportWriter& writer, const Frame& frame, DisplayBase display_base) const;
+    //! Adds the interpreted fields and bytes of a packet frame to an export file
+    //! @param[in] writer  the export file
+    //! @param[in] frame  the packet frame
+    //! @param[in] display_base  contains string formatting information
+    //! @param[in] bytes  scratch space for the packet's bytes, reused between packets
+    void AddExportPacket(MapleBusExportWriter& writer, const Frame& frame, DisplayBase display_base, std::vector<U8>& bytes) const;
+
+  private: // MapleBusExportBlockFormatter
+    virtual void PrepareBlock(U64 blockIndex, U32 slot);
+    virtual void FormatBlock(U32 slot, MapleBusExportWriter& text);
+    virtual bool OnBlockWritten(U64 numBlocksWritten);
 
   protected: // vars
+    //! Number of frames exported between progress updates of the packet file export
+    static const U64 EXPORT_PROGRESS_INTERVAL = 1024;
+    //! Number of frames in each block of the text export
+    static const U64 EXPORT_BLOCK_FRAMES = 16384;
+
     //! Pointer to my input settings
     MapleBusAnalyzerSettings* mSettings;
     //! Pointer back to the analyzer that made me
     MapleBusAnalyzer* mAnalyzer;
+
+    //! Frames of one block of the text export, fetched in order and formatted on a worker thread
+    struct ExportBlock
+    {
+        //! The frames of the block
+        std::vector<Frame> frames;
+        //! Whether each frame begins a new line
+        std::vector<bool> lineStarts;
+    };
+    //! Blocks being exported, one per pipeline slot
+    std::vector<ExportBlock> mExportBlocks;
+    //! Number of frames being exported
+    U64 mExportNumFrames;
+    //! Number base of the export
+    DisplayBase mExportDisplayBase;
+    //! Trigger sample for export times
+    U64 mExportTriggerSample;
+    //! Sample rate for export times
+    U32 mExportSampleRate;
+    //! Number of items left after the last frame prepared for export
+    U32 mExportPreviousNumItemsLeft;
+    //! Data type of the last frame prepared for export
+    U8 mExportPreviousWordType;
+    //! Bubble text of recently viewed frames, keyed by frame index and display base
+    MapleBusTextCache mBubbleTextCache;
 };
 
 #endif // MAPLEBUS_ANALYZER_RESULTS
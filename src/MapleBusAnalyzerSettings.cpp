@@ -3,7 +3,21 @@
 
 
 MapleBusAnalyzerSettings::MapleBusAnalyzerSettings()
-    : mInputChannelA(UNDEFINED_CHANNEL), mInputChannelB(UNDEFINED_CHANNEL), mOutputStyle(OUTPUT_STYLE_WORD_BYTES_LE)
+    : mInputChannelA(UNDEFINED_CHANNEL), mInputChannelB(UNDEFINED_CHANNEL), mOutputStyle(OUTPUT_STYLE_WORD_BYTES_LE),
+      mBitMarkers(BIT_MARKERS_ALL),
+      mCommitResults(COMMIT_RESULTS_BATCHED),
+      mCommitBatchFrames(1000),
+      mCommitBatchMilliseconds(100),
+      mBusBitRateKbps(2000),
+      mTimingCheck(TIMING_CHECK_OFF),
+      mTimingTolerancePercent(50),
+      mGlitchFilterANs(0),
+      mGlitchFilterBNs(0),
+      mRetainedPackets(100000),
+      mPacketStreamPath(),
+      mSimulationTraffic(SIMULATION_TRAFFIC_MIXED),
+      mSimulationBitRateKbps(2000),
+      mSimulationGapMicroseconds(50)
 {
     mInputChannelAInterface.reset(new AnalyzerSettingInterfaceChannel());
     mInputChannelAInterface->SetTitleAndTooltip("SDCKA", "Serial Data and Clock Line A");
@@ -20,15 +34,135 @@ MapleBusAnalyzerSettings::MapleBusAnalyzerSettings()
     mOutputStyleInterface->AddNumber(OUTPUT_STYLE_WORD_BYTES, "Word Bytes", "Show bytes, grouped by word");
     mOutputStyleInterface->AddNumber(OUTPUT_STYLE_WORD_BYTES_LE, "Word Bytes (little endian)",
                                      "Show bytes, grouped by word, little endian sorted");
+    mOutputStyleInterface->AddNumber(OUTPUT_STYLE_EACH_PACKET, "Each Packet",
+                                     "Show all bytes of each packet in a single frame; uses the least memory");
     mOutputStyleInterface->SetNumber(mOutputStyle);
 
+    mBitMarkersInterface.reset(new AnalyzerSettingInterfaceNumberList());
+    mBitMarkersInterface->SetTitleAndTooltip("Bit Markers", "Where to place a marker at each sampled bit");
+    mBitMarkersInterface->AddNumber(BIT_MARKERS_ALL, "All Bits", "Mark every sampled bit");
+    mBitMarkersInterface->AddNumber(BIT_MARKERS_NONE, "None", "Don't mark bits; uses the least memory");
+    mBitMarkersInterface->AddNumber(BIT_MARKERS_ERRORS_ONLY, "Errors Only", "Only mark the bits of packets which failed to decode");
+    mBitMarkersInterface->SetNumber(mBitMarkers);
+
+    mCommitResultsInterface.reset(new AnalyzerSettingInterfaceNumberList());
+    mCommitResultsInterface->SetTitleAndTooltip("Commit Results", "How often decoded results are handed to the display");
+    mCommitResultsInterface->AddNumber(COMMIT_RESULTS_EACH_FRAME, "Each Frame", "Commit after every frame");
+    mCommitResultsInterface->AddNumber(COMMIT_RESULTS_EACH_PACKET, "Each Packet", "Commit at the end of every packet");
+    mCommitResultsInterface->AddNumber(COMMIT_RESULTS_BATCHED, "Batched",
+                                       "Commit once the batch frame count or batch interval below is reached");
+    mCommitResultsInterface->SetNumber(mCommitResults);
+
+    mCommitBatchFramesInterface.reset(new AnalyzerSettingInterfaceInteger());
+    mCommitBatchFramesInterface->SetTitleAndTooltip("Commit Batch Frames", "Batched: the most frames held back before a commit");
+    mCommitBatchFramesInterface->SetMin(1);
+    mCommitBatchFramesInterface->SetMax(1000000);
+    mCommitBatchFramesInterface->SetInteger(mCommitBatchFrames);
+
+    mCommitBatchMillisecondsInterface.reset(new AnalyzerSettingInterfaceInteger());
+    mCommitBatchMillisecondsInterface->SetTitleAndTooltip("Commit Batch Interval (ms)",
+                                                          "Batched: the longest time results are held back before a commit");
+    mCommitBatchMillisecondsInterface->SetMin(1);
+    mCommitBatchMillisecondsInterface->SetMax(10000);
+    mCommitBatchMillisecondsInterface->SetInteger(mCommitBatchMilliseconds);
+
+    mBusBitRateInterface.reset(new AnalyzerSettingInterfaceInteger());
+    mBusBitRateInterface->SetTitleAndTooltip("Bus Bit Rate (kbps)",
+                                             "The fastest bit rate expected on the bus; the minimum sample rate is 4 samples per bit");
+    mBusBitRateInterface->SetMin(1);
+    mBusBitRateInterface->SetMax(100000);
+    mBusBitRateInterface->SetInteger(mBusBitRateKbps);
+
+    mTimingCheckInterface.reset(new AnalyzerSettingInterfaceNumberList());
+    mTimingCheckInterface->SetTitleAndTooltip("Bit Timing Check",
+                                              "Check each bit period against the nominal bit period of the packet's start sequence");
+    mTimingCheckInterface->AddNumber(TIMING_CHECK_OFF, "Off", "Don't check bit periods");
+    mTimingCheckInterface->AddNumber(TIMING_CHECK_FLAG, "Flag", "Count bits outside tolerance in the packet's timing and error statistics");
+    mTimingCheckInterface->AddNumber(TIMING_CHECK_REJECT, "Reject", "Fail the packet at the first bit outside tolerance");
+    mTimingCheckInterface->SetNumber(mTimingCheck);
+
+    mTimingToleranceInterface.reset(new AnalyzerSettingInterfaceInteger());
+    mTimingToleranceInterface->SetTitleAndTooltip("Bit Timing Tolerance (%)",
+                                                  "Bit timing check: how far a bit period may be from nominal, plus one sample");
+    mTimingToleranceInterface->SetMin(0);
+    mTimingToleranceInterface->SetMax(1000);
+    mTimingToleranceInterface->SetInteger(mTimingTolerancePercent);
+
+    mGlitchFilterAInterface.reset(new AnalyzerSettingInterfaceInteger());
+    mGlitchFilterAInterface->SetTitleAndTooltip("SDCKA Glitch Filter (ns)",
+                                                "Remove pulses on SDCKA shorter than this while decoding; 0 keeps every pulse");
+    mGlitchFilterAInterface->SetMin(0);
+    mGlitchFilterAInterface->SetMax(100000);
+    mGlitchFilterAInterface->SetInteger(mGlitchFilterANs);
+
+    mGlitchFilterBInterface.reset(new AnalyzerSettingInterfaceInteger());
+    mGlitchFilterBInterface->SetTitleAndTooltip("SDCKB Glitch Filter (ns)",
+                                                "Remove pulses on SDCKB shorter than this while decoding; 0 keeps every pulse");
+    mGlitchFilterBInterface->SetMin(0);
+    mGlitchFilterBInterface->SetMax(100000);
+    mGlitchFilterBInterface->SetInteger(mGlitchFilterBNs);
+
+    mRetainedPacketsInterface.reset(new AnalyzerSettingInterfaceInteger());
+    mRetainedPacketsInterface->SetTitleAndTooltip("Retained Packets",
+                                                  "Keep at least this many recent packets for display and export, dropping older "
+                                                  "ones; 0 keeps all. Logic's own frames and markers are never dropped");
+    mRetainedPacketsInterface->SetMin(0);
+    mRetainedPacketsInterface->SetMax(100000000);
+    mRetainedPacketsInterface->SetInteger(mRetainedPackets);
+
+    mPacketStreamInterface.reset(new AnalyzerSettingInterfaceText());
+    mPacketStreamInterface->SetTitleAndTooltip("Packet Stream File",
+                                               "Write each packet to this file or named pipe as it is decoded; empty for none");
+    mPacketStreamInterface->SetTextType(AnalyzerSettingInterfaceText::FilePath);
+    mPacketStreamInterface->SetText(mPacketStreamPath.c_str());
+
+    mSimulationTrafficInterface.reset(new AnalyzerSettingInterfaceNumberList());
+    mSimulationTrafficInterface->SetTitleAndTooltip("Simulation Traffic", "Which packets the simulation data generator sends");
+    mSimulationTrafficInterface->AddNumber(SIMULATION_TRAFFIC_CONTROLLER, "Controller Polls",
+                                           "Controller condition polls and responses only");
+    mSimulationTrafficInterface->AddNumber(SIMULATION_TRAFFIC_MIXED, "Mixed",
+                                           "Mostly condition polls with some device info requests and VMU block reads and writes");
+    mSimulationTrafficInterface->AddNumber(SIMULATION_TRAFFIC_STORAGE, "VMU Transfers", "VMU block reads and writes only");
+    mSimulationTrafficInterface->SetNumber(mSimulationTraffic);
+
+    mSimulationBitRateInterface.reset(new AnalyzerSettingInterfaceInteger());
+    mSimulationBitRateInterface->SetTitleAndTooltip("Simulation Bit Rate (kbps)",
+                                                    "Simulation: the bit rate; limited to a third of the sample rate");
+    mSimulationBitRateInterface->SetMin(1);
+    mSimulationBitRateInterface->SetMax(100000);
+    mSimulationBitRateInterface->SetInteger(mSimulationBitRateKbps);
+
+    mSimulationGapInterface.reset(new AnalyzerSettingInterfaceInteger());
+    mSimulationGapInterface->SetTitleAndTooltip("Simulation Packet Gap (us)", "Simulation: the idle time after each packet");
+    mSimulationGapInterface->SetMin(0);
+    mSimulationGapInterface->SetMax(1000000);
+    mSimulationGapInterface->SetInteger(mSimulationGapMicroseconds);
+
     AddInterface(mInputChannelAInterface.get());
     AddInterface(mInputChannelBInterface.get());
     AddInterface(mOutputStyleInterface.get());
+    AddInterface(mBitMarkersInterface.get());
+    AddInterface(mCommitResultsInterface.get());
+    AddInterface(mCommitBatchFramesInterface.get());
+    AddInterface(mCommitBatchMillisecondsInterface.get());
+    AddInterface(mBusBitRateInterface.get());
+    AddInterface(mTimingCheckInterface.get());
+    AddInterface(mTimingToleranceInterface.get());
+    AddInterface(mGlitchFilterAInterface.get());
+    AddInterface(mGlitchFilterBInterface.get());
+    AddInterface(mRetainedPacketsInterface.get());
+    AddInterface(mPacketStreamInterface.get());
+    AddInterface(mSimulationTrafficInterface.get());
+    AddInterface(mSimulationBitRateInterface.get());
+    AddInterface(mSimulationGapInterface.get());
 
-    AddExportOption(0, "Export as text/csv file");
-    AddExportExtension(0, "text", "txt");
-    AddExportExtension(0, "csv", "csv");
+    AddExportOption(EXPORT_TYPE_TEXT, "Export as text/csv file");
+    AddExportExtension(EXPORT_TYPE_TEXT, "text", "txt");
+    AddExportExtension(EXPORT_TYPE_TEXT, "csv", "csv");
+    AddExportOption(EXPORT_TYPE_PACKET_FILE, "Export packets as binary columnar file");
+    AddExportExtension(EXPORT_TYPE_PACKET_FILE, "Maple Bus packets", "mbpk");
+    AddExportOption(EXPORT_TYPE_ERROR_STATS, "Export error statistics as csv file");
+    AddExportExtension(EXPORT_TYPE_ERROR_STATS, "csv", "csv");
 
     ClearChannels();
     AddChannel(mInputChannelA, "SDCKA", false);
@@ -51,11 +185,73 @@ MapleBusAnalyzerSettings::OutputStyleNumber MapleBusAnalyzerSettings::NumberToOu
     return returnValue;
 }
 
+MapleBusAnalyzerSettings::BitMarkersNumber MapleBusAnalyzerSettings::NumberToBitMarkers(double num)
+{
+    BitMarkersNumber returnValue = BIT_MARKERS_ALL;
+    // Round to nearest integer and cast to enum
+    U32 bitMarkersInt = int(num + 0.5);
+    if (bitMarkersInt < BIT_MARKERS_COUNT)
+    {
+        returnValue = static_cast<BitMarkersNumber>(bitMarkersInt);
+    }
+    return returnValue;
+}
+
+MapleBusAnalyzerSettings::CommitResultsNumber MapleBusAnalyzerSettings::NumberToCommitResults(double num)
+{
+    CommitResultsNumber returnValue = COMMIT_RESULTS_BATCHED;
+    // Round to nearest integer and cast to enum
+    U32 commitResultsInt = int(num + 0.5);
+    if (commitResultsInt < COMMIT_RESULTS_COUNT)
+    {
+        returnValue = static_cast<CommitResultsNumber>(commitResultsInt);
+    }
+    return returnValue;
+}
+
+MapleBusAnalyzerSettings::TimingCheckNumber MapleBusAnalyzerSettings::NumberToTimingCheck(double num)
+{
+    TimingCheckNumber returnValue = TIMING_CHECK_OFF;
+    // Round to nearest integer and cast to enum
+    U32 timingCheckInt = int(num + 0.5);
+    if (timingCheckInt < TIMING_CHECK_COUNT)
+    {
+        returnValue = static_cast<TimingCheckNumber>(timingCheckInt);
+    }
+    return returnValue;
+}
+
+MapleBusAnalyzerSettings::SimulationTrafficNumber MapleBusAnalyzerSettings::NumberToSimulationTraffic(double num)
+{
+    SimulationTrafficNumber returnValue = SIMULATION_TRAFFIC_MIXED;
+    // Round to nearest integer and cast to enum
+    U32 simulationTrafficInt = int(num + 0.5);
+    if (simulationTrafficInt < SIMULATION_TRAFFIC_COUNT)
+    {
+        returnValue = static_cast<SimulationTrafficNumber>(simulationTrafficInt);
+    }
+    return returnValue;
+}
+
 bool MapleBusAnalyzerSettings::SetSettingsFromInterfaces()
 {
     mInputChannelA = mInputChannelAInterface->GetChannel();
     mInputChannelB = mInputChannelBInterface->GetChannel();
     mOutputStyle = NumberToOutputStyle(mOutputStyleInterface->GetNumber());
+    mBitMarkers = NumberToBitMarkers(mBitMarkersInterface->GetNumber());
+    mCommitResults = NumberToCommitResults(mCommitResultsInterface->GetNumber());
+    mCommitBatchFrames = mCommitBatchFramesInterface->GetInteger();
+    mCommitBatchMilliseconds = mCommitBatchMillisecondsInterface->GetInteger();
+    mBusBitRateKbps = mBusBitRateInterface->GetInteger();
+    mTimingCheck = NumberToTimingCheck(mTimingCheckInterface->GetNumber());
+    mTimingTolerancePercent = mTimingToleranceInterface->GetInteger();
+    mGlitchFilterANs = mGlitchFilterAInterface->GetInteger();
+    mGlitchFilterBNs = mGlitchFilterBInterface->GetInteger();
+    mRetainedPackets = mRetainedPacketsInterface->GetInteger();
+    mPacketStreamPath = mPacketStreamInterface->GetText();
+    mSimulationTraffic = NumberToSimulationTraffic(mSimulationTrafficInterface->GetNumber());
+    mSimulationBitRateKbps = mSimulationBitRateInterface->GetInteger();
+    mSimulationGapMicroseconds = mSimulationGapInterface->GetInteger();
 
     ClearChannels();
     AddChannel(mInputChannelA, "SDCKA", true);
@@ -69,6 +265,20 @@ void MapleBusAnalyzerSettings::UpdateInterfacesFromSettings()
     mInputChannelAInterface->SetChannel(mInputChannelA);
     mInputChannelBInterface->SetChannel(mInputChannelB);
     mOutputStyleInterface->SetNumber(mOutputStyle);
+    mBitMarkersInterface->SetNumber(mBitMarkers);
+    mCommitResultsInterface->SetNumber(mCommitResults);
+    mCommitBatchFramesInterface->SetInteger(mCommitBatchFrames);
+    mCommitBatchMillisecondsInterface->SetInteger(mCommitBatchMilliseconds);
+    mSimulationTrafficInterface->SetNumber(mSimulationTraffic);
+    mSimulationBitRateInterface->SetInteger(mSimulationBitRateKbps);
+    mSimulationGapInterface->SetInteger(mSimulationGapMicroseconds);
+    mBusBitRateInterface->SetInteger(mBusBitRateKbps);
+    mTimingCheckInterface->SetNumber(mTimingCheck);
+    mTimingToleranceInterface->SetInteger(mTimingTolerancePercent);
+    mGlitchFilterAInterface->SetInteger(mGlitchFilterANs);
+    mGlitchFilterBInterface->SetInteger(mGlitchFilterBNs);
+    mRetainedPacketsInterface->SetInteger(mRetainedPackets);
+    mPacketStreamInterface->SetText(mPacketStreamPath.c_str());
 }
 
 void MapleBusAnalyzerSettings::LoadSettings(const char* settings)
@@ -81,6 +291,56 @@ void MapleBusAnalyzerSettings::LoadSettings(const char* settings)
     U32 outputStyleInt = 0;
     text_archive >> outputStyleInt;
     mOutputStyle = NumberToOutputStyle(outputStyleInt);
+    // Settings saved before bit markers were selectable don't have this value
+    U32 bitMarkersInt = 0;
+    if (!(text_archive >> bitMarkersInt))
+    {
+        bitMarkersInt = BIT_MARKERS_ALL;
+    }
+    mBitMarkers = NumberToBitMarkers(bitMarkersInt);
+    // Nor do settings saved before result commits were configurable
+    U32 commitResultsInt = 0;
+    if (!(text_archive >> commitResultsInt) || !(text_archive >> mCommitBatchFrames) ||
+        !(text_archive >> mCommitBatchMilliseconds))
+    {
+        commitResultsInt = COMMIT_RESULTS_BATCHED;
+        mCommitBatchFrames = 1000;
+        mCommitBatchMilliseconds = 100;
+    }
+    mCommitResults = NumberToCommitResults(commitResultsInt);
+    // Nor do settings saved before the simulation data generator was supported
+    U32 simulationTrafficInt = 0;
+    if (!(text_archive >> simulationTrafficInt) || !(text_archive >> mSimulationBitRateKbps) ||
+        !(text_archive >> mSimulationGapMicroseconds))
+    {
+        simulationTrafficInt = SIMULATION_TRAFFIC_MIXED;
+        mSimulationBitRateKbps = 2000;
+        mSimulationGapMicroseconds = 50;
+    }
+    mSimulationTraffic = NumberToSimulationTraffic(simulationTrafficInt);
+    // Nor do settings saved before bit timing was checked
+    U32 timingCheckInt = 0;
+    if (!(text_archive >> mBusBitRateKbps) || !(text_archive >> timingCheckInt) || !(text_archive >> mTimingTolerancePercent))
+    {
+        mBusBitRateKbps = 2000;
+        timingCheckInt = TIMING_CHECK_OFF;
+        mTimingTolerancePercent = 50;
+    }
+    mTimingCheck = NumberToTimingCheck(timingCheckInt);
+    // Nor do settings saved before glitches were filtered
+    if (!(text_archive >> mGlitchFilterANs) || !(text_archive >> mGlitchFilterBNs))
+    {
+        mGlitchFilterANs = 0;
+        mGlitchFilterBNs = 0;
+    }
+    // Nor do settings saved before packets could be streamed
+    const char* packetStreamPath = "";
+    if (!(text_archive >> mRetainedPackets) || !(text_archive >> &packetStreamPath))
+    {
+        mRetainedPackets = 100000;
+        packetStreamPath = "";
+    }
+    mPacketStreamPath = packetStreamPath;
 
     ClearChannels();
     AddChannel(mInputChannelA, "SDCKA", true);
@@ -96,6 +356,20 @@ const char* MapleBusAnalyzerSettings::SaveSettings()
     text_archive << mInputChannelA;
     text_archive << mInputChannelB;
     text_archive << mOutputStyle;
+    text_archive << mBitMarkers;
+    text_archive << mCommitResults;
+    text_archive << mCommitBatchFrames;
+    text_archive << mCommitBatchMilliseconds;
+    text_archive << mSimulationTraffic;
+    text_archive << mSimulationBitRateKbps;
+    text_archive << mSimulationGapMicroseconds;
+    text_archive << mBusBitRateKbps;
+    text_archive << mTimingCheck;
+    text_archive << mTimingTolerancePercent;
+    text_archive << mGlitchFilterANs;
+    text_archive << mGlitchFilterBNs;
+    text_archive << mRetainedPackets;
+    text_archive << mPacketStreamPath.c_str();
 
     return SetReturnString(text_archive.GetString());
 }
@@ -3,6 +3,7 @@
 
 #include <AnalyzerSettings.h>
 #include <AnalyzerTypes.h>
+#include <string>
 
 class MapleBusAnalyzerSettings : public AnalyzerSettings
 {
@@ -14,11 +15,67 @@ class MapleBusAnalyzerSettings : public AnalyzerSettings
         OUTPUT_STYLE_EACH_WORD,
         OUTPUT_STYLE_WORD_BYTES,
         OUTPUT_STYLE_WORD_BYTES_LE,
+        OUTPUT_STYLE_EACH_PACKET,
 
         //! Used for conversion only
         OUTPUT_STYLE_COUNT
     };
 
+    //! Bit marker menu options
+    enum BitMarkersNumber
+    {
+        BIT_MARKERS_ALL = 0,
+        BIT_MARKERS_NONE,
+        BIT_MARKERS_ERRORS_ONLY,
+
+        //! Used for conversion only
+        BIT_MARKERS_COUNT
+    };
+
+    //! Commit results menu options
+    enum CommitResultsNumber
+    {
+        COMMIT_RESULTS_EACH_FRAME = 0,
+        COMMIT_RESULTS_EACH_PACKET,
+        COMMIT_RESULTS_BATCHED,
+
+        //! Used for conversion only
+        COMMIT_RESULTS_COUNT
+    };
+
+    //! Bit timing check menu options (see MapleBusTimingCheck)
+    enum TimingCheckNumber
+    {
+        TIMING_CHECK_OFF = 0,
+        TIMING_CHECK_FLAG,
+        TIMING_CHECK_REJECT,
+
+        //! Used for conversion only
+        TIMING_CHECK_COUNT
+    };
+
+    //! Simulation traffic menu options
+    enum SimulationTrafficNumber
+    {
+        SIMULATION_TRAFFIC_CONTROLLER = 0,
+        SIMULATION_TRAFFIC_MIXED,
+        SIMULATION_TRAFFIC_STORAGE,
+
+        //! Used for conversion only
+        SIMULATION_TRAFFIC_COUNT
+    };
+
+    //! Export types (see MapleBusAnalyzerResults::GenerateExportFile())
+    enum ExportTypeNumber
+    {
+        //! Text in the selected output style
+        EXPORT_TYPE_TEXT = 0,
+        //! Every packet in a columnar binary file (see MapleBusPacketFile.h)
+        EXPORT_TYPE_PACKET_FILE,
+        //! Error counts and every decode failure as csv (see MapleBusAnalyzerResults::GenerateErrorStatsFile())
+        EXPORT_TYPE_ERROR_STATS
+    };
+
     //! Constructor
     MapleBusAnalyzerSettings();
     //! Destructor
@@ -38,6 +95,14 @@ class MapleBusAnalyzerSettings : public AnalyzerSettings
 
     //! Converts a number to output style enum
     static OutputStyleNumber NumberToOutputStyle(double num);
+    //! Converts a number to bit markers enum
+    static BitMarkersNumber NumberToBitMarkers(double num);
+    //! Converts a number to commit results enum
+    static CommitResultsNumber NumberToCommitResults(double num);
+    //! Converts a number to bit timing check enum
+    static TimingCheckNumber NumberToTimingCheck(double num);
+    //! Converts a number to simulation traffic enum
+    static SimulationTrafficNumber NumberToSimulationTraffic(double num);
 
     //! The selected input channel
     Channel mInputChannelA;
@@ -45,11 +110,54 @@ class MapleBusAnalyzerSettings : public AnalyzerSettings
     Channel mInputChannelB;
     //! The selected data output style
     OutputStyleNumber mOutputStyle;
+    //! The selected bit markers
+    BitMarkersNumber mBitMarkers;
+    //! The selected result commit schedule
+    CommitResultsNumber mCommitResults;
+    //! Batched commits: the maximum number of frames held back
+    U32 mCommitBatchFrames;
+    //! Batched commits: the maximum time in milliseconds results are held back
+    U32 mCommitBatchMilliseconds;
+    //! The fastest bit rate expected on the bus in kbps; sets the minimum sample rate
+    U32 mBusBitRateKbps;
+    //! The selected bit timing check
+    TimingCheckNumber mTimingCheck;
+    //! Bit timing check: how far a bit period may be from nominal, in percent
+    U32 mTimingTolerancePercent;
+    //! Pulses on SDCKA shorter than this many nanoseconds are removed; 0 keeps every pulse
+    U32 mGlitchFilterANs;
+    //! Pulses on SDCKB shorter than this many nanoseconds are removed; 0 keeps every pulse
+    U32 mGlitchFilterBNs;
+    //! The least number of recent packets, transactions and errors kept for display and export; 0 keeps all of them.
+    //! Only bounds the analyzer's own records, not the frames and markers held by Logic
+    U32 mRetainedPackets;
+    //! The file or named pipe each packet is streamed to as it is decoded; empty for none
+    std::string mPacketStreamPath;
+    //! Simulation: the selected packet mix
+    SimulationTrafficNumber mSimulationTraffic;
+    //! Simulation: the bit rate in kbps
+    U32 mSimulationBitRateKbps;
+    //! Simulation: the idle time in microseconds after each packet
+    U32 mSimulationGapMicroseconds;
 
   protected:
     std::auto_ptr<AnalyzerSettingInterfaceChannel> mInputChannelAInterface;
     std::auto_ptr<AnalyzerSettingInterfaceChannel> mInputChannelBInterface;
     std::auto_ptr<AnalyzerSettingInterfaceNumberList> mOutputStyleInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceNumberList> mBitMarkersInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceNumberList> mCommitResultsInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceInteger> mCommitBatchFramesInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceInteger> mCommitBatchMillisecondsInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceInteger> mBusBitRateInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceNumberList> mTimingCheckInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceInteger> mTimingToleranceInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceInteger> mGlitchFilterAInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceInteger> mGlitchFilterBInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceInteger> mRetainedPacketsInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceText> mPacketStreamInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceNumberList> mSimulationTrafficInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceInteger> mSimulationBitRateInterface;
+    std::auto_ptr<AnalyzerSettingInterfaceInteger> mSimulationGapInterface;
 };
 
 #endif // MAPLEBUS_ANALYZER_SETTINGS
@@ -0,0 +1,154 @@
+#include "MapleBusChannelTransitionSource.h"
+#include <AnalyzerChannelData.h>
+
+MapleBusChannelTransitionSource::MapleBusChannelTransitionSource(AnalyzerChannelData* serialA, AnalyzerChannelData* serialB,
+                                                                 MapleBusChannelWaitListener* waitListener)
+    : mSerialA(serialA), mSerialB(serialB), mWaitListener(waitListener), mNextA(0), mNextB(0), mNextAValid(false), mNextBValid(false)
+{
+    // Align the two sample numbers
+    U64 aSample = mSerialA->GetSampleNumber();
+    U64 bSample = mSerialB->GetSampleNumber();
+    if (aSample > bSample)
+    {
+        mSerialB->AdvanceToAbsPosition(aSample);
+    }
+    else if (bSample > aSample)
+    {
+        mSerialA->AdvanceToAbsPosition(bSample);
+    }
+}
+
+MapleBusChannelTransitionSource::~MapleBusChannelTransitionSource()
+{
+}
+
+U8 MapleBusChannelTransitionSource::GetInitialLines()
+{
+    return GetCurrentLines();
+}
+
+U8 MapleBusChannelTransitionSource::GetCurrentLines()
+{
+    U8 lines = 0;
+    if (mSerialA->GetBitState() == BIT_HIGH)
+    {
+        lines |= MAPLE_BUS_LINE_A;
+    }
+    if (mSerialB->GetBitState() == BIT_HIGH)
+    {
+        lines |= MAPLE_BUS_LINE_B;
+    }
+    return lines;
+}
+
+bool MapleBusChannelTransitionSource::PeekNextEdge(AnalyzerChannelData* channel, U64& nextEdge)
+{
+    if (channel->DoMoreTransitionsExistInCurrentData())
+    {
+        nextEdge = channel->GetSampleOfNextEdge();
+        return true;
+    }
+    return false;
+}
+
+bool MapleBusChannelTransitionSource::GetNextTransition(MapleBusTransition& transition)
+{
+    if (!mNextAValid)
+    {
+        mNextAValid = PeekNextEdge(mSerialA, mNextA);
+    }
+    if (!mNextBValid)
+    {
+        mNextBValid = PeekNextEdge(mSerialB, mNextB);
+    }
+
+    if (!mNextAValid && !mNextBValid)
+    {
+        // Neither channel has an edge in the data captured so far. Every packet begins with SDCKA falling, so block on
+        // SDCKA like the bus does when it is idle.
+        if (mWaitListener != NULL)
+        {
+            mWaitListener->OnWaitForData();
+        }
+        mNextA = mSerialA->GetSampleOfNextEdge();
+        mNextAValid = true;
+    }
+
+    // A channel without a known next edge only needs to be checked up to the other channel's next edge
+    if (!mNextAValid)
+    {
+        mNextAValid = mSerialA->WouldAdvancingToAbsPositionCauseTransition(mNextB);
+        if (mNextAValid)
+        {
+            mNextA = mSerialA->GetSampleOfNextEdge();
+        }
+    }
+    else if (!mNextBValid)
+    {
+        mNextBValid = mSerialB->WouldAdvancingToAbsPositionCauseTransition(mNextA);
+        if (mNextBValid)
+        {
+            mNextB = mSerialB->GetSampleOfNextEdge();
+        }
+    }
+
+    bool advanceA = mNextAValid && (!mNextBValid || mNextA <= mNextB);
+    bool advanceB = mNextBValid && (!mNextAValid || mNextB <= mNextA);
+
+    if (advanceA)
+    {
+        transition.sample = mNextA;
+        mSerialA->AdvanceToNextEdge();
+        mNextAValid = false;
+    }
+
+    if (advanceB)
+    {
+        transition.sample = mNextB;
+        mSerialB->AdvanceToNextEdge();
+        mNextBValid = false;
+    }
+
+    // The channel which didn't advance has no edge up to this sample, so its current state still holds
+    transition.lines = GetCurrentLines();
+    return true;
+}
+
+bool MapleBusChannelTransitionSource::HasTransitionBefore(U64 sample)
+{
+    if (sample == 0)
+    {
+        return false;
+    }
+    bool edgeOfA = mNextAValid ? (mNextA < sample) : mSerialA->WouldAdvancingToAbsPositionCauseTransition(sample - 1);
+    bool edgeOfB = mNextBValid ? (mNextB < sample) : mSerialB->WouldAdvancingToAbsPositionCauseTransition(sample - 1);
+    return edgeOfA || edgeOfB;
+}
+
+bool MapleBusChannelTransitionSource::GetNextTransitionOfA(U8& lines, MapleBusTransition& transition)
+{
+    if (!mNextAValid)
+    {
+        mNextAValid = PeekNextEdge(mSerialA, mNextA);
+        if (!mNextAValid)
+        {
+            // Only SDCKA matters here, so block on it whether or not SDCKB has edges
+            if (mWaitListener != NULL)
+            {
+                mWaitListener->OnWaitForData();
+            }
+            mNextA = mSerialA->GetSampleOfNextEdge();
+            mNextAValid = true;
+        }
+    }
+
+    if (!mNextBValid || mNextB < mNextA)
+    {
+        // Skip every SDCKB edge before SDCKA's; an SDCKB edge at the same sample is left for GetNextTransition()
+        mSerialB->AdvanceToAbsPosition(mNextA - 1);
+        mNextBValid = false;
+    }
+
+    lines = GetCurrentLines();
+    return GetNextTransition(transition);
+}
@@ -0,0 +1,71 @@
+#ifndef MAPLEBUS_CHANNEL_TRANSITION_SOURCE_H
+#define MAPLEBUS_CHANNEL_TRANSITION_SOURCE_H
+
+#include "MapleBusTransitionSource.h"
+
+class AnalyzerChannelData;
+
+//! Notified whenever MapleBusChannelTransitionSource is about to block for more captured data
+class MapleBusChannelWaitListener
+{
+  public:
+    //! Destructor
+    virtual ~MapleBusChannelWaitListener()
+    {
+    }
+
+    //! Called just before blocking; a good time to flush anything held back
+    virtual void OnWaitForData() = 0;
+};
+
+//! Merges Saleae's SDCKA and SDCKB channel data into a single time ordered transition stream.
+//! Each channel is only ever advanced over its own edges, so no channel is re-scanned.
+class MapleBusChannelTransitionSource : public MapleBusTransitionSource
+{
+  public:
+    //! Constructor
+    //! @param[in] serialA  the Saleae channel data of SDCKA
+    //! @param[in] serialB  the Saleae channel data of SDCKB
+    //! @param[in] waitListener  notified before blocking for more data, or NULL
+    MapleBusChannelTransitionSource(AnalyzerChannelData* serialA, AnalyzerChannelData* serialB,
+                                    MapleBusChannelWaitListener* waitListener = NULL);
+    //! Destructor
+    virtual ~MapleBusChannelTransitionSource();
+
+    virtual U8 GetInitialLines();
+    //! Retrieves the next transition, blocking until more data is available
+    //! @returns true always
+    virtual bool GetNextTransition(MapleBusTransition& transition);
+    //! Moves SDCKB straight to SDCKA's next edge, skipping SDCKB's edges in between, blocking until SDCKA's next edge
+    //! is available
+    //! @returns true always
+    virtual bool GetNextTransitionOfA(U8& lines, MapleBusTransition& transition);
+    //! Checks each channel up to the given sample, blocking only until data up to it is captured
+    virtual bool HasTransitionBefore(U64 sample);
+
+  private:
+    //! @returns the state of both lines at the current channel positions (see MapleBusLineMask)
+    U8 GetCurrentLines();
+    //! Looks up the next edge of a channel without blocking
+    //! @param[in] channel  the channel to check
+    //! @param[out] nextEdge  set to the sample number of the next edge when found
+    //! @returns true iff the next edge is already available
+    static bool PeekNextEdge(AnalyzerChannelData* channel, U64& nextEdge);
+
+    //! The Saleae channel data of SDCKA
+    AnalyzerChannelData* mSerialA;
+    //! The Saleae channel data of SDCKB
+    AnalyzerChannelData* mSerialB;
+    //! Notified before blocking for more data
+    MapleBusChannelWaitListener* mWaitListener;
+    //! The sample number of the next SDCKA edge, valid when mNextAValid
+    U64 mNextA;
+    //! The sample number of the next SDCKB edge, valid when mNextBValid
+    U64 mNextB;
+    //! true iff mNextA is valid
+    bool mNextAValid;
+    //! true iff mNextB is valid
+    bool mNextBValid;
+};
+
+#endif // MAPLEBUS_CHANNEL_TRANSITION_SOURCE_H
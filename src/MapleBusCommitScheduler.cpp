@@ -0,0 +1,94 @@
+#include "MapleBusCommitScheduler.h"
+
+//! The clock is only read once per this many frames since reading it costs more than adding a frame
+static const U32 FRAMES_PER_TIME_CHECK = 64;
+
+MapleBusCommitScheduler::MapleBusCommitScheduler(MapleBusCommitPolicy policy, U32 maxFrames, U32 maxMilliseconds)
+    : mPolicy(policy),
+      mMaxFrames(maxFrames),
+      mMaxDuration(std::chrono::milliseconds(maxMilliseconds)),
+      mNumPendingFrames(0),
+      mPending(false),
+      mPendingSince(),
+      mNumCommits(0)
+{
+}
+
+MapleBusCommitScheduler::~MapleBusCommitScheduler()
+{
+}
+
+bool MapleBusCommitScheduler::AddFrame()
+{
+    if (!mPending)
+    {
+        mPending = true;
+        if (mPolicy == MAPLE_BUS_COMMIT_BATCHED)
+        {
+            mPendingSince = std::chrono::steady_clock::now();
+        }
+    }
+    ++mNumPendingFrames;
+
+    switch (mPolicy)
+    {
+    case MAPLE_BUS_COMMIT_EACH_FRAME:
+        return true;
+
+    case MAPLE_BUS_COMMIT_BATCHED:
+        return (mNumPendingFrames >= mMaxFrames ||
+                ((mNumPendingFrames % FRAMES_PER_TIME_CHECK) == 0 && IsTimeBudgetSpent()));
+
+    default:
+    case MAPLE_BUS_COMMIT_EACH_PACKET:
+        return false;
+    }
+}
+
+bool MapleBusCommitScheduler::EndPacket()
+{
+    // Start and stop markers are pending even when no frame was added
+    if (!mPending)
+    {
+        mPending = true;
+        if (mPolicy == MAPLE_BUS_COMMIT_BATCHED)
+        {
+            mPendingSince = std::chrono::steady_clock::now();
+        }
+    }
+
+    switch (mPolicy)
+    {
+    case MAPLE_BUS_COMMIT_EACH_PACKET:
+        return true;
+
+    case MAPLE_BUS_COMMIT_BATCHED:
+        return IsTimeBudgetSpent();
+
+    default:
+    case MAPLE_BUS_COMMIT_EACH_FRAME:
+        return false;
+    }
+}
+
+bool MapleBusCommitScheduler::HasPending() const
+{
+    return mPending;
+}
+
+void MapleBusCommitScheduler::Committed()
+{
+    mPending = false;
+    mNumPendingFrames = 0;
+    ++mNumCommits;
+}
+
+U64 MapleBusCommitScheduler::GetNumCommits() const
+{
+    return mNumCommits;
+}
+
+bool MapleBusCommitScheduler::IsTimeBudgetSpent() const
+{
+    return (std::chrono::steady_clock::now() - mPendingSince >= mMaxDuration);
+}
@@ -0,0 +1,65 @@
+#ifndef MAPLEBUS_COMMIT_SCHEDULER_H
+#define MAPLEBUS_COMMIT_SCHEDULER_H
+
+#include <LogicPublicTypes.h>
+#include <chrono>
+
+//! Determines when added results are committed
+enum MapleBusCommitPolicy
+{
+    //! Commit after every frame
+    MAPLE_BUS_COMMIT_EACH_FRAME = 0,
+    //! Commit at the end of every packet
+    MAPLE_BUS_COMMIT_EACH_PACKET,
+    //! Commit once a number of frames are pending or some time has passed since the last commit
+    MAPLE_BUS_COMMIT_BATCHED
+};
+
+//! Decides when results should be committed so that the host isn't asked to process a commit for every single frame,
+//! while newly decoded frames still show up within a bounded amount of time.
+class MapleBusCommitScheduler
+{
+  public:
+    //! Constructor
+    //! @param[in] policy  when to commit
+    //! @param[in] maxFrames  MAPLE_BUS_COMMIT_BATCHED only: commit once this many frames are pending
+    //! @param[in] maxMilliseconds  MAPLE_BUS_COMMIT_BATCHED only: commit once pending results are this old
+    MapleBusCommitScheduler(MapleBusCommitPolicy policy, U32 maxFrames, U32 maxMilliseconds);
+    //! Destructor
+    virtual ~MapleBusCommitScheduler();
+
+    //! Records that a frame was added
+    //! @returns true iff results should be committed now
+    bool AddFrame();
+    //! Records that a packet ended
+    //! @returns true iff results should be committed now
+    bool EndPacket();
+    //! @returns true iff anything was added since the last commit
+    bool HasPending() const;
+    //! Records that results were committed
+    void Committed();
+
+    //! @returns the number of commits so far
+    U64 GetNumCommits() const;
+
+  private:
+    //! @returns true iff pending results are older than the time budget
+    bool IsTimeBudgetSpent() const;
+
+    //! When to commit
+    const MapleBusCommitPolicy mPolicy;
+    //! Frame budget
+    const U32 mMaxFrames;
+    //! Time budget
+    const std::chrono::steady_clock::duration mMaxDuration;
+    //! Frames added since the last commit
+    U32 mNumPendingFrames;
+    //! true iff anything was added since the last commit
+    bool mPending;
+    //! Time of the first addition since the last commit
+    std::chrono::steady_clock::time_point mPendingSince;
+    //! Number of commits
+    U64 mNumCommits;
+};
+
+#endif // MAPLEBUS_COMMIT_SCHEDULER_H
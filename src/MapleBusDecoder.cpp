@@ -0,0 +1,523 @@
+#include "MapleBusDecoder.h"
+#include <math.h>
+
+//! Number of SDCKB edges within a valid start sequence (4 pulses)
+static const U32 NUM_START_EDGES = 8;
+//! Number of SDCKA edges between the first SDCKA falling edge and the final SDCKB edge of the end sequence
+static const U32 NUM_END_EDGES = 3;
+//! Number of phases in each bit: the data line settles, the clock line rises, then the clock line falls
+static const U32 PHASES_PER_BIT = 3;
+
+MapleBusDecoder::MapleBusDecoder(MapleBusDecoderListener* listener)
+    : mListener(listener), mBitReporting(MAPLE_BUS_BITS_ALL), mTimingCheck(MAPLE_BUS_TIMING_OFF), mTolerancePercent(0)
+{
+    Reset(MAPLE_BUS_LINES_AB);
+}
+
+MapleBusDecoder::~MapleBusDecoder()
+{
+}
+
+void MapleBusDecoder::SetBitReporting(MapleBusBitReporting bitReporting)
+{
+    mBitReporting = bitReporting;
+    mPendingBits.clear();
+}
+
+void MapleBusDecoder::SetTimingCheck(MapleBusTimingCheck check, U32 tolerancePercent)
+{
+    mTimingCheck = check;
+    mTolerancePercent = tolerancePercent;
+}
+
+void MapleBusDecoder::Reset(U8 lines)
+{
+    mLines = lines & MAPLE_BUS_LINES_AB;
+    mResyncing = false;
+    mErrorSample = 0;
+    mResumeSample = 0;
+    mStartSample = 0;
+    mNumEdges = 0;
+    mBitIndex = 0;
+    mCurrentByte = 0;
+    mByteStartingSample = 0;
+    mDataEdgeSample = 0;
+    mClockEdgeSample = 0;
+    mFirstStartEdgeSample = 0;
+    mLastStartEdgeSample = 0;
+    mMinBitPeriod = 0;
+    mMaxBitPeriod = 0xFFFFFFFF;
+    ResetPacketData();
+    WaitForNeutral(0);
+}
+
+void MapleBusDecoder::ResetPacketData()
+{
+    mTotalBytesExpected = -1;
+    mTotalWordsExpected = -1;
+    mNumBytesLeftExpected = -1;
+    mNumWordsLeftExpected = -1;
+    mByteCount = 0;
+    mCurrentWord = 0;
+    mWordStartingSample = 0;
+    mCrcAccumulator = 0;
+    mPacket.startSample = 0;
+    mPacket.dataStartSample = 0;
+    mPacket.endSample = 0;
+    mPacket.bytes.clear();
+    mPacket.byteEndSamples.clear();
+    mPacket.crcValid = false;
+    mPacket.timing.Clear();
+    mPendingBits.clear();
+}
+
+void MapleBusDecoder::WaitForNeutral(U64 currentSample)
+{
+    mState = (mLines == MAPLE_BUS_LINES_AB) ? STATE_NEUTRAL : STATE_WAIT_NEUTRAL;
+    if (mState == STATE_NEUTRAL && mResyncing)
+    {
+        // The skipped span ends here unless the next start sequence fails too
+        mResumeSample = currentSample;
+    }
+}
+
+bool MapleBusDecoder::IsWaitingForA() const
+{
+    // Both lines can only be high again once SDCKA rises, and only SDCKA falling begins a start sequence
+    return (mState == STATE_NEUTRAL || (mState == STATE_WAIT_NEUTRAL && (mLines & MAPLE_BUS_LINE_A) == 0));
+}
+
+void MapleBusDecoder::HandleError(MapleBusErrorType type, U64 sample, U32 expectedEdges, U32 observedEdges, U64 currentSample)
+{
+    // Only now is it known that the held back bits are of interest
+    for (std::vector<MapleBusDecodedBit>::const_iterator iter = mPendingBits.begin(); iter != mPendingBits.end(); ++iter)
+    {
+        mListener->OnBit(iter->clockEdgeSample, iter->clockIsA, iter->value);
+    }
+    mPendingBits.clear();
+
+    // Start sequences which fail before decoding has resumed belong to the same error
+    if (!mResyncing)
+    {
+        MapleBusDecodeError error;
+        error.type = type;
+        error.sample = sample;
+        error.startSample = mStartSample;
+        error.byteIndex = (mState == STATE_START) ? 0 : mByteCount;
+        error.bitIndex = (mState == STATE_DATA) ? mBitIndex : 0;
+        error.expectedEdges = expectedEdges;
+        error.observedEdges = observedEdges;
+        mListener->OnError(error);
+        mResyncing = true;
+        mErrorSample = sample;
+    }
+    WaitForNeutral(currentSample);
+}
+
+void MapleBusDecoder::Run(MapleBusTransitionSource* source)
+{
+    Reset(source->GetInitialLines());
+
+    MapleBusTransition transition;
+    while (true)
+    {
+        if (IsWaitingForA())
+        {
+            // SDCKB's edges make no difference until SDCKA's next edge, so the source may skip them; this is where
+            // decoding resumes after an error, however noisy SDCKB is in between
+            if (!source->GetNextTransitionOfA(mLines, transition))
+            {
+                break;
+            }
+        }
+        else if (!source->GetNextTransition(transition))
+        {
+            break;
+        }
+        ProcessTransition(transition);
+    }
+}
+
+bool MapleBusDecoder::IsIdle() const
+{
+    return (mState == STATE_NEUTRAL && mLines == MAPLE_BUS_LINES_AB && !mResyncing);
+}
+
+bool MapleBusDecoder::GetPendingResync(U64& errorSample, U64& resumeSample) const
+{
+    if (mState != STATE_NEUTRAL || mLines != MAPLE_BUS_LINES_AB || !mResyncing)
+    {
+        return false;
+    }
+    errorSample = mErrorSample;
+    resumeSample = mResumeSample;
+    return true;
+}
+
+void MapleBusDecoder::ProcessTransition(const MapleBusTransition& transition)
+{
+    U8 changed = (transition.lines ^ mLines) & MAPLE_BUS_LINES_AB;
+    mLines = transition.lines & MAPLE_BUS_LINES_AB;
+
+    switch (mState)
+    {
+    case STATE_WAIT_NEUTRAL:
+    {
+        // Wait until both serial lines are high
+        WaitForNeutral(transition.sample);
+    }
+    break;
+
+    case STATE_NEUTRAL:
+    {
+        if ((changed & MAPLE_BUS_LINE_A) != 0)
+        {
+            // SDCKA falling edge -- beginning of the start sequence
+            mStartSample = transition.sample;
+            // An SDCKB edge at the same sample counts as the first clock of the sequence
+            mNumEdges = ((changed & MAPLE_BUS_LINE_B) != 0) ? 1 : 0;
+            mFirstStartEdgeSample = transition.sample;
+            mLastStartEdgeSample = transition.sample;
+            mState = STATE_START;
+        }
+    }
+    break;
+
+    case STATE_START:
+    {
+        if ((changed & MAPLE_BUS_LINE_A) != 0)
+        {
+            // SDCKA rising edge -- end of the start sequence; SDCKB must have clocked exactly 4 times before now
+            if ((changed & MAPLE_BUS_LINE_B) == 0 && mNumEdges == NUM_START_EDGES)
+            {
+                if (mResyncing)
+                {
+                    mResyncing = false;
+                    mListener->OnResync(mErrorSample, mResumeSample);
+                }
+                ResetPacketData();
+                LearnBitPeriod();
+                mPacket.startSample = mStartSample;
+                mPacket.dataStartSample = transition.sample;
+                mListener->OnPacketStart(mStartSample, transition.sample);
+
+                mState = STATE_DATA;
+                mNumEdges = 0;
+                mBitIndex = 0;
+                mCurrentByte = 0;
+                mByteStartingSample = transition.sample;
+            }
+            else
+            {
+                // An SDCKB edge along with SDCKA's rising edge counts as one too many
+                U32 numEdges = ((changed & MAPLE_BUS_LINE_B) != 0) ? (mNumEdges + 1) : mNumEdges;
+                HandleError(MAPLE_BUS_ERROR_START_SEQUENCE, mStartSample, NUM_START_EDGES, numEdges, transition.sample);
+            }
+        }
+        else if ((changed & MAPLE_BUS_LINE_B) != 0)
+        {
+            if (mNumEdges++ == 0)
+            {
+                mFirstStartEdgeSample = transition.sample;
+            }
+            mLastStartEdgeSample = transition.sample;
+        }
+    }
+    break;
+
+    case STATE_DATA:
+    {
+        ProcessDataTransition(transition, changed);
+    }
+    break;
+
+    case STATE_END:
+    {
+        // SDCKA is the clock and SDCKB the data within the end sequence
+        if ((changed & MAPLE_BUS_LINE_B) != 0)
+        {
+            if ((changed & MAPLE_BUS_LINE_A) == 0 && mNumEdges == NUM_END_EDGES)
+            {
+                mPacket.endSample = transition.sample;
+                mPendingBits.clear();
+                mListener->OnPacketEnd(mPacket);
+                WaitForNeutral(transition.sample);
+            }
+            else
+            {
+                U32 numEdges = ((changed & MAPLE_BUS_LINE_A) != 0) ? (mNumEdges + 1) : mNumEdges;
+                HandleError(MAPLE_BUS_ERROR_END_SEQUENCE, transition.sample, NUM_END_EDGES, numEdges, transition.sample);
+            }
+        }
+        else if ((changed & MAPLE_BUS_LINE_A) != 0)
+        {
+            // Go to rising then falling then rising
+            if (++mNumEdges > NUM_END_EDGES)
+            {
+                HandleError(MAPLE_BUS_ERROR_END_SEQUENCE, transition.sample, NUM_END_EDGES, mNumEdges, transition.sample);
+            }
+        }
+    }
+    break;
+    }
+}
+
+void MapleBusDecoder::ProcessDataTransition(const MapleBusTransition& transition, U8 changed)
+{
+    // Data and clock flip flop on each bit
+    bool aIsClock = ((mBitIndex & 1) == 0);
+    U8 clockMask = aIsClock ? MAPLE_BUS_LINE_A : MAPLE_BUS_LINE_B;
+    U8 dataMask = aIsClock ? MAPLE_BUS_LINE_B : MAPLE_BUS_LINE_A;
+
+    if ((changed & dataMask) != 0)
+    {
+        ++mNumEdges;
+        mDataEdgeSample = transition.sample;
+    }
+
+    if ((changed & clockMask) == 0 || (mLines & clockMask) != 0)
+    {
+        // Only the clock falling edge is of interest
+        return;
+    }
+
+    U64 clockEdgeSample = transition.sample;
+    U32 numDataEdges = mNumEdges;
+    mNumEdges = 0;
+
+    if (mBitIndex == 0)
+    {
+        if (numDataEdges == 2)
+        {
+            // Either we are reaching the end or error detected
+            mState = STATE_END;
+            return;
+        }
+        else if (numDataEdges > 2)
+        {
+            HandleError(MAPLE_BUS_ERROR_DATA_EDGES, clockEdgeSample, 2, numDataEdges, clockEdgeSample);
+            return;
+        }
+    }
+    else if (numDataEdges > 1)
+    {
+        // More than 1 data edge before clock is not expected
+        HandleError(MAPLE_BUS_ERROR_DATA_EDGES, clockEdgeSample, 1, numDataEdges, clockEdgeSample);
+        return;
+    }
+
+    // Valid bit detected; the first bit has no previous clock edge to measure its period from
+    MapleBusBitTiming& timing = mPacket.timing;
+    if (mByteCount > 0 || mBitIndex > 0)
+    {
+        U32 period = static_cast<U32>(clockEdgeSample - mClockEdgeSample);
+        if (period < mMinBitPeriod || period > mMaxBitPeriod)
+        {
+            if (mTimingCheck == MAPLE_BUS_TIMING_REJECT)
+            {
+                HandleError(MAPLE_BUS_ERROR_BIT_TIMING, clockEdgeSample, timing.nominalPeriod, period, clockEdgeSample);
+                return;
+            }
+            ++timing.numOutOfTolerance;
+        }
+        ++timing.numPeriods;
+        timing.minPeriod = (period < timing.minPeriod) ? period : timing.minPeriod;
+        timing.maxPeriod = (period > timing.maxPeriod) ? period : timing.maxPeriod;
+        timing.sumPeriods += period;
+        timing.sumSquaredPeriods += static_cast<U64>(period) * period;
+    }
+    if (numDataEdges > 0)
+    {
+        U32 setup = static_cast<U32>(clockEdgeSample - mDataEdgeSample);
+        timing.minSetup = (setup < timing.minSetup) ? setup : timing.minSetup;
+    }
+    mClockEdgeSample = clockEdgeSample;
+
+    bool bitValue = ((mLines & dataMask) != 0);
+    if (bitValue)
+    {
+        mCurrentByte |= (1 << (7 - mBitIndex));
+    }
+    ReportBit(clockEdgeSample, aIsClock, bitValue);
+
+    if (++mBitIndex == 8)
+    {
+        // we have a byte to save!
+        SaveByte(mByteStartingSample, clockEdgeSample, mCurrentByte);
+        mBitIndex = 0;
+        mCurrentByte = 0;
+        mByteStartingSample = clockEdgeSample;
+    }
+}
+
+void MapleBusDecoder::LearnBitPeriod()
+{
+    if (mTimingCheck == MAPLE_BUS_TIMING_OFF)
+    {
+        mMinBitPeriod = 0;
+        mMaxBitPeriod = 0xFFFFFFFF;
+        return;
+    }
+
+    // The first and last of SDCKB's start sequence edges are 7 phases apart
+    double nominal = static_cast<double>(mLastStartEdgeSample - mFirstStartEdgeSample) * PHASES_PER_BIT / (NUM_START_EDGES - 1);
+    double slack = nominal * mTolerancePercent / 100.0 + 1.0;
+    mMinBitPeriod = (nominal > slack) ? static_cast<U32>(ceil(nominal - slack)) : 0;
+    mMaxBitPeriod = static_cast<U32>(floor(nominal + slack));
+    mPacket.timing.nominalPeriod = static_cast<U32>(nominal + 0.5);
+}
+
+void MapleBusDecoder::ReportBit(U64 clockEdgeSample, bool clockIsA, bool value)
+{
+    switch (mBitReporting)
+    {
+    case MAPLE_BUS_BITS_ALL:
+        mListener->OnBit(clockEdgeSample, clockIsA, value);
+        break;
+
+    case MAPLE_BUS_BITS_ON_ERROR:
+    {
+        MapleBusDecodedBit bit;
+        bit.clockEdgeSample = clockEdgeSample;
+        bit.clockIsA = clockIsA;
+        bit.value = value;
+        mPendingBits.push_back(bit);
+    }
+    break;
+
+    default:
+    case MAPLE_BUS_BITS_NONE:
+        break;
+    }
+}
+
+void MapleBusDecoder::SaveByte(U64 startingSample, U64 endingSample, U8 theByte)
+{
+    ++mByteCount;
+    mPacket.bytes.push_back(theByte);
+    mPacket.byteEndSamples.push_back(endingSample);
+
+    // The CRC covers the completed words plus any bytes of the current word
+    U32 precedingWords = mCrcAccumulator ^ mCurrentWord;
+
+    // Build word (little endian)
+    mCurrentWord = mCurrentWord >> 8;
+    mCurrentWord |= (static_cast<U32>(theByte) << 24);
+
+    if (mByteCount == 1)
+    {
+        // This is the first byte which tells us how many extra 32-bit words to expect
+        mTotalBytesExpected = theByte * 4;
+        // Add 4 bytes for the first frame
+        mTotalBytesExpected += 4;
+        // Add 1 byte for the CRC value
+        mTotalBytesExpected += 1;
+
+        mNumBytesLeftExpected = mTotalBytesExpected - 1;
+    }
+    else if (mNumBytesLeftExpected > 0)
+    {
+        --mNumBytesLeftExpected;
+    }
+
+    MapleBusDecodedByte decodedByte;
+    decodedByte.startSample = startingSample;
+    decodedByte.endSample = endingSample;
+    decodedByte.value = theByte;
+    decodedByte.byteCount = mByteCount;
+    decodedByte.numBytesLeft = mNumBytesLeftExpected;
+    decodedByte.type = MAPLE_BUS_DATA_PAYLOAD;
+    decodedByte.crcValid = false;
+    if (mByteCount < 5)
+    {
+        decodedByte.type = MAPLE_BUS_DATA_FRAME;
+    }
+    else if (mNumBytesLeftExpected == 0)
+    {
+        decodedByte.type = MAPLE_BUS_DATA_CRC;
+        // Bytes beyond the expected CRC byte are also reported as CRC, but never valid
+        if (static_cast<S32>(mByteCount) == mTotalBytesExpected)
+        {
+            decodedByte.crcValid = (FoldCrc(precedingWords) == theByte);
+            mPacket.crcValid = decodedByte.crcValid;
+        }
+    }
+    mListener->OnByte(decodedByte);
+
+    if (mByteCount == 1)
+    {
+        mTotalWordsExpected = theByte + 1;
+        mNumWordsLeftExpected = mTotalWordsExpected;
+    }
+    else if (mByteCount % 4 == 0)
+    {
+        // We have a word to save
+        if (mNumWordsLeftExpected > 0)
+        {
+            --mNumWordsLeftExpected;
+        }
+
+        MapleBusDecodedWord decodedWord;
+        decodedWord.startSample = mWordStartingSample;
+        decodedWord.endSample = endingSample;
+        decodedWord.value = mCurrentWord;
+        decodedWord.numWordsLeft = mNumWordsLeftExpected;
+        decodedWord.type = (mByteCount == 4) ? MAPLE_BUS_DATA_FRAME : MAPLE_BUS_DATA_PAYLOAD;
+        mListener->OnWord(decodedWord);
+
+        mCrcAccumulator ^= mCurrentWord;
+        mCurrentWord = 0;
+    }
+
+    if (mByteCount % 4 == 1)
+    {
+        mWordStartingSample = startingSample;
+    }
+}
+
+U8 MapleBusDecoder::FoldCrc(U32 word)
+{
+    word ^= word >> 16;
+    word ^= word >> 8;
+    return static_cast<U8>(word);
+}
+
+void MapleBusBitTiming::Clear()
+{
+    numPeriods = 0;
+    minPeriod = 0xFFFFFFFF;
+    maxPeriod = 0;
+    minSetup = NO_SETUP;
+    numOutOfTolerance = 0;
+    nominalPeriod = 0;
+    sumPeriods = 0;
+    sumSquaredPeriods = 0;
+}
+
+void MapleBusBitTiming::Merge(const MapleBusBitTiming& other)
+{
+    numPeriods += other.numPeriods;
+    minPeriod = (other.minPeriod < minPeriod) ? other.minPeriod : minPeriod;
+    maxPeriod = (other.maxPeriod > maxPeriod) ? other.maxPeriod : maxPeriod;
+    minSetup = (other.minSetup < minSetup) ? other.minSetup : minSetup;
+    numOutOfTolerance += other.numOutOfTolerance;
+    nominalPeriod = (other.nominalPeriod != 0) ? other.nominalPeriod : nominalPeriod;
+    sumPeriods += other.sumPeriods;
+    sumSquaredPeriods += other.sumSquaredPeriods;
+}
+
+double MapleBusBitTiming::GetMeanPeriod() const
+{
+    return (numPeriods > 0) ? (static_cast<double>(sumPeriods) / numPeriods) : 0;
+}
+
+double MapleBusBitTiming::GetJitter() const
+{
+    if (numPeriods == 0)
+    {
+        return 0;
+    }
+    double mean = GetMeanPeriod();
+    double variance = static_cast<double>(sumSquaredPeriods) / numPeriods - mean * mean;
+    return (variance > 0) ? sqrt(variance) : 0;
+}
@@ -0,0 +1,388 @@
+#ifndef MAPLEBUS_DECODER_H
+#define MAPLEBUS_DECODER_H
+
+#include "MapleBusTransitionSource.h"
+#include <vector>
+
+//! Classification of a decoded byte or word
+enum MapleBusDataType
+{
+    //! Payload data
+    MAPLE_BUS_DATA_PAYLOAD = 0,
+    //! Maple Bus frame data (the first word of a packet)
+    MAPLE_BUS_DATA_FRAME,
+    //! CRC byte
+    MAPLE_BUS_DATA_CRC
+};
+
+//! Determines which bits are reported through MapleBusDecoderListener::OnBit()
+enum MapleBusBitReporting
+{
+    //! Every bit is reported as soon as it is sampled
+    MAPLE_BUS_BITS_ALL = 0,
+    //! No bits are reported
+    MAPLE_BUS_BITS_NONE,
+    //! Bits are held until the end of each packet and only reported, just before the error, if the packet fails
+    MAPLE_BUS_BITS_ON_ERROR
+};
+
+//! What the decoder does with a bit whose period is outside the timing tolerance (see MapleBusDecoder::SetTimingCheck())
+enum MapleBusTimingCheck
+{
+    //! Bit periods aren't checked
+    MAPLE_BUS_TIMING_OFF = 0,
+    //! The bit is decoded and counted in MapleBusBitTiming::numOutOfTolerance
+    MAPLE_BUS_TIMING_FLAG,
+    //! The packet fails with MAPLE_BUS_ERROR_BIT_TIMING
+    MAPLE_BUS_TIMING_REJECT
+};
+
+//! Classification of a decode failure or a faulty packet
+enum MapleBusErrorType
+{
+    //! SDCKB didn't clock exactly 4 times while SDCKA was low, or changed along with SDCKA's rising edge
+    MAPLE_BUS_ERROR_START_SEQUENCE = 0,
+    //! More data edges within a bit than the protocol allows, such as a glitch on the data line
+    MAPLE_BUS_ERROR_DATA_EDGES,
+    //! The end sequence didn't follow its expected SDCKA and SDCKB edges
+    MAPLE_BUS_ERROR_END_SEQUENCE,
+    //! A bit period was outside the timing tolerance (MAPLE_BUS_TIMING_REJECT), or a packet held such bits
+    //! (MAPLE_BUS_TIMING_FLAG; never reported by the decoder)
+    MAPLE_BUS_ERROR_BIT_TIMING,
+    //! A packet ended with a different number of bytes than its frame word called for (never reported by the decoder)
+    MAPLE_BUS_ERROR_LENGTH_MISMATCH,
+    //! A packet of the expected length whose CRC byte didn't match (never reported by the decoder)
+    MAPLE_BUS_ERROR_BAD_CRC,
+    //! Number of error types
+    MAPLE_BUS_NUM_ERROR_TYPES
+};
+
+//! A decode failure
+struct MapleBusDecodeError
+{
+    //! What failed; one of the first four MapleBusErrorType values
+    MapleBusErrorType type;
+    //! The sample number where the failure was detected
+    U64 sample;
+    //! The sample number where the failed sequence or packet began
+    U64 startSample;
+    //! The number of bytes of the packet received before the failure
+    U32 byteIndex;
+    //! The index of the bit within the byte being received
+    U32 bitIndex;
+    //! The number of edges the protocol allows at this point: SDCKB edges of the start sequence, data edges of the
+    //! current bit, or SDCKA edges of the end sequence; for MAPLE_BUS_ERROR_BIT_TIMING, the nominal bit period in samples
+    U32 expectedEdges;
+    //! The number of those edges observed; for MAPLE_BUS_ERROR_BIT_TIMING, the observed bit period in samples
+    U32 observedEdges;
+};
+
+//! A single sampled bit
+struct MapleBusDecodedBit
+{
+    //! The sample number of the clock edge where the bit was sampled
+    U64 clockEdgeSample;
+    //! true iff SDCKA was the clock for this bit
+    bool clockIsA;
+    //! The sampled bit value
+    bool value;
+};
+
+//! A single decoded byte
+struct MapleBusDecodedByte
+{
+    //! The sample number where the first bit of this byte was read
+    U64 startSample;
+    //! The sample number of the clock edge of the last bit of this byte
+    U64 endSample;
+    //! The value of this byte
+    U8 value;
+    //! The number of bytes sampled in the current packet, including this one
+    U32 byteCount;
+    //! The number of bytes expected to follow this one in the current packet
+    S32 numBytesLeft;
+    //! The classification of this byte
+    MapleBusDataType type;
+    //! MAPLE_BUS_DATA_CRC only: true iff this is the expected CRC byte and it matches the XOR of every byte before it
+    bool crcValid;
+};
+
+//! A single decoded 32-bit word
+struct MapleBusDecodedWord
+{
+    //! The sample number where the first bit of this word was read
+    U64 startSample;
+    //! The sample number of the clock edge of the last bit of this word
+    U64 endSample;
+    //! The value of this word (built little endian)
+    U32 value;
+    //! The number of words expected to follow this one in the current packet
+    S32 numWordsLeft;
+    //! The classification of this word
+    MapleBusDataType type;
+};
+
+//! Bit timing of a packet in samples, accumulated in constant time as each bit is sampled. A bit period is the time
+//! between the clock edges of consecutive bits; the setup time of a bit is the time from its data edge to its clock edge.
+struct MapleBusBitTiming
+{
+    //! Number of bit periods measured
+    U32 numPeriods;
+    //! Shortest bit period
+    U32 minPeriod;
+    //! Longest bit period
+    U32 maxPeriod;
+    //! Shortest setup time of any bit with a data edge, or NO_SETUP if no bit had one
+    U32 minSetup;
+    //! Number of bit periods outside the timing tolerance (MAPLE_BUS_TIMING_FLAG only)
+    U32 numOutOfTolerance;
+    //! The nominal bit period learned from the start sequence, or 0 if bit periods weren't checked; when merged, the
+    //! latest packet's
+    U32 nominalPeriod;
+    //! Sum of every bit period
+    U64 sumPeriods;
+    //! Sum of the square of every bit period
+    U64 sumSquaredPeriods;
+
+    //! minSetup value before any setup time is measured
+    static const U32 NO_SETUP = 0xFFFFFFFF;
+
+    //! Resets to no measurements
+    void Clear();
+    //! Adds the measurements of another packet
+    void Merge(const MapleBusBitTiming& other);
+    //! @returns the mean bit period, or 0 if no period was measured
+    double GetMeanPeriod() const;
+    //! @returns the standard deviation of the bit period, or 0 if no period was measured
+    double GetJitter() const;
+};
+
+//! A complete decoded packet
+struct MapleBusPacket
+{
+    //! The sample number of the start of the start sequence
+    U64 startSample;
+    //! The sample number of the end of the start sequence where the first bit begins
+    U64 dataStartSample;
+    //! The sample number of the end of the end sequence
+    U64 endSample;
+    //! All bytes received in this packet, including the CRC byte
+    std::vector<U8> bytes;
+    //! The sample number of the clock edge of the last bit of each byte
+    std::vector<U64> byteEndSamples;
+    //! true iff the expected CRC byte was received and it matches the XOR of every byte before it
+    bool crcValid;
+    //! Bit timing of every bit received
+    MapleBusBitTiming timing;
+};
+
+//! Receives decoded data from a MapleBusDecoder
+class MapleBusDecoderListener
+{
+  public:
+    //! Destructor
+    virtual ~MapleBusDecoderListener()
+    {
+    }
+
+    //! Called when a valid start sequence is detected
+    //! @param[in] startSample  sample number of the start of the start sequence
+    //! @param[in] endSample  sample number of the end of the start sequence
+    virtual void OnPacketStart(U64 startSample, U64 endSample)
+    {
+    }
+    //! Called each time a bit is sampled
+    //! @param[in] clockEdgeSample  the sample number of the clock edge where the bit was sampled
+    //! @param[in] clockIsA  true iff SDCKA was the clock for this bit
+    //! @param[in] value  the sampled bit value
+    virtual void OnBit(U64 clockEdgeSample, bool clockIsA, bool value)
+    {
+    }
+    //! Called each time a byte is completed
+    virtual void OnByte(const MapleBusDecodedByte& decodedByte)
+    {
+    }
+    //! Called each time a 32-bit word is completed
+    virtual void OnWord(const MapleBusDecodedWord& decodedWord)
+    {
+    }
+    //! Called when a valid end sequence is detected
+    virtual void OnPacketEnd(const MapleBusPacket& packet)
+    {
+    }
+    //! Called when an unexpected sequence is detected. Start sequences which fail before the next valid start sequence
+    //! are part of the same error and aren't reported again.
+    //! @param[in] error  what failed and where
+    virtual void OnError(const MapleBusDecodeError& error)
+    {
+    }
+    //! Called when the first valid start sequence after an error is detected, just before OnPacketStart(); nothing
+    //! between the two samples was decoded
+    //! @param[in] errorSample  the sample number of the error given to OnError()
+    //! @param[in] resumeSample  the sample number where both lines were last high before the start sequence
+    virtual void OnResync(U64 errorSample, U64 resumeSample)
+    {
+    }
+};
+
+//! Decodes Maple Bus packets out of a merged transition stream, independent of Saleae's SDK.
+//! Each transition is visited exactly once, so decoding is a single linear pass over the edges of both lines. While
+//! waiting for the next start sequence, which only SDCKA can begin, Run() lets the source skip SDCKB's edges.
+class MapleBusDecoder
+{
+  public:
+    //! Constructor
+    //! @param[in] listener  receives all decoded data
+    MapleBusDecoder(MapleBusDecoderListener* listener);
+    //! Destructor
+    virtual ~MapleBusDecoder();
+
+    //! Sets which bits are reported to the listener; MAPLE_BUS_BITS_ALL by default
+    //! @param[in] bitReporting  the bits to report
+    void SetBitReporting(MapleBusBitReporting bitReporting);
+    //! Sets whether each bit period is checked against the nominal bit period learned from the packet's start sequence;
+    //! MAPLE_BUS_TIMING_OFF by default. SDCKB's start sequence edges are a phase apart, and a bit takes 3 phases.
+    //! @param[in] check  what to do with a bit period outside tolerance
+    //! @param[in] tolerancePercent  how far a bit period may be from nominal, in percent of the nominal bit period; one
+    //!                              more sample is always allowed for sampling error
+    void SetTimingCheck(MapleBusTimingCheck check, U32 tolerancePercent);
+
+    //! Resets all decoder state
+    //! @param[in] lines  the state of both lines where decoding begins (see MapleBusLineMask)
+    void Reset(U8 lines);
+    //! Resets the decoder then decodes every transition of the given source
+    //! @param[in] source  the transitions to decode
+    void Run(MapleBusTransitionSource* source);
+    //! Decodes the next transition
+    //! @param[in] transition  the next transition; must not precede the previous transition
+    void ProcessTransition(const MapleBusTransition& transition);
+    //! @returns true iff both lines are high, and neither a packet nor an error is in progress; decoding from here on is
+    //!          the same as decoding after Reset(MAPLE_BUS_LINES_AB)
+    bool IsIdle() const;
+    //! Checks whether decoding is only waiting to report the end of an error: decoding from here on is the same as
+    //! decoding after Reset(MAPLE_BUS_LINES_AB), except that OnResync() is reported before the next packet starts
+    //! @param[out] errorSample  set to the error sample OnResync() will report
+    //! @param[out] resumeSample  set to the resume sample OnResync() will report if the next start sequence is valid
+    //! @returns true iff both lines are high, no packet is in progress and an error has not yet been resynced
+    bool GetPendingResync(U64& errorSample, U64& resumeSample) const;
+
+  private:
+    //! Decoder states
+    enum State
+    {
+        //! Waiting for both lines to be high
+        STATE_WAIT_NEUTRAL,
+        //! Both lines were high; waiting for SDCKA to fall
+        STATE_NEUTRAL,
+        //! SDCKA is low; counting SDCKB edges of the start sequence
+        STATE_START,
+        //! Sampling bits
+        STATE_DATA,
+        //! Counting SDCKA edges of the end sequence
+        STATE_END
+    };
+
+    //! Resets all packet state data
+    void ResetPacketData();
+    //! Sets the nominal bit period and the bit periods within tolerance from the start sequence just received
+    void LearnBitPeriod();
+    //! Reports an error and goes back to waiting for the next start sequence
+    //! @param[in] type  what failed
+    //! @param[in] sample  the sample number where the error was detected
+    //! @param[in] expectedEdges  the number of edges the protocol allows at this point
+    //! @param[in] observedEdges  the number of those edges observed
+    //! @param[in] currentSample  the sample number of the current transition
+    void HandleError(MapleBusErrorType type, U64 sample, U32 expectedEdges, U32 observedEdges, U64 currentSample);
+    //! Goes back to waiting for the next start sequence
+    //! @param[in] currentSample  the sample number of the current transition; where decoding resumes after errors
+    void WaitForNeutral(U64 currentSample);
+    //! @returns true iff only a change of SDCKA can affect the current state
+    bool IsWaitingForA() const;
+    //! Processes a transition while sampling bits
+    //! @param[in] transition  the current transition
+    //! @param[in] changed  the lines which changed state at this transition
+    void ProcessDataTransition(const MapleBusTransition& transition, U8 changed);
+    //! Reports a sampled bit according to the bit reporting setting
+    //! @param[in] clockEdgeSample  the sample number of the clock edge where the bit was sampled
+    //! @param[in] clockIsA  true iff SDCKA was the clock for this bit
+    //! @param[in] value  the sampled bit value
+    void ReportBit(U64 clockEdgeSample, bool clockIsA, bool value);
+    //! Saves the next byte
+    //! @param[in] startingSample  the starting sample number where the first bit of this byte was read
+    //! @param[in] endingSample  the sample number of the clock edge of the last bit of this byte
+    //! @param[in] theByte  value of the byte to save
+    void SaveByte(U64 startingSample, U64 endingSample, U8 theByte);
+    //! @returns the XOR of the 4 bytes of a word
+    static U8 FoldCrc(U32 word);
+
+  private:
+    //! Receives all decoded data
+    MapleBusDecoderListener* mListener;
+    //! Which bits are reported to mListener
+    MapleBusBitReporting mBitReporting;
+    //! What to do with a bit period outside tolerance
+    MapleBusTimingCheck mTimingCheck;
+    //! How far a bit period may be from nominal, in percent
+    U32 mTolerancePercent;
+    //! Current decoder state
+    State mState;
+    //! Current state of both lines
+    U8 mLines;
+    //! true from an error until the next valid start sequence
+    bool mResyncing;
+    //! The sample number of the error being resynchronised from
+    U64 mErrorSample;
+    //! The sample number where both lines were last high while resynchronising
+    U64 mResumeSample;
+
+    // Sequence state variables
+    //
+    //! Sample number where the current start sequence began
+    U64 mStartSample;
+    //! Edges counted for the current sequence: SDCKB edges of the start sequence, data edges of the current bit, or
+    //! SDCKA edges of the end sequence
+    U32 mNumEdges;
+    //! Index of the current bit within the current byte; SDCKA is the clock for even bits
+    U32 mBitIndex;
+    //! The bits of the current byte sampled so far
+    U8 mCurrentByte;
+    //! The sample number where the first bit of the current byte was read
+    U64 mByteStartingSample;
+    //! The sample number of the latest data edge of the current bit
+    U64 mDataEdgeSample;
+    //! The sample number of the clock edge of the previous bit
+    U64 mClockEdgeSample;
+    //! The sample number of the first SDCKB edge of the current start sequence
+    U64 mFirstStartEdgeSample;
+    //! The sample number of the latest SDCKB edge of the current start sequence
+    U64 mLastStartEdgeSample;
+    //! Shortest bit period within tolerance for the current packet
+    U32 mMinBitPeriod;
+    //! Longest bit period within tolerance for the current packet
+    U32 mMaxBitPeriod;
+
+    // Packet state variables
+    //
+    //! Total number of bytes expected in the current packet
+    S32 mTotalBytesExpected;
+    //! Total number of 32-bit words expected in the current packet
+    S32 mTotalWordsExpected;
+    //! Expected number of bytes left to sample in the current packet
+    S32 mNumBytesLeftExpected;
+    //! Expected number of 32-bit words left to sample in the current packet
+    S32 mNumWordsLeftExpected;
+    //! Number of bytes sampled in the current packet
+    U32 mByteCount;
+    //! The current 32-bit word state of this packet
+    U32 mCurrentWord;
+    //! The sample number of the start of the current word
+    U64 mWordStartingSample;
+    //! XOR of every completed word of this packet; folded down to a byte only when the CRC byte arrives
+    U32 mCrcAccumulator;
+    //! The packet currently being decoded
+    MapleBusPacket mPacket;
+    //! Bits of the current packet held back until the packet fails (MAPLE_BUS_BITS_ON_ERROR only)
+    std::vector<MapleBusDecodedBit> mPendingBits;
+};
+
+#endif // MAPLEBUS_DECODER_H
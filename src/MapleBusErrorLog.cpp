@@ -0,0 +1,188 @@
+#include "MapleBusErrorLog.h"
+#include <stdio.h>
+
+//! Number of bytes in a word
+static const U32 WORD_BYTES = 4;
+
+//! Largest edge count a record holds
+static const U32 MAX_RECORD_EDGES = 0xFF;
+
+//! Name of each error type, indexed by MapleBusErrorType
+static const char* const ERROR_TYPE_NAMES[MAPLE_BUS_NUM_ERROR_TYPES] = {
+    "Start sequence", "Data edges", "End sequence", "Bit timing", "Length mismatch", "Bad CRC"};
+
+MapleBusErrorLog::MapleBusErrorLog() : mErrors(), mNumSkippedSamples(0)
+{
+    for (U32 i = 0; i < MAPLE_BUS_NUM_ERROR_TYPES; ++i)
+    {
+        mCounts[i] = 0;
+    }
+}
+
+MapleBusErrorLog::~MapleBusErrorLog()
+{
+}
+
+void MapleBusErrorLog::Clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mErrors.Clear();
+    for (U32 i = 0; i < MAPLE_BUS_NUM_ERROR_TYPES; ++i)
+    {
+        mCounts[i] = 0;
+    }
+    mNumSkippedSamples = 0;
+}
+
+void MapleBusErrorLog::SetMaxErrors(U64 maxErrors)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mErrors.SetMaxItems(maxErrors);
+}
+
+U64 MapleBusErrorLog::AddError(const MapleBusDecodeError& error)
+{
+    MapleBusErrorRecord record;
+    record.startSample = error.startSample;
+    record.sample = error.sample;
+    record.resumeSample = error.sample;
+    record.byteIndex = error.byteIndex;
+    record.type = static_cast<U8>(error.type);
+    record.bitIndex = static_cast<U8>(error.bitIndex);
+    record.expectedEdges = static_cast<U8>((error.expectedEdges < MAX_RECORD_EDGES) ? error.expectedEdges : MAX_RECORD_EDGES);
+    record.observedEdges = static_cast<U8>((error.observedEdges < MAX_RECORD_EDGES) ? error.observedEdges : MAX_RECORD_EDGES);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (error.type < MAPLE_BUS_NUM_ERROR_TYPES)
+    {
+        ++mCounts[error.type];
+    }
+    U64 errorIndex = mErrors.Add(record);
+    mErrors.Trim();
+    return errorIndex;
+}
+
+void MapleBusErrorLog::EndError(U64 resumeSample)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::vector<MapleBusErrorRecord>& errors = mErrors.GetRetained();
+    if (!errors.empty() && resumeSample > errors.back().resumeSample)
+    {
+        mNumSkippedSamples += resumeSample - errors.back().resumeSample;
+        errors.back().resumeSample = resumeSample;
+    }
+}
+
+MapleBusErrorType MapleBusErrorLog::CountPacket(const MapleBusPacket& packet)
+{
+    MapleBusErrorType type = MAPLE_BUS_NUM_ERROR_TYPES;
+    if (packet.bytes.empty() || packet.bytes.size() != packet.bytes[0] * WORD_BYTES + WORD_BYTES + 1)
+    {
+        type = MAPLE_BUS_ERROR_LENGTH_MISMATCH;
+    }
+    else if (!packet.crcValid)
+    {
+        type = MAPLE_BUS_ERROR_BAD_CRC;
+    }
+    else if (packet.timing.numOutOfTolerance > 0)
+    {
+        type = MAPLE_BUS_ERROR_BIT_TIMING;
+    }
+
+    if (type != MAPLE_BUS_NUM_ERROR_TYPES)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        ++mCounts[type];
+    }
+    return type;
+}
+
+U64 MapleBusErrorLog::GetNumErrors() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mErrors.GetNumItems();
+}
+
+U64 MapleBusErrorLog::GetFirstErrorIndex() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mErrors.GetFirstIndex();
+}
+
+bool MapleBusErrorLog::GetError(U64 errorIndex, MapleBusErrorRecord& record) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    const MapleBusErrorRecord* found = mErrors.Find(errorIndex);
+    if (found == NULL)
+    {
+        return false;
+    }
+    record = *found;
+    return true;
+}
+
+U64 MapleBusErrorLog::GetCount(MapleBusErrorType type) const
+{
+    if (type >= MAPLE_BUS_NUM_ERROR_TYPES)
+    {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mCounts[type];
+}
+
+U64 MapleBusErrorLog::GetNumSkippedSamples() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mNumSkippedSamples;
+}
+
+U64 MapleBusErrorLog::GetMemoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mErrors.GetMemoryUsage();
+}
+
+void MapleBusErrorLog::GetTypeString(MapleBusErrorType type, char* str, size_t len)
+{
+    if (type < MAPLE_BUS_NUM_ERROR_TYPES)
+    {
+        snprintf(str, len, "%s", ERROR_TYPE_NAMES[type]);
+    }
+    else
+    {
+        snprintf(str, len, "Error %u", static_cast<U32>(type));
+    }
+}
+
+void MapleBusErrorLog::GetDescription(const MapleBusErrorRecord& record, char* str, size_t len)
+{
+    char typeStr[32];
+    GetTypeString(static_cast<MapleBusErrorType>(record.type), typeStr, sizeof(typeStr));
+
+    switch (record.type)
+    {
+    case MAPLE_BUS_ERROR_START_SEQUENCE:
+        snprintf(str, len, "%s: %u of %u edges", typeStr, record.observedEdges, record.expectedEdges);
+        break;
+
+    case MAPLE_BUS_ERROR_END_SEQUENCE:
+        snprintf(str, len, "%s: %u of %u edges (after byte %u)", typeStr, record.observedEdges, record.expectedEdges,
+                 record.byteIndex);
+        break;
+
+    case MAPLE_BUS_ERROR_DATA_EDGES:
+        snprintf(str, len, "%s: %u of %u expected (byte %u bit %u)", typeStr, record.observedEdges, record.expectedEdges,
+                 record.byteIndex, record.bitIndex);
+        break;
+
+    case MAPLE_BUS_ERROR_BIT_TIMING:
+        snprintf(str, len, "%s: period %u samples for %u nominal (byte %u bit %u)", typeStr, record.observedEdges,
+                 record.expectedEdges, record.byteIndex, record.bitIndex);
+        break;
+
+    default:
+        snprintf(str, len, "%s", typeStr);
+        break;
+    }
+}
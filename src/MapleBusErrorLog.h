@@ -0,0 +1,99 @@
+#ifndef MAPLEBUS_ERROR_LOG_H
+#define MAPLEBUS_ERROR_LOG_H
+
+#include "MapleBusDecoder.h"
+#include "MapleBusRetainedRing.h"
+#include <mutex>
+#include <stddef.h>
+#include <vector>
+
+//! One stored decode failure
+struct MapleBusErrorRecord
+{
+    //! The sample number where the failed sequence or packet began
+    U64 startSample;
+    //! The sample number where the failure was detected
+    U64 sample;
+    //! The sample number where decoding resumed (see MapleBusDecoderListener::OnResync()); equal to sample until then
+    U64 resumeSample;
+    //! The number of bytes of the packet received before the failure
+    U32 byteIndex;
+    //! What failed (see MapleBusErrorType)
+    U8 type;
+    //! The index of the bit within the byte being received
+    U8 bitIndex;
+    //! The number of edges the protocol allows at this point, or the nominal bit period (see
+    //! MapleBusDecodeError::expectedEdges), saturated at 255
+    U8 expectedEdges;
+    //! The number of those edges observed, or the observed bit period, saturated at 255
+    U8 observedEdges;
+};
+
+//! Keeps a fixed size record of every decode failure along with counts of each error type, including faulty packets
+//! which decoded but don't hold what their frame word called for. The number of records retained may be limited like
+//! MapleBusPacketStore's packets; the counts always cover every error. All methods may be called from any thread.
+class MapleBusErrorLog
+{
+  public:
+    //! Constructor
+    MapleBusErrorLog();
+    //! Destructor
+    virtual ~MapleBusErrorLog();
+
+    //! Removes all errors and counts
+    void Clear();
+    //! Limits the number of error records retained, the same way as MapleBusPacketStore::SetMaxPackets()
+    //! @param[in] maxErrors  the least number of most recent records to retain, 0 to retain every record
+    void SetMaxErrors(U64 maxErrors);
+    //! Stores a decode failure
+    //! @param[in] error  the failure reported by the decoder
+    //! @returns the index of the stored error
+    U64 AddError(const MapleBusDecodeError& error);
+    //! Records where decoding resumed after the latest error
+    //! @param[in] resumeSample  the sample number given to MapleBusDecoderListener::OnResync()
+    void EndError(U64 resumeSample);
+    //! Counts a completed packet under MAPLE_BUS_ERROR_LENGTH_MISMATCH, MAPLE_BUS_ERROR_BAD_CRC or, if it holds bits
+    //! flagged outside the timing tolerance, MAPLE_BUS_ERROR_BIT_TIMING; the first which applies
+    //! @param[in] packet  the completed packet
+    //! @returns the packet's error type, or MAPLE_BUS_NUM_ERROR_TYPES if it isn't faulty
+    MapleBusErrorType CountPacket(const MapleBusPacket& packet);
+
+    //! @returns the number of decode failures stored since the last Clear(), including any no longer retained
+    U64 GetNumErrors() const;
+    //! @returns the index of the oldest retained decode failure
+    U64 GetFirstErrorIndex() const;
+    //! Retrieves a stored decode failure
+    //! @param[in] errorIndex  the index of the error
+    //! @param[out] record  set to the error record
+    //! @returns false iff errorIndex is out of range or no longer retained
+    bool GetError(U64 errorIndex, MapleBusErrorRecord& record) const;
+    //! @returns the number of errors of the given type, counting faulty packets as well as decode failures
+    U64 GetCount(MapleBusErrorType type) const;
+    //! @returns the total number of samples between each decode failure and where decoding resumed
+    U64 GetNumSkippedSamples() const;
+    //! @returns the approximate number of bytes allocated by this log
+    U64 GetMemoryUsage() const;
+
+    //! Retrieves the name of an error type
+    //! @param[in] type  the error type
+    //! @param[out] str  output string buffer
+    //! @param[in] len  byte length of str
+    static void GetTypeString(MapleBusErrorType type, char* str, size_t len);
+    //! Describes a decode failure without any commas, such as "Data edges: 3 of 1 expected (byte 12 bit 5)"
+    //! @param[in] record  the error record
+    //! @param[out] str  output string buffer
+    //! @param[in] len  byte length of str
+    static void GetDescription(const MapleBusErrorRecord& record, char* str, size_t len);
+
+  private:
+    //! Guards all data; the analyzer adds errors while the UI renders them
+    mutable std::mutex mMutex;
+    //! One record per retained decode failure
+    MapleBusRetainedRing<MapleBusErrorRecord> mErrors;
+    //! Number of errors of each type
+    U64 mCounts[MAPLE_BUS_NUM_ERROR_TYPES];
+    //! Total number of samples skipped after decode failures
+    U64 mNumSkippedSamples;
+};
+
+#endif // MAPLEBUS_ERROR_LOG_H
@@ -0,0 +1,129 @@
+#include "MapleBusExportPipeline.h"
+#include <thread>
+
+//! Number of slots per thread so that each thread has its next block waiting while the previous one is written
+static const U32 SLOTS_PER_THREAD = 2;
+//! Initial byte size of each slot's text; doubles as needed, so it grows to a block's text once and is then reused
+static const size_t SLOT_BUFFER_SIZE = 64 * 1024;
+
+MapleBusExportPipeline::MapleBusExportPipeline(U32 numThreads)
+    : mNumThreads(numThreads), mSlotText(), mSlotDone(), mQueue(), mStopping(false)
+{
+    if (mNumThreads == 0)
+    {
+        mNumThreads = std::thread::hardware_concurrency();
+        if (mNumThreads == 0)
+        {
+            mNumThreads = 1;
+        }
+    }
+
+    // Slot text is only allocated once a run needs the slot, so that a small export doesn't allocate for every slot
+    mSlotText.assign(mNumThreads * SLOTS_PER_THREAD, NULL);
+    mSlotDone.assign(mSlotText.size(), false);
+}
+
+MapleBusExportPipeline::~MapleBusExportPipeline()
+{
+    for (size_t i = 0; i < mSlotText.size(); ++i)
+    {
+        delete mSlotText[i];
+    }
+}
+
+U32 MapleBusExportPipeline::GetNumSlots() const
+{
+    return static_cast<U32>(mSlotText.size());
+}
+
+bool MapleBusExportPipeline::Run(MapleBusExportBlockFormatter* formatter, U64 numBlocks, MapleBusExportWriter& output)
+{
+    // Slots beyond the number of blocks would never be used
+    U64 numSlots = (numBlocks < mSlotText.size()) ? numBlocks : mSlotText.size();
+    for (U64 i = 0; i < numSlots; ++i)
+    {
+        if (mSlotText[i] == NULL)
+        {
+            mSlotText[i] = new MapleBusExportWriter(SLOT_BUFFER_SIZE);
+        }
+    }
+    mQueue.clear();
+    mStopping = false;
+
+    std::vector<std::thread> threads;
+    for (U32 i = 0; i < mNumThreads && i < numBlocks; ++i)
+    {
+        threads.push_back(std::thread(&MapleBusExportPipeline::WorkerThread, this, formatter));
+    }
+
+    bool cancelled = false;
+    U64 nextPrepare = 0;
+    for (U64 nextWrite = 0; nextWrite < numBlocks && !cancelled; ++nextWrite)
+    {
+        // Keep every slot busy
+        for (; nextPrepare < numBlocks && nextPrepare - nextWrite < numSlots; ++nextPrepare)
+        {
+            U32 slot = static_cast<U32>(nextPrepare % numSlots);
+            mSlotText[slot]->ClearBufferedText();
+            formatter->PrepareBlock(nextPrepare, slot);
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            mSlotDone[slot] = false;
+            mQueue.push_back(slot);
+            mQueueCondition.notify_one();
+        }
+
+        U32 slot = static_cast<U32>(nextWrite % numSlots);
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            while (!mSlotDone[slot])
+            {
+                mSlotDoneCondition.wait(lock);
+            }
+        }
+
+        output.AddString(mSlotText[slot]->GetBufferedText(), mSlotText[slot]->GetNumBufferedBytes());
+        cancelled = formatter->OnBlockWritten(nextWrite + 1);
+    }
+
+    {
+        // Blocks still queued after a cancel are dropped
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+        mQueue.clear();
+        mQueueCondition.notify_all();
+    }
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i].join();
+    }
+
+    return !cancelled;
+}
+
+void MapleBusExportPipeline::WorkerThread(MapleBusExportBlockFormatter* formatter)
+{
+    while (true)
+    {
+        U32 slot = 0;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            while (!mStopping && mQueue.empty())
+            {
+                mQueueCondition.wait(lock);
+            }
+            if (mStopping)
+            {
+                return;
+            }
+            slot = mQueue.front();
+            mQueue.pop_front();
+        }
+
+        formatter->FormatBlock(slot, *mSlotText[slot]);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mSlotDone[slot] = true;
+        mSlotDoneCondition.notify_all();
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef MAPLEBUS_EXPORT_PIPELINE_H
+#define MAPLEBUS_EXPORT_PIPELINE_H
+
+#include "MapleBusExportWriter.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+//! Prepares and formats the blocks of an export for MapleBusExportPipeline
+class MapleBusExportBlockFormatter
+{
+  public:
+    //! Destructor
+    virtual ~MapleBusExportBlockFormatter()
+    {
+    }
+
+    //! Gathers everything a block needs to be formatted. Called in block order, always from the thread which calls
+    //! MapleBusExportPipeline::Run(), so anything which isn't safe to call concurrently belongs here.
+    //! @param[in] blockIndex  the index of the block
+    //! @param[in] slot  where to keep what was gathered; the slot is reused once the block is formatted
+    virtual void PrepareBlock(U64 blockIndex, U32 slot) = 0;
+    //! Formats a prepared block. Called from a worker thread, concurrently with other slots.
+    //! @param[in] slot  the slot given to PrepareBlock()
+    //! @param[out] text  the writer to format into; holds the text in memory
+    virtual void FormatBlock(U32 slot, MapleBusExportWriter& text) = 0;
+    //! Called each time a block has been written, always from the thread which calls MapleBusExportPipeline::Run()
+    //! @param[in] numBlocksWritten  the number of blocks written so far
+    //! @returns true to cancel the export
+    virtual bool OnBlockWritten(U64 numBlocksWritten) = 0;
+};
+
+//! Formats an export in blocks across multiple threads and writes the blocks out in order, as if formatted serially.
+//! Only a couple of blocks per thread are in flight at once, so memory stays bounded however large the export, and no
+//! more threads or slot buffers are used than there are blocks.
+class MapleBusExportPipeline
+{
+  public:
+    //! Constructor
+    //! @param[in] numThreads  the number of formatting threads, 0 for one per hardware thread
+    MapleBusExportPipeline(U32 numThreads);
+    //! Destructor
+    virtual ~MapleBusExportPipeline();
+
+    //! @returns the number of slots blocks are prepared into; slots given to the formatter are less than this
+    U32 GetNumSlots() const;
+    //! Prepares, formats and writes every block
+    //! @param[in] formatter  prepares and formats each block
+    //! @param[in] numBlocks  the number of blocks to export
+    //! @param[in] output  the writer to write formatted blocks to, in block order
+    //! @returns false iff the formatter cancelled the export
+    bool Run(MapleBusExportBlockFormatter* formatter, U64 numBlocks, MapleBusExportWriter& output);
+
+  private:
+    //! Formats queued slots until stopped; run by each worker thread
+    void WorkerThread(MapleBusExportBlockFormatter* formatter);
+
+    //! Number of formatting threads
+    U32 mNumThreads;
+    //! Formatted text of each slot, or NULL until a run uses the slot
+    std::vector<MapleBusExportWriter*> mSlotText;
+    //! Set for each slot once formatted
+    std::vector<bool> mSlotDone;
+    //! Slots which are prepared and waiting to be formatted, in block order
+    std::deque<U32> mQueue;
+    //! Set when worker threads should exit
+    bool mStopping;
+    //! Guards mSlotDone, mQueue and mStopping
+    std::mutex mMutex;
+    //! Signaled each time a slot is queued or the workers should stop
+    std::condition_variable mQueueCondition;
+    //! Signaled each time a slot is formatted
+    std::condition_variable mSlotDoneCondition;
+};
+
+#endif // MAPLEBUS_EXPORT_PIPELINE_H
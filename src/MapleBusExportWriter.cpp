@@ -0,0 +1,186 @@
+#include "MapleBusExportWriter.h"
+#include "MapleBusNumberFormat.h"
+#include <string.h>
+
+MapleBusExportWriter::MapleBusExportWriter(size_t bufferSize)
+    : mFile(NULL),
+      mBuffer(bufferSize > 0 ? bufferSize : 1),
+      mBufferPos(0),
+      mNumBytesFlushed(0),
+      mTimeSampleRateHz(0),
+      mTimeDecimalPlaces(0),
+      mWriteOk(false)
+{
+}
+
+MapleBusExportWriter::~MapleBusExportWriter()
+{
+    Close();
+}
+
+bool MapleBusExportWriter::Open(const char* path)
+{
+    Close();
+
+    mFile = fopen(path, "wb");
+    if (mFile == NULL)
+    {
+        return false;
+    }
+    // Already buffered here
+    setvbuf(mFile, NULL, _IONBF, 0);
+
+    mBufferPos = 0;
+    mNumBytesFlushed = 0;
+    mWriteOk = true;
+    return true;
+}
+
+bool MapleBusExportWriter::Close()
+{
+    if (mFile == NULL)
+    {
+        return false;
+    }
+
+    Flush();
+    if (fclose(mFile) != 0)
+    {
+        mWriteOk = false;
+    }
+    mFile = NULL;
+    return mWriteOk;
+}
+
+bool MapleBusExportWriter::WritePending()
+{
+    if (mFile == NULL)
+    {
+        return false;
+    }
+
+    Flush();
+    return mWriteOk;
+}
+
+void MapleBusExportWriter::AddString(const char* str)
+{
+    AddString(str, strlen(str));
+}
+
+void MapleBusExportWriter::AddString(const char* str, size_t len)
+{
+    while (len > 0)
+    {
+        if (mBufferPos >= mBuffer.size())
+        {
+            Flush();
+        }
+        size_t numBytes = mBuffer.size() - mBufferPos;
+        numBytes = (len < numBytes) ? len : numBytes;
+        memcpy(&mBuffer[mBufferPos], str, numBytes);
+        mBufferPos += numBytes;
+        str += numBytes;
+        len -= numBytes;
+    }
+}
+
+void MapleBusExportWriter::AddHex(U64 value, U32 numBits)
+{
+    char* dest = Reserve(MapleBusNumberFormat::MAX_HEX_CHARS);
+    mBufferPos += MapleBusNumberFormat::FormatHex(value, numBits, dest);
+}
+
+void MapleBusExportWriter::AddDecimal(U64 value)
+{
+    char* dest = Reserve(MapleBusNumberFormat::MAX_DECIMAL_CHARS);
+    mBufferPos += MapleBusNumberFormat::FormatDecimal(value, dest);
+}
+
+void MapleBusExportWriter::AddTime(U64 sample, U64 triggerSample, U32 sampleRateHz)
+{
+    U64 offset = (sample >= triggerSample) ? (sample - triggerSample) : (triggerSample - sample);
+    if (sample < triggerSample)
+    {
+        AddChar('-');
+    }
+    if (sampleRateHz == 0)
+    {
+        AddDecimal(offset);
+        return;
+    }
+
+    if (sampleRateHz != mTimeSampleRateHz)
+    {
+        // Enough places that consecutive samples never print the same time
+        mTimeSampleRateHz = sampleRateHz;
+        mTimeDecimalPlaces = 0;
+        for (U64 scale = 1; scale < sampleRateHz; scale *= 10)
+        {
+            ++mTimeDecimalPlaces;
+        }
+    }
+
+    AddDecimal(offset / sampleRateHz);
+    if (mTimeDecimalPlaces > 0)
+    {
+        // Long division one place at a time; the remainder always fits since it is less than the sample rate
+        U64 remainder = offset % sampleRateHz;
+        char* dest = Reserve(1 + mTimeDecimalPlaces);
+        dest[0] = '.';
+        for (U32 i = 1; i <= mTimeDecimalPlaces; ++i)
+        {
+            remainder *= 10;
+            dest[i] = static_cast<char>('0' + remainder / sampleRateHz);
+            remainder = remainder % sampleRateHz;
+        }
+        mBufferPos += 1 + mTimeDecimalPlaces;
+    }
+}
+
+U64 MapleBusExportWriter::GetNumBytesWritten() const
+{
+    return mNumBytesFlushed + mBufferPos;
+}
+
+const char* MapleBusExportWriter::GetBufferedText() const
+{
+    return &mBuffer[0];
+}
+
+size_t MapleBusExportWriter::GetNumBufferedBytes() const
+{
+    return mBufferPos;
+}
+
+void MapleBusExportWriter::ClearBufferedText()
+{
+    mBufferPos = 0;
+    mNumBytesFlushed = 0;
+}
+
+char* MapleBusExportWriter::Reserve(size_t numBytes)
+{
+    if (mBufferPos + numBytes > mBuffer.size())
+    {
+        Flush();
+    }
+    return &mBuffer[mBufferPos];
+}
+
+void MapleBusExportWriter::Flush()
+{
+    if (mFile == NULL)
+    {
+        mBuffer.resize(mBuffer.size() * 2);
+    }
+    else if (mBufferPos > 0)
+    {
+        if (fwrite(&mBuffer[0], 1, mBufferPos, mFile) != mBufferPos)
+        {
+            mWriteOk = false;
+        }
+        mNumBytesFlushed += mBufferPos;
+        mBufferPos = 0;
+    }
+}
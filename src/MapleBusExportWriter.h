@@ -0,0 +1,97 @@
+#ifndef MAPLEBUS_EXPORT_WRITER_H
+#define MAPLEBUS_EXPORT_WRITER_H
+
+#include <LogicPublicTypes.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <vector>
+
+namespace MapleBusExportFile
+{
+    //! Byte size of the write buffer; large so that writes reach the disk in big blocks
+    const U32 BUFFER_SIZE = 1024 * 1024;
+}
+
+//! Writes text export files. Text is formatted directly into one large reusable buffer which is only written out when
+//! full, so nothing is flushed per field or per line. Hex, decimal and time values are formatted here rather than
+//! through snprintf; anything else may be formatted by the caller and added as a string. While no file is open, the
+//! buffer grows to hold all text in memory instead, so that blocks of an export may be formatted separately.
+class MapleBusExportWriter
+{
+  public:
+    //! Constructor
+    //! @param[in] bufferSize  the initial byte size of the buffer; it grows as needed while no file is open
+    MapleBusExportWriter(size_t bufferSize = MapleBusExportFile::BUFFER_SIZE);
+    //! Destructor; writes anything pending and closes the file if still open
+    virtual ~MapleBusExportWriter();
+
+    //! Creates the file
+    //! @param[in] path  the file path to write
+    //! @returns false iff the file could not be created
+    bool Open(const char* path);
+    //! Writes anything pending and closes the file
+    //! @returns false iff any write failed
+    bool Close();
+    //! Writes anything pending while keeping the file open, so that a reader sees all text added so far
+    //! @returns false iff no file is open or any write failed
+    bool WritePending();
+
+    //! Adds a single character
+    void AddChar(char c)
+    {
+        if (mBufferPos >= mBuffer.size())
+        {
+            Flush();
+        }
+        mBuffer[mBufferPos++] = c;
+    }
+    //! Adds a null terminated string
+    void AddString(const char* str);
+    //! Adds a string of the given length
+    void AddString(const char* str, size_t len);
+    //! Adds a value in hex as "0x" followed by one upper case digit per 4 bits, zero padded
+    //! @param[in] value  the value to add
+    //! @param[in] numBits  the number of bits the value holds
+    void AddHex(U64 value, U32 numBits);
+    //! Adds an unsigned value in decimal
+    void AddDecimal(U64 value);
+    //! Adds the time of a sample relative to the trigger in seconds, with enough decimal places to resolve one sample
+    //! @param[in] sample  the sample number
+    //! @param[in] triggerSample  the sample number of the trigger, which is time 0
+    //! @param[in] sampleRateHz  the sample rate; the sample offset is added as is if 0
+    void AddTime(U64 sample, U64 triggerSample, U32 sampleRateHz);
+
+    //! @returns the number of bytes added since the file was opened
+    U64 GetNumBytesWritten() const;
+
+    //! @returns the text held in memory; only meaningful while no file is open
+    const char* GetBufferedText() const;
+    //! @returns the number of bytes of text held in memory
+    size_t GetNumBufferedBytes() const;
+    //! Discards the text held in memory, keeping the buffer for reuse
+    void ClearBufferedText();
+
+  private:
+    //! Makes room for the given number of bytes in the buffer
+    //! @returns where to write them
+    char* Reserve(size_t numBytes);
+    //! Writes out the buffer, or grows it if no file is open
+    void Flush();
+
+    //! The file being written
+    FILE* mFile;
+    //! Pending text to write
+    std::vector<char> mBuffer;
+    //! Number of pending bytes in mBuffer
+    size_t mBufferPos;
+    //! Number of bytes written out before the pending bytes
+    U64 mNumBytesFlushed;
+    //! Sample rate the time scale below was computed for
+    U32 mTimeSampleRateHz;
+    //! Number of decimal places AddTime() writes for mTimeSampleRateHz
+    U32 mTimeDecimalPlaces;
+    //! false once any write fails
+    bool mWriteOk;
+};
+
+#endif // MAPLEBUS_EXPORT_WRITER_H
@@ -0,0 +1,84 @@
+#include "MapleBusFrameLayout.h"
+
+//! Number of bytes in a word
+static const U32 WORD_BYTES = 4;
+
+void MapleBusFrameLayout::LayOut(const MapleBusPacket& packet, U64 packetIndex, MapleBusFrameStyle style,
+                                 std::vector<MapleBusFrameSpec>& frames)
+{
+    frames.clear();
+    U32 numBytes = static_cast<U32>(packet.bytes.size());
+
+    if (style == MAPLE_BUS_FRAMES_EACH_PACKET)
+    {
+        MapleBusFrameSpec frame;
+        frame.startSample = packet.startSample;
+        frame.endSample = packet.endSample;
+        frame.value = packetIndex;
+        frame.numLeft = static_cast<S32>(numBytes);
+        frame.kind = MAPLE_BUS_FRAME_KIND_PACKET;
+        frame.type = MAPLE_BUS_DATA_PAYLOAD;
+        frame.error = !packet.crcValid;
+        frame.startsPacket = true;
+        frames.push_back(frame);
+        return;
+    }
+
+    if (numBytes == 0)
+    {
+        return;
+    }
+
+    // Same accounting as MapleBusDecoder::SaveByte(): the first byte gives the number of words after the frame word
+    S32 totalBytesExpected = packet.bytes[0] * WORD_BYTES + WORD_BYTES + 1;
+    S32 totalWordsExpected = packet.bytes[0] + 1;
+    U32 word = 0;
+    for (U32 i = 0; i < numBytes; ++i)
+    {
+        U64 byteStartSample = (i == 0) ? packet.dataStartSample : packet.byteEndSamples[i - 1];
+        S32 numBytesLeft = totalBytesExpected - 1 - static_cast<S32>(i);
+        numBytesLeft = (numBytesLeft > 0) ? numBytesLeft : 0;
+
+        if (style == MAPLE_BUS_FRAMES_EACH_BYTE || numBytesLeft == 0)
+        {
+            MapleBusFrameSpec frame;
+            frame.startSample = byteStartSample;
+            frame.endSample = packet.byteEndSamples[i];
+            frame.value = packet.bytes[i];
+            frame.numLeft = numBytesLeft;
+            frame.kind = MAPLE_BUS_FRAME_KIND_BYTE;
+            frame.type = MAPLE_BUS_DATA_PAYLOAD;
+            frame.error = false;
+            frame.startsPacket = frames.empty();
+            if (i < WORD_BYTES)
+            {
+                frame.type = MAPLE_BUS_DATA_FRAME;
+            }
+            else if (numBytesLeft == 0)
+            {
+                // Bytes beyond the expected CRC byte are also CRC bytes, but never valid
+                frame.type = MAPLE_BUS_DATA_CRC;
+                frame.error = (static_cast<S32>(i) != totalBytesExpected - 1 || !packet.crcValid);
+            }
+            frames.push_back(frame);
+        }
+
+        word = (word >> 8) | (static_cast<U32>(packet.bytes[i]) << 24);
+        if (style == MAPLE_BUS_FRAMES_EACH_WORD && (i + 1) % WORD_BYTES == 0)
+        {
+            U32 firstByte = i + 1 - WORD_BYTES;
+            S32 numWordsLeft = totalWordsExpected - static_cast<S32>((i + 1) / WORD_BYTES);
+
+            MapleBusFrameSpec frame;
+            frame.startSample = (firstByte == 0) ? packet.dataStartSample : packet.byteEndSamples[firstByte - 1];
+            frame.endSample = packet.byteEndSamples[i];
+            frame.value = word;
+            frame.numLeft = (numWordsLeft > 0) ? numWordsLeft : 0;
+            frame.kind = MAPLE_BUS_FRAME_KIND_WORD;
+            frame.type = (firstByte == 0) ? MAPLE_BUS_DATA_FRAME : MAPLE_BUS_DATA_PAYLOAD;
+            frame.error = false;
+            frame.startsPacket = frames.empty();
+            frames.push_back(frame);
+        }
+    }
+}
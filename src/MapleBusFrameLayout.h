@@ -0,0 +1,64 @@
+#ifndef MAPLEBUS_FRAME_LAYOUT_H
+#define MAPLEBUS_FRAME_LAYOUT_H
+
+#include "MapleBusDecoder.h"
+#include <vector>
+
+//! Which frames an output style shows; styles which differ only in how values are written share a frame style
+enum MapleBusFrameStyle
+{
+    //! One frame per byte
+    MAPLE_BUS_FRAMES_EACH_BYTE = 0,
+    //! One frame per complete 32-bit word, plus one per CRC byte and any byte beyond it
+    MAPLE_BUS_FRAMES_EACH_WORD,
+    //! One frame per completed packet
+    MAPLE_BUS_FRAMES_EACH_PACKET
+};
+
+//! What a laid out frame holds
+enum MapleBusFrameKind
+{
+    //! A single byte; value is the byte and numLeft the number of bytes expected to follow
+    MAPLE_BUS_FRAME_KIND_BYTE = 0,
+    //! A 32-bit word built little endian; value is the word and numLeft the number of words expected to follow
+    MAPLE_BUS_FRAME_KIND_WORD,
+    //! A whole packet; value is the packet index and numLeft the number of bytes in the packet
+    MAPLE_BUS_FRAME_KIND_PACKET
+};
+
+//! A single frame laid out from a packet
+struct MapleBusFrameSpec
+{
+    //! The sample number where the first bit of the frame was read, or the start of the start sequence for packets
+    U64 startSample;
+    //! The sample number of the clock edge of the last bit of the frame, or the end of the end sequence for packets
+    U64 endSample;
+    //! The value of the frame (see MapleBusFrameKind)
+    U64 value;
+    //! The count which follows the value (see MapleBusFrameKind)
+    S32 numLeft;
+    //! What the frame holds
+    MapleBusFrameKind kind;
+    //! The classification of a byte or word; always MAPLE_BUS_DATA_PAYLOAD for packets
+    MapleBusDataType type;
+    //! true iff the frame should be shown as an error: a CRC byte which isn't the expected, matching CRC byte, or a
+    //! packet without one
+    bool error;
+    //! true iff this is the first frame laid out from the packet
+    bool startsPacket;
+};
+
+//! Lays out the frames of each output style from a decoded packet. Decoding doesn't depend on the output style, and the
+//! frames of any style are derived from each packet once it ends or fails; the frames are the same, in the same order,
+//! as the bytes and words the decoder reported while receiving the packet.
+namespace MapleBusFrameLayout
+{
+    //! Lays out the frames of a packet
+    //! @param[in] packet  the packet; may be a packet which failed part way, holding only the bytes received
+    //! @param[in] packetIndex  the index the packet was stored at; only used by MAPLE_BUS_FRAMES_EACH_PACKET
+    //! @param[in] style  which frames to lay out
+    //! @param[out] frames  cleared then set to the frames in order
+    void LayOut(const MapleBusPacket& packet, U64 packetIndex, MapleBusFrameStyle style, std::vector<MapleBusFrameSpec>& frames);
+}
+
+#endif // MAPLEBUS_FRAME_LAYOUT_H
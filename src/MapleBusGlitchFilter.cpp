@@ -0,0 +1,108 @@
+#include "MapleBusGlitchFilter.h"
+
+MapleBusGlitchFilter::MapleBusGlitchFilter(MapleBusTransitionSource* source, U32 minWidthA, U32 minWidthB)
+    : mSource(source), mMinWidthA(minWidthA), mMinWidthB(minWidthB), mLines(0), mLinesValid(false), mQueue(), mNumGlitches(0)
+{
+}
+
+MapleBusGlitchFilter::~MapleBusGlitchFilter()
+{
+}
+
+U8 MapleBusGlitchFilter::GetInitialLines()
+{
+    if (!mLinesValid)
+    {
+        mLines = mSource->GetInitialLines();
+        mLinesValid = true;
+    }
+    return mLines;
+}
+
+bool MapleBusGlitchFilter::GetNextTransition(MapleBusTransition& transition)
+{
+    GetInitialLines();
+    while (true)
+    {
+        if (mQueue.empty() && !mSource->GetNextTransition(transition))
+        {
+            return false;
+        }
+        if (mQueue.empty())
+        {
+            mQueue.push_back(transition);
+        }
+
+        FilterLine(MAPLE_BUS_LINE_A, mMinWidthA);
+        FilterLine(MAPLE_BUS_LINE_B, mMinWidthB);
+
+        transition = mQueue.front();
+        mQueue.pop_front();
+        if (transition.lines != mLines)
+        {
+            mLines = transition.lines;
+            return true;
+        }
+        // Every change of this transition was part of a removed pulse
+    }
+}
+
+bool MapleBusGlitchFilter::HasTransitionBefore(U64 sample)
+{
+    // Pulses may yet be removed from the queue, so a queued transition might not be returned
+    return !mQueue.empty() || mSource->HasTransitionBefore(sample);
+}
+
+U64 MapleBusGlitchFilter::GetNumGlitches() const
+{
+    return mNumGlitches;
+}
+
+U32 MapleBusGlitchFilter::NanosecondsToSamples(U32 widthNs, U32 sampleRateHz)
+{
+    return static_cast<U32>((static_cast<U64>(widthNs) * sampleRateHz + 999999999) / 1000000000);
+}
+
+void MapleBusGlitchFilter::FilterLine(U8 lineMask, U32 minWidth)
+{
+    if (minWidth == 0 || ((mQueue.front().lines ^ mLines) & lineMask) == 0)
+    {
+        return;
+    }
+
+    // Find where the line next changes back, up to the minimum pulse width
+    U64 holdSample = mQueue.front().sample + minWidth;
+    for (size_t i = 1; true; ++i)
+    {
+        if (i == mQueue.size() && !ReadAhead(holdSample))
+        {
+            // The line holds for the minimum pulse width
+            return;
+        }
+        if (mQueue[i].sample >= holdSample)
+        {
+            return;
+        }
+        if (((mQueue[i].lines ^ mQueue[i - 1].lines) & lineMask) != 0)
+        {
+            // Remove the pulse by holding the line at its previous state until it changes back
+            for (size_t j = 0; j < i; ++j)
+            {
+                mQueue[j].lines ^= lineMask;
+            }
+            ++mNumGlitches;
+            return;
+        }
+    }
+}
+
+bool MapleBusGlitchFilter::ReadAhead(U64 before)
+{
+    MapleBusTransition transition;
+    if (!mSource->HasTransitionBefore(before) || !mSource->GetNextTransition(transition))
+    {
+        return false;
+    }
+    mQueue.push_back(transition);
+    return true;
+}
@@ -0,0 +1,65 @@
+#ifndef MAPLEBUS_GLITCH_FILTER_H
+#define MAPLEBUS_GLITCH_FILTER_H
+
+#include "MapleBusTransitionSource.h"
+#include <deque>
+
+//! Removes glitches from another transition source as transitions are decoded. A pulse on either line which is shorter
+//! than that line's minimum pulse width is removed along with both of its edges, so a spike within a bit no longer
+//! shows up as extra data edges. A burst of short pulses settles at the first edge after which the line holds for the
+//! minimum pulse width.
+//!
+//! Transitions are only held back until the minimum pulse width has passed after them, so no separate pass over the
+//! capture is needed. SDCKB's edges are visited one by one while waiting for a start sequence, since any of them may
+//! cancel out an SDCKA edge.
+class MapleBusGlitchFilter : public MapleBusTransitionSource
+{
+  public:
+    //! Constructor
+    //! @param[in] source  the transitions to filter; must outlive this object
+    //! @param[in] minWidthA  the minimum pulse width of SDCKA in samples; 0 keeps every SDCKA pulse
+    //! @param[in] minWidthB  the minimum pulse width of SDCKB in samples; 0 keeps every SDCKB pulse
+    MapleBusGlitchFilter(MapleBusTransitionSource* source, U32 minWidthA, U32 minWidthB);
+    //! Destructor
+    virtual ~MapleBusGlitchFilter();
+
+    virtual U8 GetInitialLines();
+    virtual bool GetNextTransition(MapleBusTransition& transition);
+    virtual bool HasTransitionBefore(U64 sample);
+
+    //! @returns the number of pulses removed so far
+    U64 GetNumGlitches() const;
+
+    //! Converts a pulse width to samples, rounding up so that any pulse shorter than the width is removed
+    //! @param[in] widthNs  the pulse width in nanoseconds
+    //! @param[in] sampleRateHz  the sample rate
+    //! @returns the width in samples
+    static U32 NanosecondsToSamples(U32 widthNs, U32 sampleRateHz);
+
+  private:
+    //! Removes any pulse which the front transition begins on the given line
+    //! @param[in] lineMask  the line to check (see MapleBusLineMask)
+    //! @param[in] minWidth  the minimum pulse width of the line
+    void FilterLine(U8 lineMask, U32 minWidth);
+    //! Reads the next transition of the source into the look ahead queue
+    //! @param[in] before  only read a transition which occurs before this sample
+    //! @returns false iff no such transition exists
+    bool ReadAhead(U64 before);
+
+    //! The transitions to filter
+    MapleBusTransitionSource* mSource;
+    //! The minimum pulse width of SDCKA in samples
+    U32 mMinWidthA;
+    //! The minimum pulse width of SDCKB in samples
+    U32 mMinWidthB;
+    //! The state of both lines before the front transition, after filtering
+    U8 mLines;
+    //! true iff the state of both lines has been read from the source
+    bool mLinesValid;
+    //! Transitions read from the source but not yet returned; pulses removed from them
+    std::deque<MapleBusTransition> mQueue;
+    //! Number of pulses removed
+    U64 mNumGlitches;
+};
+
+#endif // MAPLEBUS_GLITCH_FILTER_H
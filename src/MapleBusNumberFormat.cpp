@@ -0,0 +1,51 @@
+#include "MapleBusNumberFormat.h"
+
+//! Upper case hex digits
+static const char HEX_DIGITS[] = "0123456789ABCDEF";
+//! Every pair of decimal digits, so two are formatted per division
+static const char DECIMAL_PAIRS[] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+                                    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+                                    "8081828384858687888990919293949596979899";
+
+U32 MapleBusNumberFormat::FormatHex(U64 value, U32 numBits, char* dest)
+{
+    U32 numDigits = (numBits + 3) / 4;
+    numDigits = (numDigits == 0) ? 1 : ((numDigits > 16) ? 16 : numDigits);
+    dest[0] = '0';
+    dest[1] = 'x';
+    for (U32 i = numDigits + 1; i > 1; --i, value = value >> 4)
+    {
+        dest[i] = HEX_DIGITS[value & 0xF];
+    }
+    return 2 + numDigits;
+}
+
+U32 MapleBusNumberFormat::FormatDecimal(U64 value, char* dest)
+{
+    U32 numDigits = 1;
+    for (U64 scale = 10; numDigits < MAX_DECIMAL_CHARS && value >= scale; scale *= 10)
+    {
+        ++numDigits;
+    }
+
+    // Fill from the last digit
+    U32 pos = numDigits;
+    while (value >= 100)
+    {
+        U32 pair = static_cast<U32>(value % 100) * 2;
+        value = value / 100;
+        dest[--pos] = DECIMAL_PAIRS[pair + 1];
+        dest[--pos] = DECIMAL_PAIRS[pair];
+    }
+    if (value >= 10)
+    {
+        U32 pair = static_cast<U32>(value) * 2;
+        dest[--pos] = DECIMAL_PAIRS[pair + 1];
+        dest[--pos] = DECIMAL_PAIRS[pair];
+    }
+    else
+    {
+        dest[--pos] = static_cast<char>('0' + value);
+    }
+    return numDigits;
+}
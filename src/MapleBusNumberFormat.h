@@ -0,0 +1,27 @@
+#ifndef MAPLEBUS_NUMBER_FORMAT_H
+#define MAPLEBUS_NUMBER_FORMAT_H
+
+#include <LogicPublicTypes.h>
+
+//! Table driven number formatting, independent of Saleae's SDK. Output matches the SDK's hex and decimal display bases.
+namespace MapleBusNumberFormat
+{
+    //! Most characters FormatHex() writes
+    const U32 MAX_HEX_CHARS = 2 + 16;
+    //! Most characters FormatDecimal() writes
+    const U32 MAX_DECIMAL_CHARS = 20;
+
+    //! Formats a value in hex as "0x" followed by one upper case digit per 4 bits, zero padded
+    //! @param[in] value  the value to format
+    //! @param[in] numBits  the number of bits the value holds
+    //! @param[out] dest  where to write at least MAX_HEX_CHARS characters; no terminator is written
+    //! @returns the number of characters written
+    U32 FormatHex(U64 value, U32 numBits, char* dest);
+    //! Formats an unsigned value in decimal
+    //! @param[in] value  the value to format
+    //! @param[out] dest  where to write at least MAX_DECIMAL_CHARS characters; no terminator is written
+    //! @returns the number of characters written
+    U32 FormatDecimal(U64 value, char* dest);
+}
+
+#endif // MAPLEBUS_NUMBER_FORMAT_H
@@ -0,0 +1,149 @@
+#include "MapleBusPacketEncoder.h"
+
+//! Number of SDCKB pulses within the start sequence
+static const U32 NUM_START_PULSES = 4;
+
+MapleBusPacketEncoder::MapleBusPacketEncoder(double samplesPerBit, U64 startSample)
+    : mSamplesPerPhase(samplesPerBit / 3), mTime(static_cast<double>(startSample)), mLines(MAPLE_BUS_LINES_AB)
+{
+    // Every edge must land on its own sample
+    if (mSamplesPerPhase < 1)
+    {
+        mSamplesPerPhase = 1;
+    }
+}
+
+MapleBusPacketEncoder::~MapleBusPacketEncoder()
+{
+}
+
+void MapleBusPacketEncoder::BuildPacket(U8 command, U8 recipient, U8 sender, const std::vector<U32>& payload,
+                                        std::vector<U8>& bytes)
+{
+    // The frame word is sent as number of words, sender, recipient, then command
+    bytes.clear();
+    bytes.push_back(static_cast<U8>(payload.size()));
+    bytes.push_back(sender);
+    bytes.push_back(recipient);
+    bytes.push_back(command);
+    for (std::vector<U32>::const_iterator iter = payload.begin(); iter != payload.end(); ++iter)
+    {
+        // Words are built little endian by the decoder
+        for (U32 i = 0; i < 4; ++i)
+        {
+            bytes.push_back(static_cast<U8>(*iter >> (8 * i)));
+        }
+    }
+    bytes.push_back(ComputeCrc(&bytes[0], bytes.size()));
+}
+
+U8 MapleBusPacketEncoder::ComputeCrc(const U8* bytes, size_t numBytes)
+{
+    U8 crc = 0;
+    for (size_t i = 0; i < numBytes; ++i)
+    {
+        crc ^= bytes[i];
+    }
+    return crc;
+}
+
+void MapleBusPacketEncoder::AddPacket(const std::vector<U8>& bytes, std::vector<MapleBusTransition>& transitions,
+                                      S32 glitchBit, U32 glitchSamples)
+{
+    // The pulse needs a sample either side of it within the data phase so that every edge lands on its own sample
+    double maxGlitchSamples = mSamplesPerPhase - 2;
+    if (glitchSamples > maxGlitchSamples)
+    {
+        glitchSamples = (maxGlitchSamples >= 1) ? static_cast<U32>(maxGlitchSamples) : 0;
+    }
+
+    // Start sequence: SDCKA falls, SDCKB pulses 4 times, then SDCKA rises
+    SetLine(MAPLE_BUS_LINE_A, false, transitions);
+    Wait(2);
+    for (U32 i = 0; i < NUM_START_PULSES; ++i)
+    {
+        SetLine(MAPLE_BUS_LINE_B, false, transitions);
+        Wait(1);
+        SetLine(MAPLE_BUS_LINE_B, true, transitions);
+        Wait(1);
+    }
+    Wait(1);
+    SetLine(MAPLE_BUS_LINE_A, true, transitions);
+    Wait(1);
+
+    // Data bits, most significant bit first; SDCKA is the clock for even bits
+    U32 numBits = static_cast<U32>(bytes.size()) * 8;
+    for (U32 i = 0; i < numBits; ++i)
+    {
+        bool aIsClock = ((i & 1) == 0);
+        U8 clockLine = aIsClock ? MAPLE_BUS_LINE_A : MAPLE_BUS_LINE_B;
+        U8 dataLine = aIsClock ? MAPLE_BUS_LINE_B : MAPLE_BUS_LINE_A;
+        bool bit = (((bytes[i / 8] >> (7 - (i % 8))) & 1) != 0);
+
+        SetLine(dataLine, bit, transitions);
+        if (static_cast<S32>(i) == glitchBit && glitchSamples > 0)
+        {
+            // A spike centred in the data phase, much shorter than a real phase so that a glitch filter can remove it
+            double margin = (mSamplesPerPhase - glitchSamples) / 2;
+            mTime += margin;
+            SetLine(dataLine, !bit, transitions);
+            mTime += glitchSamples;
+            SetLine(dataLine, bit, transitions);
+            mTime += margin;
+        }
+        else
+        {
+            Wait(1);
+        }
+        SetLine(clockLine, true, transitions);
+        Wait(1);
+        SetLine(clockLine, false, transitions);
+        Wait(1);
+    }
+
+    // End sequence: with SDCKA high, SDCKB toggles twice; SDCKA then falls, rises, falls and rises; finally SDCKB rises
+    SetLine(MAPLE_BUS_LINE_A, true, transitions);
+    Wait(1);
+    SetLine(MAPLE_BUS_LINE_B, true, transitions);
+    Wait(1);
+    SetLine(MAPLE_BUS_LINE_B, false, transitions);
+    Wait(1);
+    SetLine(MAPLE_BUS_LINE_A, false, transitions);
+    Wait(1);
+    SetLine(MAPLE_BUS_LINE_A, true, transitions);
+    Wait(1);
+    SetLine(MAPLE_BUS_LINE_A, false, transitions);
+    Wait(1);
+    SetLine(MAPLE_BUS_LINE_A, true, transitions);
+    Wait(1);
+    SetLine(MAPLE_BUS_LINE_B, true, transitions);
+    Wait(1);
+}
+
+void MapleBusPacketEncoder::AddIdle(double numSamples)
+{
+    mTime += numSamples;
+}
+
+U64 MapleBusPacketEncoder::GetCurrentSample() const
+{
+    return static_cast<U64>(mTime + 0.5);
+}
+
+void MapleBusPacketEncoder::SetLine(U8 line, bool high, std::vector<MapleBusTransition>& transitions)
+{
+    U8 lines = high ? (mLines | line) : (mLines & ~line);
+    if (lines != mLines)
+    {
+        MapleBusTransition transition;
+        transition.sample = GetCurrentSample();
+        transition.lines = lines;
+        transitions.push_back(transition);
+        mLines = lines;
+    }
+}
+
+void MapleBusPacketEncoder::Wait(U32 numPhases)
+{
+    mTime += numPhases * mSamplesPerPhase;
+}
@@ -0,0 +1,60 @@
+#ifndef MAPLEBUS_PACKET_ENCODER_H
+#define MAPLEBUS_PACKET_ENCODER_H
+
+#include "MapleBusTransitionSource.h"
+#include <vector>
+
+//! Encodes Maple Bus packets into SDCKA and SDCKB transitions, independent of Saleae's SDK.
+//!
+//! Each bit takes 3 equal phases: the data line settles, the clock line rises, then the clock line falls where the bit
+//! is sampled. Clock and data swap lines each bit as on the real bus.
+class MapleBusPacketEncoder
+{
+  public:
+    //! Constructor
+    //! @param[in] samplesPerBit  the number of samples per bit; at least 3
+    //! @param[in] startSample  the sample number where encoding begins, with both lines high
+    MapleBusPacketEncoder(double samplesPerBit, U64 startSample = 0);
+    //! Destructor
+    virtual ~MapleBusPacketEncoder();
+
+    //! Builds the bytes of a packet, including the CRC byte
+    //! @param[in] command  the command code (see MapleBusCommand)
+    //! @param[in] recipient  the recipient address
+    //! @param[in] sender  the sender address
+    //! @param[in] payload  the payload words
+    //! @param[out] bytes  set to the packet bytes in the order they are sent
+    static void BuildPacket(U8 command, U8 recipient, U8 sender, const std::vector<U32>& payload, std::vector<U8>& bytes);
+    //! @returns the CRC of the given bytes
+    static U8 ComputeCrc(const U8* bytes, size_t numBytes);
+
+    //! Appends the waveform of a complete packet, leaving both lines high
+    //! @param[in] bytes  the packet bytes, including the CRC byte
+    //! @param[out] transitions  the transitions are appended to this
+    //! @param[in] glitchBit  index of a bit whose data line receives a short pulse to exercise error handling and glitch
+    //!                       filtering, or -1
+    //! @param[in] glitchSamples  the width of that pulse in samples; kept short enough to fit within a phase
+    void AddPacket(const std::vector<U8>& bytes, std::vector<MapleBusTransition>& transitions, S32 glitchBit = -1,
+                   U32 glitchSamples = 1);
+    //! Leaves the bus idle
+    //! @param[in] numSamples  the number of samples to stay idle for
+    void AddIdle(double numSamples);
+
+    //! @returns the sample number where the next packet would begin
+    U64 GetCurrentSample() const;
+
+  private:
+    //! Appends a transition if the line changes state
+    void SetLine(U8 line, bool high, std::vector<MapleBusTransition>& transitions);
+    //! Advances time by a number of phases
+    void Wait(U32 numPhases);
+
+    //! The number of samples in each third of a bit
+    double mSamplesPerPhase;
+    //! The current time in samples
+    double mTime;
+    //! The current state of both lines (see MapleBusLineMask)
+    U8 mLines;
+};
+
+#endif // MAPLEBUS_PACKET_ENCODER_H
@@ -0,0 +1,220 @@
+#include "MapleBusPacketFile.h"
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#endif
+
+const char MapleBusPacketFile::MAGIC[4] = { 'M', 'B', 'P', 'K' };
+
+//! Columns in file order
+enum PacketFileColumn
+{
+    COLUMN_START_SAMPLE = 0,
+    COLUMN_END_SAMPLE,
+    COLUMN_PAYLOAD_OFFSET,
+    COLUMN_FRAME_WORD,
+    COLUMN_FUNCTION,
+    COLUMN_PAYLOAD_LENGTH,
+    COLUMN_CRC,
+    COLUMN_FLAGS,
+    COLUMN_SUM_BIT_PERIODS,
+    COLUMN_SUM_SQUARED_BIT_PERIODS,
+    COLUMN_NUM_BIT_PERIODS,
+    COLUMN_MIN_BIT_PERIOD,
+    COLUMN_MAX_BIT_PERIOD,
+    COLUMN_MIN_SETUP,
+    COLUMN_PAYLOAD
+};
+
+//! Byte size of each value of each column; 1 for the payload blob
+static const U32 COLUMN_VALUE_SIZES[MapleBusPacketFile::NUM_COLUMNS] = { 8, 8, 8, 4, 4, 4, 1, 1, 8, 8, 4, 4, 4, 4, 1 };
+
+//! Number of bytes in the frame word
+static const U32 FRAME_WORD_BYTES = 4;
+
+//! Writes a little endian value into a buffer
+static void PutLittleEndian(U8* dest, U64 value, U32 numBytes)
+{
+    for (U32 i = 0; i < numBytes; ++i, value = value >> 8)
+    {
+        dest[i] = static_cast<U8>(value & 0xFF);
+    }
+}
+
+//! Moves to a byte offset within a file which may be larger than 2 GB
+static bool SeekTo(FILE* file, U64 offset)
+{
+#ifdef _WIN32
+    return (_fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0);
+#else
+    return (fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0);
+#endif
+}
+
+MapleBusPacketFileWriter::MapleBusPacketFileWriter()
+    : mFile(NULL), mMaxPackets(0), mNumPackets(0), mNumPayloadBytes(0), mSampleRateHz(0), mTriggerSample(0), mWriteOk(false)
+{
+    for (U32 i = 0; i < MapleBusPacketFile::NUM_COLUMNS; ++i)
+    {
+        mColumns[i].fileOffset = 0;
+        mColumns[i].buffer.reserve(MapleBusPacketFile::BUFFER_SIZE);
+        mColumnOffsets[i] = 0;
+    }
+}
+
+MapleBusPacketFileWriter::~MapleBusPacketFileWriter()
+{
+    Close();
+}
+
+bool MapleBusPacketFileWriter::Open(const char* path, U64 maxPackets, U32 sampleRateHz, U64 triggerSample)
+{
+    Close();
+
+    mFile = fopen(path, "wb");
+    if (mFile == NULL)
+    {
+        return false;
+    }
+
+    // Each column follows the last, rounded up to 8 bytes
+    U64 offset = MapleBusPacketFile::HEADER_SIZE;
+    for (U32 i = 0; i < MapleBusPacketFile::NUM_COLUMNS; ++i)
+    {
+        mColumnOffsets[i] = offset;
+        mColumns[i].fileOffset = offset;
+        mColumns[i].buffer.clear();
+        offset = (offset + maxPackets * COLUMN_VALUE_SIZES[i] + 7) & ~static_cast<U64>(7);
+    }
+
+    mMaxPackets = maxPackets;
+    mNumPackets = 0;
+    mNumPayloadBytes = 0;
+    mSampleRateHz = sampleRateHz;
+    mTriggerSample = triggerSample;
+
+    // The header is written once the packet count and payload size are known
+    U8 header[MapleBusPacketFile::HEADER_SIZE] = {};
+    mWriteOk = (fwrite(header, 1, sizeof(header), mFile) == sizeof(header));
+    return mWriteOk;
+}
+
+void MapleBusPacketFileWriter::AddPacket(const MapleBusPacketRecord& record, const std::vector<U8>& bytes)
+{
+    if (mFile == NULL || mNumPackets >= mMaxPackets)
+    {
+        return;
+    }
+
+    // Bytes between the frame word and the CRC byte, which is the last byte of any packet longer than the frame word
+    bool crcReceived = (bytes.size() > FRAME_WORD_BYTES);
+    size_t payloadEnd = crcReceived ? (bytes.size() - 1) : bytes.size();
+    size_t payloadLength = (payloadEnd > FRAME_WORD_BYTES) ? (payloadEnd - FRAME_WORD_BYTES) : 0;
+    U8 flags = 0;
+    if (crcReceived)
+    {
+        flags |= MAPLE_BUS_PACKET_FILE_CRC_RECEIVED;
+    }
+    if (record.crcValid)
+    {
+        flags |= MAPLE_BUS_PACKET_FILE_CRC_VALID;
+    }
+
+    AddValue(mColumns[COLUMN_START_SAMPLE], record.startSample, 8);
+    AddValue(mColumns[COLUMN_END_SAMPLE], record.endSample, 8);
+    AddValue(mColumns[COLUMN_PAYLOAD_OFFSET], mNumPayloadBytes, 8);
+    AddValue(mColumns[COLUMN_FRAME_WORD], record.frameWord, 4);
+    AddValue(mColumns[COLUMN_FUNCTION], record.function, 4);
+    AddValue(mColumns[COLUMN_PAYLOAD_LENGTH], payloadLength, 4);
+    AddValue(mColumns[COLUMN_CRC], crcReceived ? bytes.back() : 0, 1);
+    AddValue(mColumns[COLUMN_FLAGS], flags, 1);
+    AddValue(mColumns[COLUMN_SUM_BIT_PERIODS], record.timing.sumPeriods, 8);
+    AddValue(mColumns[COLUMN_SUM_SQUARED_BIT_PERIODS], record.timing.sumSquaredPeriods, 8);
+    AddValue(mColumns[COLUMN_NUM_BIT_PERIODS], record.timing.numPeriods, 4);
+    AddValue(mColumns[COLUMN_MIN_BIT_PERIOD], (record.timing.numPeriods > 0) ? record.timing.minPeriod : 0, 4);
+    AddValue(mColumns[COLUMN_MAX_BIT_PERIOD], record.timing.maxPeriod, 4);
+    AddValue(mColumns[COLUMN_MIN_SETUP], record.timing.minSetup, 4);
+    if (payloadLength > 0)
+    {
+        AddBytes(mColumns[COLUMN_PAYLOAD], &bytes[FRAME_WORD_BYTES], payloadLength);
+    }
+
+    mNumPayloadBytes += payloadLength;
+    ++mNumPackets;
+}
+
+bool MapleBusPacketFileWriter::Close()
+{
+    if (mFile == NULL)
+    {
+        return false;
+    }
+
+    for (U32 i = 0; i < MapleBusPacketFile::NUM_COLUMNS; ++i)
+    {
+        Flush(mColumns[i]);
+    }
+
+    U8 header[MapleBusPacketFile::HEADER_SIZE] = {};
+    memcpy(header, MapleBusPacketFile::MAGIC, sizeof(MapleBusPacketFile::MAGIC));
+    header[4] = MapleBusPacketFile::VERSION;
+    PutLittleEndian(&header[6], MapleBusPacketFile::NUM_COLUMNS, 2);
+    PutLittleEndian(&header[8], mSampleRateHz, 4);
+    PutLittleEndian(&header[16], mTriggerSample, 8);
+    PutLittleEndian(&header[24], mNumPackets, 8);
+    PutLittleEndian(&header[32], mNumPayloadBytes, 8);
+    for (U32 i = 0; i < MapleBusPacketFile::NUM_COLUMNS; ++i)
+    {
+        PutLittleEndian(&header[48 + 8 * i], mColumnOffsets[i], 8);
+    }
+    if (!SeekTo(mFile, 0) || fwrite(header, 1, sizeof(header), mFile) != sizeof(header))
+    {
+        mWriteOk = false;
+    }
+
+    if (fclose(mFile) != 0)
+    {
+        mWriteOk = false;
+    }
+    mFile = NULL;
+    return mWriteOk;
+}
+
+U64 MapleBusPacketFileWriter::GetNumPackets() const
+{
+    return mNumPackets;
+}
+
+void MapleBusPacketFileWriter::AddValue(Column& column, U64 value, U32 numBytes)
+{
+    size_t pos = column.buffer.size();
+    column.buffer.resize(pos + numBytes);
+    PutLittleEndian(&column.buffer[pos], value, numBytes);
+    if (column.buffer.size() >= MapleBusPacketFile::BUFFER_SIZE)
+    {
+        Flush(column);
+    }
+}
+
+void MapleBusPacketFileWriter::AddBytes(Column& column, const U8* bytes, size_t numBytes)
+{
+    column.buffer.insert(column.buffer.end(), bytes, bytes + numBytes);
+    if (column.buffer.size() >= MapleBusPacketFile::BUFFER_SIZE)
+    {
+        Flush(column);
+    }
+}
+
+void MapleBusPacketFileWriter::Flush(Column& column)
+{
+    if (!column.buffer.empty())
+    {
+        if (!SeekTo(mFile, column.fileOffset) || fwrite(&column.buffer[0], 1, column.buffer.size(), mFile) != column.buffer.size())
+        {
+            mWriteOk = false;
+        }
+        column.fileOffset += column.buffer.size();
+        column.buffer.clear();
+    }
+}
@@ -0,0 +1,128 @@
+#ifndef MAPLEBUS_PACKET_FILE_H
+#define MAPLEBUS_PACKET_FILE_H
+
+#include "MapleBusPacketStore.h"
+#include <stdio.h>
+#include <vector>
+
+//! Columnar binary file of decoded packets, laid out so that analysis tools may memory-map it and index each column
+//! as a plain array without parsing.
+//!
+//! All values are little endian and every column begins on an 8 byte boundary.
+//!   0  char[4]  magic "MBPK"
+//!   4  U8       format version (2)
+//!   5  U8       reserved (0)
+//!   6  U16      number of columns (15)
+//!   8  U32      sample rate in Hz (0 if unknown)
+//!  12  U32      reserved (0)
+//!  16  U64      trigger sample
+//!  24  U64      number of packets (N)
+//!  32  U64      byte size of the payload blob
+//!  40  U64      reserved (0)
+//!  48  U64[15]  byte offset of each column within the file, in the order below
+//!
+//! Columns, each holding one value per packet in the order packets were received:
+//!   U64[N]  start sample
+//!   U64[N]  end sample
+//!   U64[N]  offset of the packet's payload within the payload blob
+//!   U32[N]  frame word, built little endian (number of words, sender, recipient and command from least significant)
+//!   U32[N]  function code if the command carries one (see MapleBusProtocol::CommandHasFunction()), otherwise 0
+//!   U32[N]  byte length of the packet's payload within the payload blob
+//!   U8[N]   CRC byte; only valid if MAPLE_BUS_PACKET_FILE_CRC_RECEIVED is set
+//!   U8[N]   flags (see MapleBusPacketFileFlag)
+//!   U64[N]  sum of bit periods in samples (see MapleBusBitTiming)
+//!   U64[N]  sum of the square of each bit period
+//!   U32[N]  number of bit periods measured
+//!   U32[N]  shortest bit period in samples, or 0 if no period was measured
+//!   U32[N]  longest bit period in samples
+//!   U32[N]  shortest setup time in samples, or 0xFFFFFFFF if no bit had a data edge
+//!   U8[]    payload blob: every payload byte between the frame word and CRC of each packet, in the order received
+namespace MapleBusPacketFile
+{
+    //! File magic
+    extern const char MAGIC[4];
+    //! Current format version
+    const U8 VERSION = 2;
+    //! Number of columns, including the payload blob
+    const U16 NUM_COLUMNS = 15;
+    //! Byte size of the file header
+    const U32 HEADER_SIZE = 48 + 8 * NUM_COLUMNS;
+    //! Byte size of the write buffer of each column
+    const U32 BUFFER_SIZE = 64 * 1024;
+}
+
+//! Packet flags column bits
+enum MapleBusPacketFileFlag
+{
+    //! The packet held a CRC byte after its frame word
+    MAPLE_BUS_PACKET_FILE_CRC_RECEIVED = 0x01,
+    //! The expected CRC byte was received and matched (see MapleBusPacket::crcValid)
+    MAPLE_BUS_PACKET_FILE_CRC_VALID = 0x02
+};
+
+//! Writes a packet file in a single pass. Since the number of packets is given up front, every column's location is
+//! known when the file is opened, and each column is buffered separately and written straight to its place.
+class MapleBusPacketFileWriter
+{
+  public:
+    //! Constructor
+    MapleBusPacketFileWriter();
+    //! Destructor; finishes the file if still open
+    virtual ~MapleBusPacketFileWriter();
+
+    //! Creates the file and reserves room for every column
+    //! @param[in] path  the file path to write
+    //! @param[in] maxPackets  the number of packets which will be added; any fewer leaves unused space in each column
+    //! @param[in] sampleRateHz  the sample rate of the capture, 0 if unknown
+    //! @param[in] triggerSample  the trigger sample of the capture
+    //! @returns false iff the file could not be created
+    bool Open(const char* path, U64 maxPackets, U32 sampleRateHz, U64 triggerSample);
+    //! Writes the next packet; ignored once maxPackets have been added
+    //! @param[in] record  the stored packet
+    //! @param[in] bytes  every byte of the packet, including frame word and CRC (see MapleBusPacketStore::GetPacketBytes())
+    void AddPacket(const MapleBusPacketRecord& record, const std::vector<U8>& bytes);
+    //! Writes the header and closes the file
+    //! @returns false iff any write failed
+    bool Close();
+
+    //! @returns the number of packets written so far
+    U64 GetNumPackets() const;
+
+  private:
+    //! One column being written
+    struct Column
+    {
+        //! Byte offset of the next value to write within the file
+        U64 fileOffset;
+        //! Pending bytes to write at fileOffset
+        std::vector<U8> buffer;
+    };
+
+    //! Appends a little endian value to a column
+    void AddValue(Column& column, U64 value, U32 numBytes);
+    //! Appends bytes to a column
+    void AddBytes(Column& column, const U8* bytes, size_t numBytes);
+    //! Writes out the buffer of a column
+    void Flush(Column& column);
+
+    //! The file being written
+    FILE* mFile;
+    //! Every column, in file order
+    Column mColumns[MapleBusPacketFile::NUM_COLUMNS];
+    //! Byte offset of each column within the file
+    U64 mColumnOffsets[MapleBusPacketFile::NUM_COLUMNS];
+    //! Number of packets room was reserved for
+    U64 mMaxPackets;
+    //! Number of packets written
+    U64 mNumPackets;
+    //! Number of payload bytes written
+    U64 mNumPayloadBytes;
+    //! Sample rate for the header
+    U32 mSampleRateHz;
+    //! Trigger sample for the header
+    U64 mTriggerSample;
+    //! false once any write fails
+    bool mWriteOk;
+};
+
+#endif // MAPLEBUS_PACKET_FILE_H
@@ -0,0 +1,180 @@
+#include "MapleBusPacketIndex.h"
+
+//! Largest packet duration an entry holds
+static const U64 MAX_ENTRY_SAMPLES = 0xFFFFFFFF;
+
+MapleBusPacketQuery::MapleBusPacketQuery()
+    : startSample(0),
+      endSample(~static_cast<U64>(0)),
+      fields(0),
+      command(0),
+      recipient(0),
+      sender(0),
+      minWords(0),
+      maxWords(0xFF),
+      function(0)
+{
+}
+
+bool MapleBusPacketQuery::MatchesFields(const MapleBusPacketIndexEntry& entry) const
+{
+    if ((fields & MAPLE_BUS_QUERY_COMMAND) != 0 && entry.command != command)
+    {
+        return false;
+    }
+    if ((fields & MAPLE_BUS_QUERY_RECIPIENT) != 0 && entry.recipient != recipient)
+    {
+        return false;
+    }
+    if ((fields & MAPLE_BUS_QUERY_SENDER) != 0 && entry.sender != sender)
+    {
+        return false;
+    }
+    if ((fields & MAPLE_BUS_QUERY_FUNCTION) != 0 && (entry.function & function) == 0)
+    {
+        return false;
+    }
+    if ((fields & MAPLE_BUS_QUERY_NUM_WORDS) != 0 && (entry.numWords < minWords || entry.numWords > maxWords))
+    {
+        return false;
+    }
+    return true;
+}
+
+MapleBusPacketIndex::MapleBusPacketIndex() : mEntries()
+{
+}
+
+MapleBusPacketIndex::~MapleBusPacketIndex()
+{
+}
+
+void MapleBusPacketIndex::Clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEntries.Clear();
+}
+
+void MapleBusPacketIndex::SetMaxPackets(U64 maxPackets)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEntries.SetMaxItems(maxPackets);
+}
+
+U64 MapleBusPacketIndex::AddPacket(U64 startSample, U64 endSample, const MapleBusPacketInfo& info)
+{
+    MapleBusPacketIndexEntry entry;
+    entry.startSample = startSample;
+    U64 numSamples = (endSample > startSample) ? endSample - startSample : 0;
+    entry.numSamples = static_cast<U32>((numSamples < MAX_ENTRY_SAMPLES) ? numSamples : MAX_ENTRY_SAMPLES);
+    entry.function = info.hasFunction ? info.function : 0;
+    entry.command = info.command;
+    entry.recipient = info.recipient;
+    entry.sender = info.sender;
+    entry.numWords = info.numWords;
+    entry.hasFunction = info.hasFunction;
+    entry.hasFrameWord = info.hasFrameWord;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    U64 packetIndex = mEntries.Add(entry);
+    mEntries.Trim();
+    return packetIndex;
+}
+
+U64 MapleBusPacketIndex::GetNumPackets() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mEntries.GetNumItems();
+}
+
+U64 MapleBusPacketIndex::GetFirstPacketIndex() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mEntries.GetFirstIndex();
+}
+
+bool MapleBusPacketIndex::GetEntry(U64 packetIndex, MapleBusPacketIndexEntry& entry) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    const MapleBusPacketIndexEntry* found = mEntries.Find(packetIndex);
+    if (found == NULL)
+    {
+        return false;
+    }
+    entry = *found;
+    return true;
+}
+
+bool MapleBusPacketIndex::FindPacketAt(U64 sample, U64& packetIndex) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    // The last packet starting at or before the sample is the only one which may span it
+    U64 next = LowerBound(sample + 1);
+    if (next == 0)
+    {
+        return false;
+    }
+    const MapleBusPacketIndexEntry& entry = mEntries.GetRetained()[next - 1];
+    if (sample - entry.startSample > entry.numSamples)
+    {
+        return false;
+    }
+    packetIndex = mEntries.GetFirstIndex() + next - 1;
+    return true;
+}
+
+U64 MapleBusPacketIndex::FindPackets(const MapleBusPacketQuery& query, U64 firstPacket, U64 maxResults,
+                                     std::vector<U64>& packetIndices) const
+{
+    packetIndices.clear();
+    std::lock_guard<std::mutex> lock(mMutex);
+    const std::vector<MapleBusPacketIndexEntry>& entries = mEntries.GetRetained();
+    U64 firstIndex = mEntries.GetFirstIndex();
+    U64 begin = LowerBound(query.startSample);
+    U64 firstPosition = (firstPacket > firstIndex) ? firstPacket - firstIndex : 0;
+    begin = (begin > firstPosition) ? begin : firstPosition;
+    U64 end = entries.size();
+    if (query.endSample < ~static_cast<U64>(0))
+    {
+        end = LowerBound(query.endSample + 1);
+    }
+
+    for (U64 i = begin; i < end; ++i)
+    {
+        if (query.MatchesFields(entries[i]))
+        {
+            if (maxResults > 0 && packetIndices.size() >= maxResults)
+            {
+                return firstIndex + i;
+            }
+            packetIndices.push_back(firstIndex + i);
+        }
+    }
+    return firstIndex + entries.size();
+}
+
+U64 MapleBusPacketIndex::GetMemoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mEntries.GetMemoryUsage();
+}
+
+U64 MapleBusPacketIndex::LowerBound(U64 sample) const
+{
+    const std::vector<MapleBusPacketIndexEntry>& entries = mEntries.GetRetained();
+    U64 low = 0;
+    U64 high = entries.size();
+    while (low < high)
+    {
+        U64 mid = low + (high - low) / 2;
+        if (entries[mid].startSample < sample)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low;
+}
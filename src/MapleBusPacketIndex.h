@@ -0,0 +1,136 @@
+#ifndef MAPLEBUS_PACKET_INDEX_H
+#define MAPLEBUS_PACKET_INDEX_H
+
+#include "MapleBusProtocol.h"
+#include "MapleBusRetainedRing.h"
+#include <mutex>
+#include <vector>
+
+//! The searchable fields of one packet
+struct MapleBusPacketIndexEntry
+{
+    //! The sample number of the start of the packet
+    U64 startSample;
+    //! The number of samples from the start to the end of the packet
+    U32 numSamples;
+    //! The function code (see MapleBusFunction), or 0 if the packet doesn't carry one
+    U32 function;
+    //! Command code (see MapleBusCommand)
+    U8 command;
+    //! Recipient address
+    U8 recipient;
+    //! Sender address
+    U8 sender;
+    //! Number of payload words the frame word announces
+    U8 numWords;
+    //! true iff the command carries a function code and the packet holds it (see MapleBusPacketInfo::hasFunction)
+    bool hasFunction;
+    //! true iff the whole frame word was received (see MapleBusPacketInfo::hasFrameWord)
+    bool hasFrameWord;
+};
+
+//! Which fields a MapleBusPacketQuery matches on; combine to match on several
+enum MapleBusQueryField
+{
+    //! MapleBusPacketQuery::command
+    MAPLE_BUS_QUERY_COMMAND = 0x01,
+    //! MapleBusPacketQuery::recipient
+    MAPLE_BUS_QUERY_RECIPIENT = 0x02,
+    //! MapleBusPacketQuery::sender
+    MAPLE_BUS_QUERY_SENDER = 0x04,
+    //! MapleBusPacketQuery::function
+    MAPLE_BUS_QUERY_FUNCTION = 0x08,
+    //! MapleBusPacketQuery::minWords and MapleBusPacketQuery::maxWords
+    MAPLE_BUS_QUERY_NUM_WORDS = 0x10
+};
+
+//! Selects packets by when they start and by any of their fields
+struct MapleBusPacketQuery
+{
+    //! Constructor; matches every packet
+    MapleBusPacketQuery();
+
+    //! Only packets which start at or after this sample number match
+    U64 startSample;
+    //! Only packets which start at or before this sample number match
+    U64 endSample;
+    //! The fields to match on (see MapleBusQueryField); packets match any value of other fields
+    U32 fields;
+    //! The command code to match
+    U8 command;
+    //! The recipient address to match
+    U8 recipient;
+    //! The sender address to match
+    U8 sender;
+    //! The least number of payload words to match
+    U8 minWords;
+    //! The most number of payload words to match
+    U8 maxWords;
+    //! Packets match if their function code shares any function with this
+    U32 function;
+
+    //! @returns true iff the entry matches every selected field, regardless of time
+    bool MatchesFields(const MapleBusPacketIndexEntry& entry) const;
+};
+
+//! Indexes packets as they are decoded so that they may be found without scanning the packet store: one small entry
+//! per packet, holding its start and the fields most often searched for. Packets start in increasing sample order, so
+//! time ranges are found by binary search and only the entries within them are compared. The number of entries
+//! retained may be limited like MapleBusPacketStore's. All methods may be called from any thread.
+class MapleBusPacketIndex
+{
+  public:
+    //! Constructor
+    MapleBusPacketIndex();
+    //! Destructor
+    virtual ~MapleBusPacketIndex();
+
+    //! Removes all entries
+    void Clear();
+    //! Limits the number of entries retained, the same way as MapleBusPacketStore::SetMaxPackets()
+    //! @param[in] maxPackets  the least number of most recent entries to retain, 0 to retain every entry
+    void SetMaxPackets(U64 maxPackets);
+    //! Indexes the next decoded packet
+    //! @param[in] startSample  the sample number of the start of the packet; must not precede the previous packet's
+    //! @param[in] endSample  the sample number of the end of the packet
+    //! @param[in] info  the protocol level interpretation of the packet
+    //! @returns the index of the packet, which matches its packet store index when every stored packet is indexed
+    U64 AddPacket(U64 startSample, U64 endSample, const MapleBusPacketInfo& info);
+
+    //! @returns the number of packets indexed since the last Clear(), including any no longer retained
+    U64 GetNumPackets() const;
+    //! @returns the index of the oldest retained packet
+    U64 GetFirstPacketIndex() const;
+    //! Retrieves an entry
+    //! @param[in] packetIndex  the index of the packet
+    //! @param[out] entry  set to the packet's entry
+    //! @returns false iff packetIndex is out of range or no longer retained
+    bool GetEntry(U64 packetIndex, MapleBusPacketIndexEntry& entry) const;
+    //! Finds the packet which spans a sample
+    //! @param[in] sample  the sample number
+    //! @param[out] packetIndex  set to the index of the packet
+    //! @returns false iff no retained packet spans the sample
+    bool FindPacketAt(U64 sample, U64& packetIndex) const;
+    //! Finds retained packets matching a query, in order
+    //! @param[in] query  the packets to find
+    //! @param[in] firstPacket  the index of the first packet to consider, for continuing a previous search
+    //! @param[in] maxResults  the most packets to find, 0 for no limit
+    //! @param[out] packetIndices  cleared then set to the index of each matching packet
+    //! @returns the index of the packet to continue searching from if maxResults was reached, otherwise the number of
+    //!          packets indexed
+    U64 FindPackets(const MapleBusPacketQuery& query, U64 firstPacket, U64 maxResults, std::vector<U64>& packetIndices) const;
+
+    //! @returns the approximate number of bytes allocated by this index
+    U64 GetMemoryUsage() const;
+
+  private:
+    //! @returns the position within mEntries of the first entry starting at or after the sample; the mutex must be locked
+    U64 LowerBound(U64 sample) const;
+
+    //! Guards all data; the analyzer adds packets while the UI searches them
+    mutable std::mutex mMutex;
+    //! One entry per retained packet, in increasing start sample order
+    MapleBusRetainedRing<MapleBusPacketIndexEntry> mEntries;
+};
+
+#endif // MAPLEBUS_PACKET_INDEX_H
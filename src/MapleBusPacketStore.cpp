@@ -0,0 +1,282 @@
+#include "MapleBusPacketStore.h"
+
+//! Number of bytes in the frame word
+static const U32 FRAME_WORD_BYTES = 4;
+
+MapleBusPacketStore::MapleBusPacketStore() : mPackets(), mNumCrcErrors(0)
+{
+}
+
+MapleBusPacketStore::~MapleBusPacketStore()
+{
+}
+
+void MapleBusPacketStore::Clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPackets.Clear();
+    std::vector<U8>().swap(mPayload);
+    std::vector<U32>().swap(mByteEndOffsets);
+    mNumCrcErrors = 0;
+}
+
+void MapleBusPacketStore::SetMaxPackets(U64 maxPackets)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPackets.SetMaxItems(maxPackets);
+}
+
+U64 MapleBusPacketStore::AddPacket(const MapleBusPacket& packet)
+{
+    U32 numBytes = static_cast<U32>(packet.bytes.size());
+
+    MapleBusPacketRecord record;
+    record.startSample = packet.startSample;
+    record.dataStartSample = packet.dataStartSample;
+    record.endSample = packet.endSample;
+    record.frameWord = 0;
+    for (U32 i = 0; i < FRAME_WORD_BYTES && i < numBytes; ++i)
+    {
+        record.frameWord |= (static_cast<U32>(packet.bytes[i]) << (8 * i));
+    }
+    record.numBytes = numBytes;
+    U32 firstPayloadWord = 0;
+    for (U32 i = 0; i < FRAME_WORD_BYTES && FRAME_WORD_BYTES + i < numBytes; ++i)
+    {
+        firstPayloadWord |= (static_cast<U32>(packet.bytes[FRAME_WORD_BYTES + i]) << (8 * i));
+    }
+    MapleBusPacketInfo info;
+    MapleBusProtocol::InterpretPacket(record.frameWord, firstPayloadWord, numBytes, info);
+    record.function = info.function;
+    record.crc = (numBytes > FRAME_WORD_BYTES) ? packet.bytes[numBytes - 1] : 0;
+    record.crcValid = packet.crcValid;
+    record.wideByteEnds = (numBytes > 0 && packet.byteEndSamples[numBytes - 1] - packet.dataStartSample > 0xFFFFFFFF);
+    record.timing = packet.timing;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    record.payloadOffset = mPayload.size();
+    record.byteOffset = mByteEndOffsets.size();
+    if (numBytes > FRAME_WORD_BYTES + 1)
+    {
+        // Only the bytes between the frame word and the CRC byte go into the arena
+        mPayload.insert(mPayload.end(), packet.bytes.begin() + FRAME_WORD_BYTES, packet.bytes.end() - 1);
+    }
+    for (U32 i = 0; i < numBytes; ++i)
+    {
+        U64 endOffset = packet.byteEndSamples[i] - packet.dataStartSample;
+        mByteEndOffsets.push_back(static_cast<U32>(endOffset));
+        if (record.wideByteEnds)
+        {
+            mByteEndOffsets.push_back(static_cast<U32>(endOffset >> 32));
+        }
+    }
+
+    if (!record.crcValid)
+    {
+        ++mNumCrcErrors;
+    }
+
+    U64 packetIndex = mPackets.Add(record);
+    if (mPackets.Trim() > 0)
+    {
+        DropBytes();
+    }
+    return packetIndex;
+}
+
+U64 MapleBusPacketStore::GetNumPackets() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mPackets.GetNumItems();
+}
+
+U64 MapleBusPacketStore::GetFirstPacketIndex() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mPackets.GetFirstIndex();
+}
+
+U64 MapleBusPacketStore::GetNumCrcErrors() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mNumCrcErrors;
+}
+
+bool MapleBusPacketStore::GetPacket(U64 packetIndex, MapleBusPacketRecord& record) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    const MapleBusPacketRecord* found = FindRecord(packetIndex);
+    if (found == NULL)
+    {
+        return false;
+    }
+    record = *found;
+    return true;
+}
+
+bool MapleBusPacketStore::GetPacketInfo(U64 packetIndex, MapleBusPacketInfo& info) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    const MapleBusPacketRecord* found = FindRecord(packetIndex);
+    if (found == NULL)
+    {
+        return false;
+    }
+    const MapleBusPacketRecord& record = *found;
+    MapleBusProtocol::InterpretPacket(record.frameWord, record.function, record.numBytes, info);
+    return true;
+}
+
+bool MapleBusPacketStore::GetPacketBytes(U64 packetIndex, std::vector<U8>& bytes) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    const MapleBusPacketRecord* found = FindRecord(packetIndex);
+    if (found == NULL)
+    {
+        return false;
+    }
+    const MapleBusPacketRecord& record = *found;
+    bytes.resize(record.numBytes);
+    for (U32 i = 0; i < record.numBytes; ++i)
+    {
+        bytes[i] = GetByteValue(record, i);
+    }
+    return true;
+}
+
+bool MapleBusPacketStore::GetDecodedPacket(U64 packetIndex, MapleBusPacket& packet) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    const MapleBusPacketRecord* found = FindRecord(packetIndex);
+    if (found == NULL)
+    {
+        return false;
+    }
+    const MapleBusPacketRecord& record = *found;
+    packet.startSample = record.startSample;
+    packet.dataStartSample = record.dataStartSample;
+    packet.endSample = record.endSample;
+    packet.bytes.resize(record.numBytes);
+    packet.byteEndSamples.resize(record.numBytes);
+    for (U32 i = 0; i < record.numBytes; ++i)
+    {
+        packet.bytes[i] = GetByteValue(record, i);
+        packet.byteEndSamples[i] = GetByteEndSample(record, i);
+    }
+    packet.crcValid = record.crcValid;
+    packet.timing = record.timing;
+    return true;
+}
+
+const MapleBusPacketRecord* MapleBusPacketStore::FindRecord(U64 packetIndex) const
+{
+    return mPackets.Find(packetIndex);
+}
+
+void MapleBusPacketStore::DropBytes()
+{
+    // Everything before the oldest retained packet's bytes belongs to dropped packets
+    std::vector<MapleBusPacketRecord>& packets = mPackets.GetRetained();
+    U64 payloadBase = packets.front().payloadOffset;
+    U64 byteBase = packets.front().byteOffset;
+    mPayload.erase(mPayload.begin(), mPayload.begin() + static_cast<size_t>(payloadBase));
+    mByteEndOffsets.erase(mByteEndOffsets.begin(), mByteEndOffsets.begin() + static_cast<size_t>(byteBase));
+    for (std::vector<MapleBusPacketRecord>::iterator iter = packets.begin(); iter != packets.end(); ++iter)
+    {
+        iter->payloadOffset -= payloadBase;
+        iter->byteOffset -= byteBase;
+    }
+}
+
+U8 MapleBusPacketStore::GetByteValue(const MapleBusPacketRecord& record, U32 byteIndex) const
+{
+    if (byteIndex < FRAME_WORD_BYTES)
+    {
+        return static_cast<U8>(record.frameWord >> (8 * byteIndex));
+    }
+    else if (byteIndex == record.numBytes - 1)
+    {
+        return record.crc;
+    }
+    else
+    {
+        return mPayload[static_cast<size_t>(record.payloadOffset + byteIndex - FRAME_WORD_BYTES)];
+    }
+}
+
+U64 MapleBusPacketStore::GetByteEndSample(const MapleBusPacketRecord& record, U32 byteIndex) const
+{
+    if (record.wideByteEnds)
+    {
+        size_t position = static_cast<size_t>(record.byteOffset + 2 * static_cast<U64>(byteIndex));
+        return record.dataStartSample + (mByteEndOffsets[position] | (static_cast<U64>(mByteEndOffsets[position + 1]) << 32));
+    }
+    return record.dataStartSample + mByteEndOffsets[static_cast<size_t>(record.byteOffset + byteIndex)];
+}
+
+bool MapleBusPacketStore::GetByte(U64 packetIndex, U32 byteIndex, MapleBusDecodedByte& decodedByte) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    const MapleBusPacketRecord* found = FindRecord(packetIndex);
+    if (found == NULL || byteIndex >= found->numBytes)
+    {
+        return false;
+    }
+    const MapleBusPacketRecord& record = *found;
+
+    // Same accounting as MapleBusDecoder::SaveByte()
+    S32 totalBytesExpected = (record.frameWord & 0xFF) * 4 + FRAME_WORD_BYTES + 1;
+    S32 numBytesLeft = totalBytesExpected - 1 - static_cast<S32>(byteIndex);
+
+    decodedByte.startSample = (byteIndex == 0) ? record.dataStartSample : GetByteEndSample(record, byteIndex - 1);
+    decodedByte.endSample = GetByteEndSample(record, byteIndex);
+    decodedByte.value = GetByteValue(record, byteIndex);
+    decodedByte.byteCount = byteIndex + 1;
+    decodedByte.numBytesLeft = (numBytesLeft > 0) ? numBytesLeft : 0;
+    decodedByte.type = MAPLE_BUS_DATA_PAYLOAD;
+    decodedByte.crcValid = false;
+    if (byteIndex < FRAME_WORD_BYTES)
+    {
+        decodedByte.type = MAPLE_BUS_DATA_FRAME;
+    }
+    else if (decodedByte.numBytesLeft == 0)
+    {
+        decodedByte.type = MAPLE_BUS_DATA_CRC;
+        decodedByte.crcValid = (numBytesLeft == 0 && record.crcValid);
+    }
+    return true;
+}
+
+bool MapleBusPacketStore::GetWord(U64 packetIndex, U32 wordIndex, MapleBusDecodedWord& decodedWord) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    const MapleBusPacketRecord* found = FindRecord(packetIndex);
+    if (found == NULL || (wordIndex + 1) * FRAME_WORD_BYTES > found->numBytes)
+    {
+        return false;
+    }
+    const MapleBusPacketRecord& record = *found;
+
+    // Same accounting as MapleBusDecoder::SaveByte()
+    U32 firstByte = wordIndex * FRAME_WORD_BYTES;
+    S32 totalWordsExpected = (record.frameWord & 0xFF) + 1;
+    S32 numWordsLeft = totalWordsExpected - 1 - static_cast<S32>(wordIndex);
+
+    decodedWord.startSample = (firstByte == 0) ? record.dataStartSample : GetByteEndSample(record, firstByte - 1);
+    decodedWord.endSample = GetByteEndSample(record, firstByte + FRAME_WORD_BYTES - 1);
+    decodedWord.value = 0;
+    for (U32 i = 0; i < FRAME_WORD_BYTES; ++i)
+    {
+        decodedWord.value |= (static_cast<U32>(GetByteValue(record, firstByte + i)) << (8 * i));
+    }
+    decodedWord.numWordsLeft = (numWordsLeft > 0) ? numWordsLeft : 0;
+    decodedWord.type = (wordIndex == 0) ? MAPLE_BUS_DATA_FRAME : MAPLE_BUS_DATA_PAYLOAD;
+    return true;
+}
+
+U64 MapleBusPacketStore::GetMemoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mPackets.GetMemoryUsage() + mPayload.capacity() * sizeof(U8) + mByteEndOffsets.capacity() * sizeof(U32);
+}
@@ -0,0 +1,132 @@
+#ifndef MAPLEBUS_PACKET_STORE_H
+#define MAPLEBUS_PACKET_STORE_H
+
+#include "MapleBusDecoder.h"
+#include "MapleBusProtocol.h"
+#include "MapleBusRetainedRing.h"
+#include <mutex>
+#include <vector>
+
+//! One stored Maple Bus packet
+struct MapleBusPacketRecord
+{
+    //! The sample number of the start of the start sequence
+    U64 startSample;
+    //! The sample number of the end of the start sequence where the first bit begins
+    U64 dataStartSample;
+    //! The sample number of the end of the end sequence
+    U64 endSample;
+    //! Offset of the first payload byte within the payload arena; 64 bits since the arena of an unbounded capture may
+    //! grow past 4 GB
+    U64 payloadOffset;
+    //! Offset of the first byte's end sample offset within the sample offset arena
+    U64 byteOffset;
+    //! The frame word (built little endian); bytes missing from a short packet are 0
+    U32 frameWord;
+    //! The function code if the command carries one, otherwise 0
+    U32 function;
+    //! Total number of bytes received in this packet, including frame word and CRC
+    U32 numBytes;
+    //! The CRC byte; only valid if numBytes is at least 5
+    U8 crc;
+    //! true iff the expected CRC byte was received and matched (see MapleBusPacket::crcValid)
+    bool crcValid;
+    //! true iff the packet spans more samples than a U32 offset holds, such as a stalled packet at a high sample rate,
+    //! so each byte's end sample offset takes two entries of the sample offset arena, low half first
+    bool wideByteEnds;
+    //! Bit timing of the packet
+    MapleBusBitTiming timing;
+};
+
+//! Stores decoded packets compactly: one fixed size record per packet, with all payload bytes of all packets kept
+//! contiguously in a shared arena. Byte and word level views, with the same values the decoder reported, are derived on
+//! demand. The number of packets retained may be limited so that memory stays flat over long captures; packet indices
+//! keep counting from the first packet ever stored. All methods may be called from any thread.
+class MapleBusPacketStore
+{
+  public:
+    //! Constructor
+    MapleBusPacketStore();
+    //! Destructor
+    virtual ~MapleBusPacketStore();
+
+    //! Removes all packets
+    void Clear();
+    //! Limits the number of packets retained; beyond the limit, the oldest packets are dropped in batches, so between
+    //! maxPackets and twice as many are retained
+    //! @param[in] maxPackets  the least number of most recent packets to retain, 0 to retain every packet
+    void SetMaxPackets(U64 maxPackets);
+    //! Stores a packet
+    //! @param[in] packet  the packet to store
+    //! @returns the index of the stored packet
+    U64 AddPacket(const MapleBusPacket& packet);
+
+    //! @returns the number of packets stored since the last Clear(), including any no longer retained
+    U64 GetNumPackets() const;
+    //! @returns the index of the oldest retained packet; packets from here up to GetNumPackets() may be retrieved
+    U64 GetFirstPacketIndex() const;
+    //! @returns the number of stored packets without a valid CRC byte
+    U64 GetNumCrcErrors() const;
+    //! Retrieves a packet record
+    //! @param[in] packetIndex  the index of the packet
+    //! @param[out] record  set to the packet record
+    //! @returns false iff packetIndex is out of range or no longer retained
+    bool GetPacket(U64 packetIndex, MapleBusPacketRecord& record) const;
+    //! Retrieves the protocol level interpretation of a packet, computed when the packet was stored
+    //! @param[in] packetIndex  the index of the packet
+    //! @param[out] info  set to the interpretation
+    //! @returns false iff packetIndex is out of range or no longer retained
+    bool GetPacketInfo(U64 packetIndex, MapleBusPacketInfo& info) const;
+    //! Retrieves every byte of a packet, including frame word and CRC
+    //! @param[in] packetIndex  the index of the packet
+    //! @param[out] bytes  set to the packet bytes
+    //! @returns false iff packetIndex is out of range or no longer retained
+    bool GetPacketBytes(U64 packetIndex, std::vector<U8>& bytes) const;
+    //! Retrieves a packet as the decoder reported it, from which the frames of any output style may be laid out (see
+    //! MapleBusFrameLayout). The plugin doesn't use this: Logic re-runs the analyzer on any settings change, so frames are
+    //! only ever laid out as packets are decoded; MapleBusBench uses it to time laying out stored packets again
+    //! @param[in] packetIndex  the index of the packet
+    //! @param[out] packet  set to the packet; its vectors are reused
+    //! @returns false iff packetIndex is out of range or no longer retained
+    bool GetDecodedPacket(U64 packetIndex, MapleBusPacket& packet) const;
+    //! Derives a byte view of a packet
+    //! @param[in] packetIndex  the index of the packet
+    //! @param[in] byteIndex  the index of the byte within the packet
+    //! @param[out] decodedByte  set to the byte as originally reported by the decoder
+    //! @returns false iff either index is out of range or the packet is no longer retained
+    bool GetByte(U64 packetIndex, U32 byteIndex, MapleBusDecodedByte& decodedByte) const;
+    //! Derives a 32-bit word view of a packet
+    //! @param[in] packetIndex  the index of the packet
+    //! @param[in] wordIndex  the index of the word within the packet
+    //! @param[out] decodedWord  set to the word as originally reported by the decoder
+    //! @returns false iff either index is out of range, the packet is no longer retained or the word is incomplete
+    bool GetWord(U64 packetIndex, U32 wordIndex, MapleBusDecodedWord& decodedWord) const;
+
+    //! @returns the approximate number of bytes allocated by this store
+    U64 GetMemoryUsage() const;
+
+  private:
+    //! @returns the record of a packet, or NULL if out of range or no longer retained; the mutex must be locked
+    const MapleBusPacketRecord* FindRecord(U64 packetIndex) const;
+    //! Drops the bytes of packets no longer retained and rebases the retained records onto what is left; the mutex must
+    //! be locked
+    void DropBytes();
+    //! @returns the value of a byte of a packet; the mutex must be locked
+    U8 GetByteValue(const MapleBusPacketRecord& record, U32 byteIndex) const;
+    //! @returns the end sample of a byte of a packet; the mutex must be locked
+    U64 GetByteEndSample(const MapleBusPacketRecord& record, U32 byteIndex) const;
+
+    //! Guards all data; the analyzer adds packets while the UI renders them
+    mutable std::mutex mMutex;
+    //! One record per retained packet
+    MapleBusRetainedRing<MapleBusPacketRecord> mPackets;
+    //! Payload bytes of all packets
+    std::vector<U8> mPayload;
+    //! End sample of each byte of all packets, relative to the packet's dataStartSample (see
+    //! MapleBusPacketRecord::wideByteEnds)
+    std::vector<U32> mByteEndOffsets;
+    //! Number of packets without a valid CRC byte
+    U64 mNumCrcErrors;
+};
+
+#endif // MAPLEBUS_PACKET_STORE_H
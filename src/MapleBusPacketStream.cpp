@@ -0,0 +1,112 @@
+#include "MapleBusPacketStream.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//! Upper case hex digits, indexed by nibble
+static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+MapleBusPacketStreamWriter::MapleBusPacketStreamWriter() : mWriter(NULL), mNumPackets(0)
+{
+}
+
+MapleBusPacketStreamWriter::~MapleBusPacketStreamWriter()
+{
+    Close();
+}
+
+bool MapleBusPacketStreamWriter::Open(const char* path)
+{
+    Close();
+    mNumPackets = 0;
+
+#ifndef _WIN32
+    // Opening a named pipe for writing normally waits for a reader, which would stall the decoder indefinitely; a
+    // non-blocking open fails at once if there is none, and holding it open keeps the reader while the stream opens
+    int probe = -1;
+    struct stat status;
+    if (stat(path, &status) == 0 && S_ISFIFO(status.st_mode))
+    {
+        probe = open(path, O_WRONLY | O_NONBLOCK);
+        if (probe < 0)
+        {
+            return false;
+        }
+    }
+#endif
+
+    MapleBusExportWriter* writer = new MapleBusExportWriter();
+    bool opened = writer->Open(path);
+#ifndef _WIN32
+    if (probe >= 0)
+    {
+        close(probe);
+    }
+#endif
+    if (!opened)
+    {
+        delete writer;
+        return false;
+    }
+    mWriter = writer;
+    return true;
+}
+
+bool MapleBusPacketStreamWriter::Close()
+{
+    if (mWriter == NULL)
+    {
+        return false;
+    }
+    bool writeOk = mWriter->Close();
+    delete mWriter;
+    mWriter = NULL;
+    return writeOk;
+}
+
+bool MapleBusPacketStreamWriter::IsOpen() const
+{
+    return mWriter != NULL;
+}
+
+void MapleBusPacketStreamWriter::AddPacket(const MapleBusPacket& packet)
+{
+    if (mWriter == NULL)
+    {
+        return;
+    }
+
+    mWriter->AddDecimal(packet.startSample);
+    mWriter->AddChar(',');
+    mWriter->AddDecimal(packet.endSample);
+    mWriter->AddChar(',');
+    for (size_t i = 0; i < packet.bytes.size(); ++i)
+    {
+        if (i > 0)
+        {
+            mWriter->AddChar(' ');
+        }
+        mWriter->AddChar(HEX_DIGITS[packet.bytes[i] >> 4]);
+        mWriter->AddChar(HEX_DIGITS[packet.bytes[i] & 0x0F]);
+    }
+    if (!packet.crcValid)
+    {
+        mWriter->AddString(",bad CRC", 8);
+    }
+    mWriter->AddChar('\n');
+    ++mNumPackets;
+}
+
+bool MapleBusPacketStreamWriter::WritePending()
+{
+    return mWriter != NULL && mWriter->WritePending();
+}
+
+U64 MapleBusPacketStreamWriter::GetNumPackets() const
+{
+    return mNumPackets;
+}
@@ -0,0 +1,51 @@
+#ifndef MAPLEBUS_PACKET_STREAM_H
+#define MAPLEBUS_PACKET_STREAM_H
+
+#include "MapleBusDecoder.h"
+#include "MapleBusExportWriter.h"
+
+//! Streams each packet to a file or named pipe as it is decoded, so that a live capture can be consumed outside of the
+//! Logic application while only a bounded number of recent packets are kept in memory (see
+//! MapleBusPacketStore::SetMaxPackets()). Each packet is one line of text, the same as MapleBusDecode prints:
+//!
+//!     <start sample>,<end sample>,<each byte in hex, space separated>[,bad CRC]
+//!
+//! Lines are buffered like any other export and only written out when the buffer fills or WritePending() is called, so
+//! streaming doesn't add a write per packet. The buffer is only allocated once a stream opens. Opening a named pipe
+//! which has no reader fails at once rather than waiting for one; once open, writes wait for the reader to keep up.
+class MapleBusPacketStreamWriter
+{
+  public:
+    //! Constructor
+    MapleBusPacketStreamWriter();
+    //! Destructor; writes anything pending and closes the stream if still open
+    virtual ~MapleBusPacketStreamWriter();
+
+    //! Opens the stream, closing any stream already open
+    //! @param[in] path  the file or named pipe to write
+    //! @returns false iff it could not be opened, including a named pipe with no reader
+    bool Open(const char* path);
+    //! Writes anything pending and closes the stream
+    //! @returns false iff no stream was open or any write failed
+    bool Close();
+    //! @returns true iff a stream is open
+    bool IsOpen() const;
+
+    //! Adds a decoded packet; does nothing while no stream is open
+    //! @param[in] packet  the packet to add
+    void AddPacket(const MapleBusPacket& packet);
+    //! Writes out the lines added so far; call whenever decoding catches up with the capture
+    //! @returns false iff no stream is open or any write failed
+    bool WritePending();
+
+    //! @returns the number of packets added since the stream was opened
+    U64 GetNumPackets() const;
+
+  private:
+    //! Formats and buffers the lines; NULL while no stream is open
+    MapleBusExportWriter* mWriter;
+    //! Number of packets added since the stream was opened
+    U64 mNumPackets;
+};
+
+#endif // MAPLEBUS_PACKET_STREAM_H
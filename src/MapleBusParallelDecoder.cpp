@@ -0,0 +1,450 @@
+#include "MapleBusParallelDecoder.h"
+#include <algorithm>
+#include <thread>
+
+//! Number of chunks created per thread so that threads which finish early may take on more work
+static const U32 CHUNKS_PER_THREAD = 4;
+//! Minimum number of transitions per chunk; smaller chunks cost more in overhead than they gain in parallelism
+static const size_t MIN_CHUNK_TRANSITIONS = 64 * 1024;
+//! Number of transition gaps sampled to estimate the phase length
+static const size_t PHASE_SAMPLE_GAPS = 4096;
+//! Minimum length of an idle gap, in phases; both lines are high for at most 3 phases within a packet
+static const U64 MIN_IDLE_PHASES = 8;
+
+//! A contiguous run of transitions along with the recorded results of decoding it
+class MapleBusParallelDecoder::Chunk : public MapleBusDecoderListener
+{
+  public:
+    Chunk(U8 initialLines, const MapleBusTransition* begin, const MapleBusTransition* end)
+        : mDecoder(this), mInitialLines(initialLines), mBegin(begin), mEnd(end)
+    {
+    }
+
+    //! Decodes all transitions of this chunk from a reset decoder
+    void Decode()
+    {
+        mDecoder.Reset(mInitialLines);
+        DecodeWith(&mDecoder);
+    }
+
+    //! Decodes all transitions of this chunk using the given decoder's current state
+    void DecodeWith(MapleBusDecoder* decoder) const
+    {
+        for (const MapleBusTransition* transition = mBegin; transition < mEnd; ++transition)
+        {
+            decoder->ProcessTransition(*transition);
+        }
+    }
+
+    //! @returns true iff a packet started before any error was recorded
+    bool StartsWithPacket() const
+    {
+        for (std::vector<Event>::const_iterator iter = mEvents.begin(); iter != mEvents.end(); ++iter)
+        {
+            if (iter->type == EVENT_PACKET_START || iter->type == EVENT_ERROR)
+            {
+                return (iter->type == EVENT_PACKET_START);
+            }
+        }
+        return false;
+    }
+
+    //! Delivers all recorded results to the given listener then clears them
+    void Replay(MapleBusDecoderListener* listener)
+    {
+        Replay(listener, false, 0, 0);
+    }
+
+    //! Delivers all recorded results to the given listener, reporting the end of a previous chunk's error before the
+    //! first packet, then clears them
+    //! @param[in] listener  receives the results
+    //! @param[in] resync  true iff the previous chunk's error is to be resynced (see MapleBusDecoder::GetPendingResync())
+    //! @param[in] errorSample  the error sample to report
+    //! @param[in] resumeSample  the resume sample to report
+    void Replay(MapleBusDecoderListener* listener, bool resync, U64 errorSample, U64 resumeSample)
+    {
+        for (std::vector<Event>::const_iterator iter = mEvents.begin(); iter != mEvents.end(); ++iter)
+        {
+            switch (iter->type)
+            {
+            case EVENT_PACKET_START:
+                if (resync)
+                {
+                    listener->OnResync(errorSample, resumeSample);
+                    resync = false;
+                }
+                listener->OnPacketStart(iter->sample, iter->endSample);
+                break;
+
+            case EVENT_BIT:
+                listener->OnBit(iter->sample, iter->clockIsA, iter->value);
+                break;
+
+            case EVENT_BYTE:
+                listener->OnByte(mBytes[iter->index]);
+                break;
+
+            case EVENT_WORD:
+                listener->OnWord(mWords[iter->index]);
+                break;
+
+            case EVENT_PACKET_END:
+                listener->OnPacketEnd(mPackets[iter->index]);
+                break;
+
+            case EVENT_ERROR:
+                listener->OnError(mErrors[iter->index]);
+                break;
+
+            case EVENT_RESYNC:
+                listener->OnResync(iter->sample, iter->endSample);
+                break;
+            }
+        }
+
+        Clear();
+    }
+
+    //! Discards all recorded results
+    void Clear()
+    {
+        // Swapping releases the memory rather than only resetting the size
+        std::vector<Event>().swap(mEvents);
+        std::vector<MapleBusDecodedByte>().swap(mBytes);
+        std::vector<MapleBusDecodedWord>().swap(mWords);
+        std::vector<MapleBusPacket>().swap(mPackets);
+        std::vector<MapleBusDecodeError>().swap(mErrors);
+    }
+
+    virtual void OnPacketStart(U64 startSample, U64 endSample)
+    {
+        AddEvent(EVENT_PACKET_START, startSample, endSample, 0);
+    }
+
+    virtual void OnBit(U64 clockEdgeSample, bool clockIsA, bool value)
+    {
+        Event event;
+        event.type = EVENT_BIT;
+        event.clockIsA = clockIsA;
+        event.value = value;
+        event.index = 0;
+        event.sample = clockEdgeSample;
+        event.endSample = clockEdgeSample;
+        mEvents.push_back(event);
+    }
+
+    virtual void OnByte(const MapleBusDecodedByte& decodedByte)
+    {
+        AddEvent(EVENT_BYTE, 0, 0, static_cast<U32>(mBytes.size()));
+        mBytes.push_back(decodedByte);
+    }
+
+    virtual void OnWord(const MapleBusDecodedWord& decodedWord)
+    {
+        AddEvent(EVENT_WORD, 0, 0, static_cast<U32>(mWords.size()));
+        mWords.push_back(decodedWord);
+    }
+
+    virtual void OnPacketEnd(const MapleBusPacket& packet)
+    {
+        AddEvent(EVENT_PACKET_END, 0, 0, static_cast<U32>(mPackets.size()));
+        mPackets.push_back(packet);
+    }
+
+    virtual void OnError(const MapleBusDecodeError& error)
+    {
+        AddEvent(EVENT_ERROR, 0, 0, static_cast<U32>(mErrors.size()));
+        mErrors.push_back(error);
+    }
+
+    virtual void OnResync(U64 errorSample, U64 resumeSample)
+    {
+        AddEvent(EVENT_RESYNC, errorSample, resumeSample, 0);
+    }
+
+    //! Decoder of this chunk
+    MapleBusDecoder mDecoder;
+
+  private:
+    //! Recorded listener calls
+    enum EventType
+    {
+        EVENT_PACKET_START,
+        EVENT_BIT,
+        EVENT_BYTE,
+        EVENT_WORD,
+        EVENT_PACKET_END,
+        EVENT_ERROR,
+        EVENT_RESYNC
+    };
+
+    //! A single recorded listener call
+    struct Event
+    {
+        //! The listener call (see EventType)
+        U8 type;
+        //! OnBit clockIsA parameter
+        bool clockIsA;
+        //! OnBit value parameter
+        bool value;
+        //! Index into mBytes, mWords, mPackets or mErrors
+        U32 index;
+        //! Sample number parameter
+        U64 sample;
+        //! OnPacketStart endSample or OnResync resumeSample parameter
+        U64 endSample;
+    };
+
+    void AddEvent(EventType type, U64 sample, U64 endSample, U32 index)
+    {
+        Event event;
+        event.type = type;
+        event.clockIsA = false;
+        event.value = false;
+        event.index = index;
+        event.sample = sample;
+        event.endSample = endSample;
+        mEvents.push_back(event);
+    }
+
+    //! The state of both lines before the first transition
+    U8 mInitialLines;
+    //! The first transition of this chunk
+    const MapleBusTransition* mBegin;
+    //! One past the last transition of this chunk
+    const MapleBusTransition* mEnd;
+    //! Recorded listener calls in order
+    std::vector<Event> mEvents;
+    //! Recorded bytes
+    std::vector<MapleBusDecodedByte> mBytes;
+    //! Recorded words
+    std::vector<MapleBusDecodedWord> mWords;
+    //! Recorded packets
+    std::vector<MapleBusPacket> mPackets;
+    //! Recorded errors
+    std::vector<MapleBusDecodeError> mErrors;
+};
+
+MapleBusParallelDecoder::MapleBusParallelDecoder(MapleBusDecoderListener* listener)
+    : mListener(listener), mNextChunk(0), mTimingCheck(MAPLE_BUS_TIMING_OFF), mTolerancePercent(0), mNumChunks(0), mNumResyncs(0)
+{
+}
+
+MapleBusParallelDecoder::~MapleBusParallelDecoder()
+{
+    DeleteChunks();
+}
+
+void MapleBusParallelDecoder::SetTimingCheck(MapleBusTimingCheck check, U32 tolerancePercent)
+{
+    mTimingCheck = check;
+    mTolerancePercent = tolerancePercent;
+}
+
+void MapleBusParallelDecoder::Run(U8 initialLines, const MapleBusTransition* transitions, size_t numTransitions,
+                                  U32 numThreads)
+{
+    DeleteChunks();
+    mNumChunks = 0;
+    mNumResyncs = 0;
+
+    if (numThreads == 0)
+    {
+        numThreads = std::thread::hardware_concurrency();
+        if (numThreads == 0)
+        {
+            numThreads = 1;
+        }
+    }
+
+    size_t numChunks = static_cast<size_t>(numThreads) * CHUNKS_PER_THREAD;
+    size_t maxChunks = numTransitions / MIN_CHUNK_TRANSITIONS;
+    if (numThreads == 1 || numChunks > maxChunks)
+    {
+        numChunks = (numThreads == 1 || maxChunks == 0) ? 1 : maxChunks;
+    }
+    CreateChunks(initialLines, transitions, numTransitions, static_cast<U32>(numChunks));
+
+    mNumChunks = static_cast<U32>(mChunks.size());
+    mNextChunk = 0;
+    mChunkDone.assign(mChunks.size(), false);
+    if (numThreads > mChunks.size())
+    {
+        numThreads = static_cast<U32>(mChunks.size());
+    }
+
+    std::vector<std::thread> threads;
+    for (U32 i = 0; i < numThreads; ++i)
+    {
+        threads.push_back(std::thread(&MapleBusParallelDecoder::WorkerThread, this));
+    }
+
+    // Deliver results in order as chunks complete. A chunk which does not end idle carries its decoder into the next.
+    Chunk* carry = NULL;
+    for (size_t i = 0; i < mChunks.size(); ++i)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            while (!mChunkDone[i])
+            {
+                mChunkDoneCondition.wait(lock);
+            }
+        }
+
+        Chunk* chunk = mChunks[i];
+        U64 errorSample = 0;
+        U64 resumeSample = 0;
+        if (carry != NULL && carry->mDecoder.GetPendingResync(errorSample, resumeSample) && chunk->StartsWithPacket())
+        {
+            // The chunk began idle after an error; its first packet ends the error the same as it would have serially
+            chunk->Replay(mListener, true, errorSample, resumeSample);
+            carry = chunk->mDecoder.IsIdle() ? NULL : chunk;
+        }
+        else if (carry != NULL)
+        {
+            // The split landed where the bus was not idle; redo this chunk serially
+            ++mNumResyncs;
+            chunk->Clear();
+            chunk->DecodeWith(&carry->mDecoder);
+            carry->Replay(mListener);
+            if (carry->mDecoder.IsIdle())
+            {
+                carry = NULL;
+            }
+        }
+        else
+        {
+            chunk->Replay(mListener);
+            if (!chunk->mDecoder.IsIdle())
+            {
+                carry = chunk;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i].join();
+    }
+
+    DeleteChunks();
+}
+
+U32 MapleBusParallelDecoder::GetNumChunks() const
+{
+    return mNumChunks;
+}
+
+U32 MapleBusParallelDecoder::GetNumResyncs() const
+{
+    return mNumResyncs;
+}
+
+void MapleBusParallelDecoder::CreateChunks(U8 initialLines, const MapleBusTransition* transitions, size_t numTransitions,
+                                           U32 numChunks)
+{
+    U64 minIdleSamples = (numChunks > 1) ? GetMinIdleSamples(transitions, numTransitions) : 0;
+    size_t begin = 0;
+    U8 lines = initialLines;
+    for (U32 i = 1; i <= numChunks; ++i)
+    {
+        size_t end = numTransitions;
+        if (i < numChunks)
+        {
+            size_t target = numTransitions / numChunks * i;
+            size_t limit = numTransitions / numChunks * (i + 1);
+            end = FindSplitPoint(transitions, begin, target, limit, minIdleSamples);
+            if (end <= begin)
+            {
+                // No idle gap since the last split; this chunk extends to the next one found
+                continue;
+            }
+        }
+
+        mChunks.push_back(new Chunk(lines, transitions + begin, transitions + end));
+        mChunks.back()->mDecoder.SetTimingCheck(mTimingCheck, mTolerancePercent);
+        if (end > 0)
+        {
+            lines = transitions[end - 1].lines;
+        }
+        begin = end;
+    }
+}
+
+U64 MapleBusParallelDecoder::GetMinIdleSamples(const MapleBusTransition* transitions, size_t numTransitions)
+{
+    // Most transitions are within packets, one phase apart, so the median gap between them is the phase length
+    std::vector<U64> gaps;
+    size_t step = (numTransitions > PHASE_SAMPLE_GAPS) ? numTransitions / PHASE_SAMPLE_GAPS : 1;
+    for (size_t i = 1; i < numTransitions; i += step)
+    {
+        gaps.push_back(transitions[i].sample - transitions[i - 1].sample);
+    }
+    if (gaps.empty())
+    {
+        return 1;
+    }
+    std::nth_element(gaps.begin(), gaps.begin() + gaps.size() / 2, gaps.end());
+    U64 phaseSamples = (gaps[gaps.size() / 2] > 0) ? gaps[gaps.size() / 2] : 1;
+    return phaseSamples * MIN_IDLE_PHASES;
+}
+
+size_t MapleBusParallelDecoder::FindSplitPoint(const MapleBusTransition* transitions, size_t begin, size_t target,
+                                               size_t limit, U64 minIdleSamples) const
+{
+    // Split before the first transition which follows an idle gap, forward of the target then back towards begin
+    for (size_t i = (target > begin) ? target : begin + 1; i < limit; ++i)
+    {
+        if (IsIdleGap(transitions, i, minIdleSamples))
+        {
+            return i;
+        }
+    }
+    for (size_t i = (target < limit) ? target : limit; i > begin + 1; --i)
+    {
+        if (IsIdleGap(transitions, i - 1, minIdleSamples))
+        {
+            return i - 1;
+        }
+    }
+    return begin;
+}
+
+bool MapleBusParallelDecoder::IsIdleGap(const MapleBusTransition* transitions, size_t index, U64 minIdleSamples)
+{
+    return transitions[index - 1].lines == MAPLE_BUS_LINES_AB &&
+           transitions[index].sample - transitions[index - 1].sample >= minIdleSamples;
+}
+
+void MapleBusParallelDecoder::WorkerThread()
+{
+    for (;;)
+    {
+        size_t index;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mNextChunk >= mChunks.size())
+            {
+                return;
+            }
+            index = mNextChunk++;
+        }
+
+        mChunks[index]->Decode();
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mChunkDone[index] = true;
+        }
+        mChunkDoneCondition.notify_all();
+    }
+}
+
+void MapleBusParallelDecoder::DeleteChunks()
+{
+    for (size_t i = 0; i < mChunks.size(); ++i)
+    {
+        delete mChunks[i];
+    }
+    mChunks.clear();
+}
@@ -0,0 +1,91 @@
+#ifndef MAPLEBUS_PARALLEL_DECODER_H
+#define MAPLEBUS_PARALLEL_DECODER_H
+
+#include "MapleBusDecoder.h"
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+//! Decodes a transition array in chunks across multiple threads, delivering results in order as if decoded serially.
+//!
+//! Chunks are split at the idle gap (both lines high for several times the longest stretch within a packet) nearest
+//! each of a set of evenly spaced targets, and each chunk is decoded from an idle state. Chunks without an idle gap
+//! between them are merged rather than split within a packet. A chunk whose predecessor did not actually end idle -
+//! such as when a packet stalled for as long as an idle gap - has its results discarded and is decoded again serially,
+//! continuing the decoder of the previous chunk, so output always matches a single MapleBusDecoder over the whole
+//! array. A chunk which begins while the previous one is only waiting to resync after an error keeps its own results,
+//! with the end of the error reported before its first packet.
+class MapleBusParallelDecoder
+{
+  public:
+    //! Constructor
+    //! @param[in] listener  receives all decoded data, always from the thread which calls Run()
+    MapleBusParallelDecoder(MapleBusDecoderListener* listener);
+    //! Destructor
+    virtual ~MapleBusParallelDecoder();
+
+    //! Sets the bit timing check of every chunk's decoder (see MapleBusDecoder::SetTimingCheck())
+    //! @param[in] check  what to do with a bit period outside tolerance
+    //! @param[in] tolerancePercent  how far a bit period may be from nominal, in percent
+    void SetTimingCheck(MapleBusTimingCheck check, U32 tolerancePercent);
+
+    //! Decodes every transition of the given array
+    //! @param[in] initialLines  the state of both lines before the first transition (see MapleBusLineMask)
+    //! @param[in] transitions  the transitions to decode
+    //! @param[in] numTransitions  the number of transitions in the array
+    //! @param[in] numThreads  the number of decoding threads, 0 for one per hardware thread
+    void Run(U8 initialLines, const MapleBusTransition* transitions, size_t numTransitions, U32 numThreads);
+
+    //! @returns the number of chunks the last run was split into
+    U32 GetNumChunks() const;
+    //! @returns the number of chunks of the last run which had to be decoded again serially
+    U32 GetNumResyncs() const;
+
+  private:
+    class Chunk;
+
+    //! Selects chunk boundaries and creates all chunks
+    void CreateChunks(U8 initialLines, const MapleBusTransition* transitions, size_t numTransitions, U32 numChunks);
+    //! @returns the least number of samples both lines must be high for the bus to be idle, from the phase length
+    //!          estimated over the transitions
+    static U64 GetMinIdleSamples(const MapleBusTransition* transitions, size_t numTransitions);
+    //! Finds where to begin a chunk near a target index: the first transition after an idle gap at or past the target,
+    //! otherwise the last one before it
+    //! @param[in] transitions  the transitions to decode
+    //! @param[in] begin  the index of the first transition of the previous chunk
+    //! @param[in] target  the index to split near
+    //! @param[in] limit  the index to search forward up to
+    //! @param[in] minIdleSamples  the least length of an idle gap (see GetMinIdleSamples())
+    //! @returns the index of the transition to begin the chunk at, or begin if there is no idle gap after it
+    size_t FindSplitPoint(const MapleBusTransition* transitions, size_t begin, size_t target, size_t limit,
+                          U64 minIdleSamples) const;
+    //! @returns true iff both lines were high for at least minIdleSamples before the transition at the given index
+    static bool IsIdleGap(const MapleBusTransition* transitions, size_t index, U64 minIdleSamples);
+    //! Decodes chunks until none are left; run by each worker thread
+    void WorkerThread();
+    //! Deletes all chunks
+    void DeleteChunks();
+
+    //! Receives all decoded data
+    MapleBusDecoderListener* mListener;
+    //! All chunks of the current run in order
+    std::vector<Chunk*> mChunks;
+    //! Index of the next chunk to be taken by a worker thread
+    size_t mNextChunk;
+    //! Set for each chunk once decoded by a worker thread
+    std::vector<bool> mChunkDone;
+    //! Guards mNextChunk and mChunkDone
+    std::mutex mMutex;
+    //! Signaled each time a chunk is decoded
+    std::condition_variable mChunkDoneCondition;
+    //! Bit timing check applied to each chunk's decoder
+    MapleBusTimingCheck mTimingCheck;
+    //! Bit timing tolerance applied to each chunk's decoder
+    U32 mTolerancePercent;
+    //! Number of chunks of the last run
+    U32 mNumChunks;
+    //! Number of chunks which were decoded again serially
+    U32 mNumResyncs;
+};
+
+#endif // MAPLEBUS_PARALLEL_DECODER_H
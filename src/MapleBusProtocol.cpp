@@ -0,0 +1,228 @@
+#include "MapleBusProtocol.h"
+#include <stdio.h>
+
+//! Number of bytes in the frame word
+static const U32 FRAME_WORD_BYTES = 4;
+//! Address bit of the main peripheral
+static const U8 MAIN_PERIPHERAL_BIT = 0x20;
+//! Address bits of all sub-peripherals
+static const U8 SUB_PERIPHERAL_MASK = 0x1F;
+
+//! A name for each known function bit
+struct FunctionName
+{
+    U32 function;
+    const char* name;
+};
+
+static const FunctionName FUNCTION_NAMES[] = {
+    {MAPLE_BUS_FUNC_CONTROLLER, "Controller"},
+    {MAPLE_BUS_FUNC_STORAGE, "Storage"},
+    {MAPLE_BUS_FUNC_SCREEN, "Screen"},
+    {MAPLE_BUS_FUNC_TIMER, "Timer"},
+    {MAPLE_BUS_FUNC_AUDIO_INPUT, "Audio Input"},
+    {MAPLE_BUS_FUNC_AR_GUN, "AR Gun"},
+    {MAPLE_BUS_FUNC_KEYBOARD, "Keyboard"},
+    {MAPLE_BUS_FUNC_GUN, "Gun"},
+    {MAPLE_BUS_FUNC_VIBRATION, "Vibration"},
+    {MAPLE_BUS_FUNC_MOUSE, "Mouse"}
+};
+
+void MapleBusProtocol::InterpretPacket(U32 frameWord, U32 firstPayloadWord, U32 numBytes, MapleBusPacketInfo& info)
+{
+    info.numWords = static_cast<U8>(frameWord);
+    info.sender = static_cast<U8>(frameWord >> 8);
+    info.recipient = static_cast<U8>(frameWord >> 16);
+    info.command = static_cast<U8>(frameWord >> 24);
+    info.hasFrameWord = (numBytes >= FRAME_WORD_BYTES);
+    info.hasFunction = (CommandHasFunction(info.command) && info.numWords > 0 && numBytes >= 2 * FRAME_WORD_BYTES);
+    info.function = info.hasFunction ? firstPayloadWord : 0;
+}
+
+void MapleBusProtocol::InterpretAddress(U8 address, MapleBusAddressInfo& info)
+{
+    info.port = address >> 6;
+    info.subPeripheral = 0;
+    info.attachedMask = 0;
+    if ((address & MAIN_PERIPHERAL_BIT) != 0)
+    {
+        info.unit = MAPLE_BUS_UNIT_MAIN;
+        info.attachedMask = address & SUB_PERIPHERAL_MASK;
+    }
+    else if ((address & SUB_PERIPHERAL_MASK) != 0)
+    {
+        info.unit = MAPLE_BUS_UNIT_SUB;
+        // Sub-peripherals only ever set their own bit; take the lowest if more are set
+        U8 mask = address & SUB_PERIPHERAL_MASK;
+        info.subPeripheral = 1;
+        while ((mask & 1) == 0)
+        {
+            mask >>= 1;
+            ++info.subPeripheral;
+        }
+    }
+    else
+    {
+        info.unit = MAPLE_BUS_UNIT_HOST;
+    }
+}
+
+bool MapleBusProtocol::CommandHasFunction(U8 command)
+{
+    switch (command)
+    {
+    case MAPLE_BUS_CMD_DEVICE_INFO:
+    case MAPLE_BUS_CMD_EXTENDED_DEVICE_INFO:
+    case MAPLE_BUS_CMD_DATA_TRANSFER:
+    case MAPLE_BUS_CMD_GET_CONDITION:
+    case MAPLE_BUS_CMD_GET_MEMORY_INFO:
+    case MAPLE_BUS_CMD_BLOCK_READ:
+    case MAPLE_BUS_CMD_BLOCK_WRITE:
+    case MAPLE_BUS_CMD_GET_LAST_ERROR:
+    case MAPLE_BUS_CMD_SET_CONDITION:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+bool MapleBusProtocol::IsResponseTo(const MapleBusPacketInfo& command, const MapleBusPacketInfo& response)
+{
+    MapleBusAddressInfo commandSender;
+    InterpretAddress(command.sender, commandSender);
+    if (commandSender.unit != MAPLE_BUS_UNIT_HOST || response.recipient != command.sender)
+    {
+        return false;
+    }
+
+    // A main peripheral's address also reports which sub-peripherals are attached, so only compare the unit
+    MapleBusAddressInfo commandRecipient;
+    MapleBusAddressInfo responseSender;
+    InterpretAddress(command.recipient, commandRecipient);
+    InterpretAddress(response.sender, responseSender);
+    return (commandRecipient.port == responseSender.port && commandRecipient.unit == responseSender.unit &&
+            commandRecipient.subPeripheral == responseSender.subPeripheral);
+}
+
+const char* MapleBusProtocol::GetCommandName(U8 command)
+{
+    switch (command)
+    {
+    case MAPLE_BUS_CMD_DEVICE_REQUEST:
+        return "Device Request";
+    case MAPLE_BUS_CMD_ALL_STATUS_REQUEST:
+        return "All Status Request";
+    case MAPLE_BUS_CMD_RESET:
+        return "Reset";
+    case MAPLE_BUS_CMD_SHUTDOWN:
+        return "Shutdown";
+    case MAPLE_BUS_CMD_DEVICE_INFO:
+        return "Device Info";
+    case MAPLE_BUS_CMD_EXTENDED_DEVICE_INFO:
+        return "Extended Device Info";
+    case MAPLE_BUS_CMD_ACK:
+        return "Ack";
+    case MAPLE_BUS_CMD_DATA_TRANSFER:
+        return "Data Transfer";
+    case MAPLE_BUS_CMD_GET_CONDITION:
+        return "Get Condition";
+    case MAPLE_BUS_CMD_GET_MEMORY_INFO:
+        return "Get Memory Info";
+    case MAPLE_BUS_CMD_BLOCK_READ:
+        return "Block Read";
+    case MAPLE_BUS_CMD_BLOCK_WRITE:
+        return "Block Write";
+    case MAPLE_BUS_CMD_GET_LAST_ERROR:
+        return "Get Last Error";
+    case MAPLE_BUS_CMD_SET_CONDITION:
+        return "Set Condition";
+    case MAPLE_BUS_CMD_FILE_ERROR:
+        return "File Error";
+    case MAPLE_BUS_CMD_RESEND:
+        return "Resend";
+    case MAPLE_BUS_CMD_UNKNOWN_COMMAND:
+        return "Unknown Command";
+    case MAPLE_BUS_CMD_FUNCTION_NOT_SUPPORTED:
+        return "Function Not Supported";
+    case MAPLE_BUS_CMD_NO_RESPONSE:
+        return "No Response";
+    default:
+        return NULL;
+    }
+}
+
+void MapleBusProtocol::GetCommandString(U8 command, char* str, size_t len)
+{
+    const char* name = GetCommandName(command);
+    if (name != NULL)
+    {
+        snprintf(str, len, "%s", name);
+    }
+    else
+    {
+        snprintf(str, len, "Command 0x%02X", command);
+    }
+}
+
+void MapleBusProtocol::GetFunctionString(U32 function, char* str, size_t len)
+{
+    size_t pos = 0;
+    str[0] = '\0';
+    U32 unnamed = function;
+    for (U32 i = 0; i < sizeof(FUNCTION_NAMES) / sizeof(FUNCTION_NAMES[0]) && pos < len; ++i)
+    {
+        if ((function & FUNCTION_NAMES[i].function) != 0)
+        {
+            int written = snprintf(str + pos, len - pos, "%s%s", (pos > 0) ? "/" : "", FUNCTION_NAMES[i].name);
+            pos += (written > 0) ? written : 0;
+            unnamed &= ~FUNCTION_NAMES[i].function;
+        }
+    }
+    if ((unnamed != 0 || function == 0) && pos < len)
+    {
+        snprintf(str + pos, len - pos, "%s0x%08X", (pos > 0) ? "/" : "", unnamed);
+    }
+}
+
+void MapleBusProtocol::GetAddressString(U8 address, char* str, size_t len)
+{
+    MapleBusAddressInfo info;
+    InterpretAddress(address, info);
+    char port = static_cast<char>('A' + info.port);
+    switch (info.unit)
+    {
+    case MAPLE_BUS_UNIT_HOST:
+        snprintf(str, len, "Host %c", port);
+        break;
+
+    case MAPLE_BUS_UNIT_MAIN:
+        snprintf(str, len, "%c Main", port);
+        break;
+
+    default:
+    case MAPLE_BUS_UNIT_SUB:
+        snprintf(str, len, "%c Sub %u", port, info.subPeripheral);
+        break;
+    }
+}
+
+void MapleBusProtocol::GetDescription(const MapleBusPacketInfo& info, char* str, size_t len)
+{
+    char command_str[32];
+    char sender_str[16];
+    char recipient_str[16];
+    GetCommandString(info.command, command_str, sizeof(command_str));
+    GetAddressString(info.sender, sender_str, sizeof(sender_str));
+    GetAddressString(info.recipient, recipient_str, sizeof(recipient_str));
+    if (info.hasFunction)
+    {
+        char function_str[128];
+        GetFunctionString(info.function, function_str, sizeof(function_str));
+        snprintf(str, len, "%s %s -> %s: %s", command_str, sender_str, recipient_str, function_str);
+    }
+    else
+    {
+        snprintf(str, len, "%s %s -> %s", command_str, sender_str, recipient_str);
+    }
+}
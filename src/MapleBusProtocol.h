@@ -0,0 +1,132 @@
+#ifndef MAPLEBUS_PROTOCOL_H
+#define MAPLEBUS_PROTOCOL_H
+
+#include <LogicPublicTypes.h>
+#include <stddef.h>
+
+//! Maple Bus command codes (the most significant byte of the frame word)
+enum MapleBusCommand
+{
+    MAPLE_BUS_CMD_DEVICE_REQUEST = 0x01,
+    MAPLE_BUS_CMD_ALL_STATUS_REQUEST = 0x02,
+    MAPLE_BUS_CMD_RESET = 0x03,
+    MAPLE_BUS_CMD_SHUTDOWN = 0x04,
+    MAPLE_BUS_CMD_DEVICE_INFO = 0x05,
+    MAPLE_BUS_CMD_EXTENDED_DEVICE_INFO = 0x06,
+    MAPLE_BUS_CMD_ACK = 0x07,
+    MAPLE_BUS_CMD_DATA_TRANSFER = 0x08,
+    MAPLE_BUS_CMD_GET_CONDITION = 0x09,
+    MAPLE_BUS_CMD_GET_MEMORY_INFO = 0x0A,
+    MAPLE_BUS_CMD_BLOCK_READ = 0x0B,
+    MAPLE_BUS_CMD_BLOCK_WRITE = 0x0C,
+    MAPLE_BUS_CMD_GET_LAST_ERROR = 0x0D,
+    MAPLE_BUS_CMD_SET_CONDITION = 0x0E,
+    MAPLE_BUS_CMD_FILE_ERROR = 0xFB,
+    MAPLE_BUS_CMD_RESEND = 0xFC,
+    MAPLE_BUS_CMD_UNKNOWN_COMMAND = 0xFD,
+    MAPLE_BUS_CMD_FUNCTION_NOT_SUPPORTED = 0xFE,
+    MAPLE_BUS_CMD_NO_RESPONSE = 0xFF
+};
+
+//! Maple Bus function codes (the first payload word of function specific commands); may be combined in device info
+enum MapleBusFunction
+{
+    MAPLE_BUS_FUNC_CONTROLLER = 0x00000001,
+    MAPLE_BUS_FUNC_STORAGE = 0x00000002,
+    MAPLE_BUS_FUNC_SCREEN = 0x00000004,
+    MAPLE_BUS_FUNC_TIMER = 0x00000008,
+    MAPLE_BUS_FUNC_AUDIO_INPUT = 0x00000010,
+    MAPLE_BUS_FUNC_AR_GUN = 0x00000020,
+    MAPLE_BUS_FUNC_KEYBOARD = 0x00000040,
+    MAPLE_BUS_FUNC_GUN = 0x00000080,
+    MAPLE_BUS_FUNC_VIBRATION = 0x00000100,
+    MAPLE_BUS_FUNC_MOUSE = 0x00000200
+};
+
+//! Maple Bus addresses on the first port; bits 7-6 select the port, so OR in (port << 6) for other ports
+enum MapleBusAddress
+{
+    //! The Dreamcast itself
+    MAPLE_BUS_ADDR_HOST = 0x00,
+    //! The main peripheral (such as a controller) on the first port
+    MAPLE_BUS_ADDR_MAIN_PERIPHERAL = 0x20,
+    //! The first sub-peripheral (such as a VMU) on the first port
+    MAPLE_BUS_ADDR_SUB_PERIPHERAL_1 = 0x01,
+    //! The second sub-peripheral on the first port
+    MAPLE_BUS_ADDR_SUB_PERIPHERAL_2 = 0x02
+};
+
+//! The unit an address refers to
+enum MapleBusUnit
+{
+    //! The Dreamcast itself
+    MAPLE_BUS_UNIT_HOST = 0,
+    //! The main peripheral
+    MAPLE_BUS_UNIT_MAIN,
+    //! A sub-peripheral; see MapleBusAddressInfo::subPeripheral
+    MAPLE_BUS_UNIT_SUB
+};
+
+//! Interpretation of a Maple Bus address
+struct MapleBusAddressInfo
+{
+    //! Port index; 0 through 3 for ports A through D
+    U8 port;
+    //! The unit addressed
+    MapleBusUnit unit;
+    //! MAPLE_BUS_UNIT_SUB only: the sub-peripheral number, 1 through 5
+    U8 subPeripheral;
+    //! MAPLE_BUS_UNIT_MAIN only: mask of attached sub-peripherals the main peripheral reports (bit 0 for number 1)
+    U8 attachedMask;
+};
+
+//! Interpretation of the frame word and function code of a packet
+struct MapleBusPacketInfo
+{
+    //! Command code (see MapleBusCommand)
+    U8 command;
+    //! Recipient address
+    U8 recipient;
+    //! Sender address
+    U8 sender;
+    //! Number of payload words the frame word announces
+    U8 numWords;
+    //! true iff the whole frame word was received; the fields above are meaningless otherwise
+    bool hasFrameWord;
+    //! true iff the command carries a function code and the packet holds it
+    bool hasFunction;
+    //! The function code (see MapleBusFunction); only valid if hasFunction is true
+    U32 function;
+};
+
+//! Maple Bus protocol level interpretation, independent of Saleae's SDK
+namespace MapleBusProtocol
+{
+    //! Interprets the frame word and function code of a packet
+    //! @param[in] frameWord  the frame word (built little endian)
+    //! @param[in] firstPayloadWord  the first payload word (built little endian), if any
+    //! @param[in] numBytes  the number of bytes received in the packet, including frame word and CRC
+    //! @param[out] info  set to the interpretation
+    void InterpretPacket(U32 frameWord, U32 firstPayloadWord, U32 numBytes, MapleBusPacketInfo& info);
+    //! Interprets an address
+    //! @param[in] address  the address
+    //! @param[out] info  set to the interpretation
+    void InterpretAddress(U8 address, MapleBusAddressInfo& info);
+    //! @returns true iff the given command's first payload word is a function code
+    bool CommandHasFunction(U8 command);
+    //! @returns true iff the response packet answers the command packet
+    bool IsResponseTo(const MapleBusPacketInfo& command, const MapleBusPacketInfo& response);
+
+    //! @returns the name of a command, or NULL if unknown
+    const char* GetCommandName(U8 command);
+    //! Generates the name of a command, or its hex value if unknown
+    void GetCommandString(U8 command, char* str, size_t len);
+    //! Generates the names of every function in a function code, separated by '/'
+    void GetFunctionString(U32 function, char* str, size_t len);
+    //! Generates the name of an address such as "Host A", "A Main" or "A Sub 1"
+    void GetAddressString(U8 address, char* str, size_t len);
+    //! Generates a one line description such as "Get Condition Host A -> A Main: Controller"
+    void GetDescription(const MapleBusPacketInfo& info, char* str, size_t len);
+}
+
+#endif // MAPLEBUS_PROTOCOL_H
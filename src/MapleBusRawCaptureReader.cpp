@@ -0,0 +1,308 @@
+#include "MapleBusRawCaptureReader.h"
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MAPLEBUS_USE_SSE2 1
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//! Number of samples scanned per block
+static const U32 BLOCK_SAMPLES = 64;
+
+//! @returns the index of the lowest set bit of a non-zero value
+static inline U32 FindFirstSet(U64 value)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return index;
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanForward(&index, static_cast<U32>(value)))
+    {
+        return index;
+    }
+    _BitScanForward(&index, static_cast<U32>(value >> 32));
+    return index + 32;
+#else
+    return static_cast<U32>(__builtin_ctzll(value));
+#endif
+}
+
+MapleBusRawCaptureReader::MapleBusRawCaptureReader()
+    : mMapping(NULL),
+      mMappingSize(0),
+      mSamples(NULL),
+      mNumSamples(0),
+      mBytesPerSample(1),
+      mChannelABit(0),
+      mChannelBBit(1),
+      mChannelMask(0x03),
+      mNextBlockSample(1),
+      mBlockSample(0),
+      mBlockChanges(0)
+#ifdef _WIN32
+      ,
+      mFileHandle(NULL),
+      mMappingHandle(NULL)
+#endif
+{
+}
+
+MapleBusRawCaptureReader::~MapleBusRawCaptureReader()
+{
+    Close();
+}
+
+bool MapleBusRawCaptureReader::Open(const char* path, U32 bytesPerSample, U32 channelABit, U32 channelBBit, U64 headerBytes)
+{
+    Close();
+
+    if ((bytesPerSample != 1 && bytesPerSample != 2 && bytesPerSample != 4 && bytesPerSample != 8) ||
+        channelABit >= bytesPerSample * 8 || channelBBit >= bytesPerSample * 8 || channelABit == channelBBit)
+    {
+        return false;
+    }
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == NULL)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    mFileHandle = file;
+    mMappingHandle = mapping;
+    mMapping = static_cast<const U8*>(view);
+    mMappingSize = static_cast<U64>(fileSize.QuadPart);
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0)
+    {
+        close(fd);
+        return false;
+    }
+    void* view = mmap(NULL, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping holds its own reference to the file
+    close(fd);
+    if (view == MAP_FAILED)
+    {
+        return false;
+    }
+    madvise(view, static_cast<size_t>(fileStat.st_size), MADV_SEQUENTIAL);
+    mMapping = static_cast<const U8*>(view);
+    mMappingSize = static_cast<U64>(fileStat.st_size);
+#endif
+
+    if (headerBytes >= mMappingSize)
+    {
+        Close();
+        return false;
+    }
+
+    mSamples = mMapping + headerBytes;
+    mNumSamples = (mMappingSize - headerBytes) / bytesPerSample;
+    mBytesPerSample = bytesPerSample;
+    mChannelABit = channelABit;
+    mChannelBBit = channelBBit;
+    mChannelMask = (1ULL << channelABit) | (1ULL << channelBBit);
+    // Sample 0 sets the initial state, so changes are searched for starting at sample 1
+    mNextBlockSample = 1;
+    mBlockSample = 0;
+    mBlockChanges = 0;
+    return (mNumSamples > 0);
+}
+
+void MapleBusRawCaptureReader::Close()
+{
+    if (mMapping != NULL)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(mMapping);
+        CloseHandle(mMappingHandle);
+        CloseHandle(mFileHandle);
+        mMappingHandle = NULL;
+        mFileHandle = NULL;
+#else
+        munmap(const_cast<U8*>(mMapping), static_cast<size_t>(mMappingSize));
+#endif
+    }
+    mMapping = NULL;
+    mMappingSize = 0;
+    mSamples = NULL;
+    mNumSamples = 0;
+}
+
+U64 MapleBusRawCaptureReader::GetNumSamples() const
+{
+    return mNumSamples;
+}
+
+U64 MapleBusRawCaptureReader::GetSampleWord(U64 sampleNumber) const
+{
+    // Samples are little endian, as is every platform Logic runs on
+    const U8* sample = mSamples + sampleNumber * mBytesPerSample;
+    switch (mBytesPerSample)
+    {
+    case 1:
+        return *sample;
+
+    case 2:
+    {
+        U16 value;
+        memcpy(&value, sample, sizeof(value));
+        return value;
+    }
+
+    case 4:
+    {
+        U32 value;
+        memcpy(&value, sample, sizeof(value));
+        return value;
+    }
+
+    default:
+    {
+        U64 value;
+        memcpy(&value, sample, sizeof(value));
+        return value;
+    }
+    }
+}
+
+U8 MapleBusRawCaptureReader::GetLines(U64 sampleNumber) const
+{
+    U64 word = GetSampleWord(sampleNumber);
+    U8 lines = 0;
+    if ((word >> mChannelABit) & 1)
+    {
+        lines |= MAPLE_BUS_LINE_A;
+    }
+    if ((word >> mChannelBBit) & 1)
+    {
+        lines |= MAPLE_BUS_LINE_B;
+    }
+    return lines;
+}
+
+U64 MapleBusRawCaptureReader::FindChanges(U64 firstSample, U32 numSamples) const
+{
+    U64 changes = 0;
+
+#ifdef MAPLEBUS_USE_SSE2
+    if (numSamples == BLOCK_SAMPLES && mBytesPerSample == 1)
+    {
+        const U8* current = mSamples + firstSample;
+        const __m128i mask = _mm_set1_epi8(static_cast<char>(mChannelMask));
+        const __m128i zero = _mm_setzero_si128();
+        for (U32 i = 0; i < BLOCK_SAMPLES; i += 16)
+        {
+            __m128i now = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current + i));
+            __m128i before = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current + i - 1));
+            __m128i diff = _mm_and_si128(_mm_xor_si128(now, before), mask);
+            U32 same = static_cast<U32>(_mm_movemask_epi8(_mm_cmpeq_epi8(diff, zero)));
+            changes |= static_cast<U64>(~same & 0xFFFF) << i;
+        }
+        return changes;
+    }
+    else if (numSamples == BLOCK_SAMPLES && mBytesPerSample == 2)
+    {
+        const U8* current = mSamples + firstSample * 2;
+        const __m128i mask = _mm_set1_epi16(static_cast<short>(mChannelMask));
+        const __m128i zero = _mm_setzero_si128();
+        for (U32 i = 0; i < BLOCK_SAMPLES; i += 16)
+        {
+            const U8* p = current + i * 2;
+            __m128i diffLo = _mm_and_si128(_mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)),
+                                                         _mm_loadu_si128(reinterpret_cast<const __m128i*>(p - 2))),
+                                           mask);
+            __m128i diffHi = _mm_and_si128(_mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16)),
+                                                         _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 14))),
+                                           mask);
+            // Each equal 16-bit lane becomes 0xFFFF which packs down to a single 0xFF byte
+            __m128i same = _mm_packs_epi16(_mm_cmpeq_epi16(diffLo, zero), _mm_cmpeq_epi16(diffHi, zero));
+            U32 sameMask = static_cast<U32>(_mm_movemask_epi8(same));
+            changes |= static_cast<U64>(~sameMask & 0xFFFF) << i;
+        }
+        return changes;
+    }
+#endif
+
+    U64 previous = GetSampleWord(firstSample - 1) & mChannelMask;
+    for (U32 i = 0; i < numSamples; ++i)
+    {
+        U64 current = GetSampleWord(firstSample + i) & mChannelMask;
+        if (current != previous)
+        {
+            changes |= (1ULL << i);
+        }
+        previous = current;
+    }
+    return changes;
+}
+
+U8 MapleBusRawCaptureReader::GetInitialLines()
+{
+    return (mNumSamples > 0) ? GetLines(0) : static_cast<U8>(MAPLE_BUS_LINES_AB);
+}
+
+bool MapleBusRawCaptureReader::GetNextTransition(MapleBusTransition& transition)
+{
+    while (mBlockChanges == 0)
+    {
+        if (mNextBlockSample >= mNumSamples)
+        {
+            return false;
+        }
+
+        U64 remaining = mNumSamples - mNextBlockSample;
+        U32 numSamples = (remaining < BLOCK_SAMPLES) ? static_cast<U32>(remaining) : BLOCK_SAMPLES;
+        mBlockChanges = FindChanges(mNextBlockSample, numSamples);
+        mBlockSample = mNextBlockSample;
+        mNextBlockSample += numSamples;
+    }
+
+    U64 sampleNumber = mBlockSample + FindFirstSet(mBlockChanges);
+    // Clear the lowest set bit
+    mBlockChanges &= mBlockChanges - 1;
+
+    transition.sample = sampleNumber;
+    transition.lines = GetLines(sampleNumber);
+    return true;
+}
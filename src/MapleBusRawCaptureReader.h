@@ -0,0 +1,78 @@
+#ifndef MAPLEBUS_RAW_CAPTURE_READER_H
+#define MAPLEBUS_RAW_CAPTURE_READER_H
+
+#include "MapleBusTransitionSource.h"
+
+//! Extracts SDCKA and SDCKB transitions out of a memory-mapped raw digital capture.
+//!
+//! The capture holds one little endian word of 1, 2, 4 or 8 bytes per sample where each channel is a single bit of
+//! the word, as written by Logic's binary "each sample" export and most logic analyzer raw dumps. Changes are located
+//! 64 samples at a time by XORing each sample with its predecessor (SSE2 for 1 and 2 byte samples) and walking the
+//! resulting bit mask, so idle stretches of the capture are skipped without inspecting samples one at a time.
+class MapleBusRawCaptureReader : public MapleBusTransitionSource
+{
+  public:
+    //! Constructor
+    MapleBusRawCaptureReader();
+    //! Destructor
+    virtual ~MapleBusRawCaptureReader();
+
+    //! Maps a capture file
+    //! @param[in] path  the file path of the capture
+    //! @param[in] bytesPerSample  byte width of each sample; 1, 2, 4 or 8
+    //! @param[in] channelABit  bit index of SDCKA within each sample
+    //! @param[in] channelBBit  bit index of SDCKB within each sample
+    //! @param[in] headerBytes  number of bytes to skip at the beginning of the file
+    //! @returns false iff the file could not be mapped or the parameters are invalid
+    bool Open(const char* path, U32 bytesPerSample, U32 channelABit, U32 channelBBit, U64 headerBytes = 0);
+    //! Unmaps the capture
+    void Close();
+
+    //! @returns the number of samples in the capture
+    U64 GetNumSamples() const;
+
+    virtual U8 GetInitialLines();
+    virtual bool GetNextTransition(MapleBusTransition& transition);
+
+  private:
+    //! @returns the sample word at the given sample number
+    U64 GetSampleWord(U64 sampleNumber) const;
+    //! @returns the state of both lines at the given sample number (see MapleBusLineMask)
+    U8 GetLines(U64 sampleNumber) const;
+    //! Finds changes of the channel bits over a block of samples
+    //! @param[in] firstSample  the first sample number of the block; must be at least 1
+    //! @param[in] numSamples  the number of samples in the block; at most 64
+    //! @returns a mask with bit i set iff sample (firstSample + i) differs from its predecessor
+    U64 FindChanges(U64 firstSample, U32 numSamples) const;
+
+    //! The mapped file
+    const U8* mMapping;
+    //! Byte size of the mapped file
+    U64 mMappingSize;
+    //! First sample within the mapped file
+    const U8* mSamples;
+    //! Number of samples in the capture
+    U64 mNumSamples;
+    //! Byte width of each sample
+    U32 mBytesPerSample;
+    //! Bit index of SDCKA within each sample
+    U32 mChannelABit;
+    //! Bit index of SDCKB within each sample
+    U32 mChannelBBit;
+    //! Mask of both channel bits within each sample
+    U64 mChannelMask;
+    //! The first sample number of the next block to scan
+    U64 mNextBlockSample;
+    //! The first sample number of the current block
+    U64 mBlockSample;
+    //! Changes left to report within the current block
+    U64 mBlockChanges;
+#ifdef _WIN32
+    //! Handle of the opened file
+    void* mFileHandle;
+    //! Handle of the file mapping
+    void* mMappingHandle;
+#endif
+};
+
+#endif // MAPLEBUS_RAW_CAPTURE_READER_H
@@ -0,0 +1,99 @@
+#ifndef MAPLEBUS_RETAINED_RING_H
+#define MAPLEBUS_RETAINED_RING_H
+
+#include <LogicPublicTypes.h>
+#include <stddef.h>
+#include <vector>
+
+//! Holds the most recent of a growing sequence of items, addressed by their index within the whole sequence so that
+//! indices stay valid as older items are dropped. The number of items retained may be limited so that memory stays flat
+//! over long captures: once twice the limit are retained, the oldest are dropped in one batch down to the limit. That
+//! keeps the cost per item constant and the vector's capacity is kept for the items still to come. Not thread safe;
+//! owners guard it along with the rest of their data.
+template <typename T> class MapleBusRetainedRing
+{
+  public:
+    //! Constructor
+    MapleBusRetainedRing() : mItems(), mMaxItems(0), mFirstIndex(0)
+    {
+    }
+
+    //! Removes all items and releases their memory; the limit is kept
+    void Clear()
+    {
+        std::vector<T>().swap(mItems);
+        mFirstIndex = 0;
+    }
+    //! Limits the number of items retained; takes effect at the next Trim()
+    //! @param[in] maxItems  the least number of most recent items to retain, 0 to retain every item
+    void SetMaxItems(U64 maxItems)
+    {
+        mMaxItems = maxItems;
+    }
+    //! Adds an item after the newest
+    //! @param[in] item  the item to add
+    //! @returns the index of the item
+    U64 Add(const T& item)
+    {
+        mItems.push_back(item);
+        return mFirstIndex + mItems.size() - 1;
+    }
+    //! Drops the oldest items if twice the limit are retained, leaving the limit; the newest item is always kept
+    //! @returns the number of items dropped, so that owners may rebase anything held by position
+    size_t Trim()
+    {
+        if (mMaxItems == 0 || mItems.size() < 2 * mMaxItems)
+        {
+            return 0;
+        }
+        size_t numDropped = static_cast<size_t>(mItems.size() - mMaxItems);
+        mItems.erase(mItems.begin(), mItems.begin() + numDropped);
+        mFirstIndex += numDropped;
+        return numDropped;
+    }
+
+    //! @returns the number of items added since the last Clear(), including any no longer retained
+    U64 GetNumItems() const
+    {
+        return mFirstIndex + mItems.size();
+    }
+    //! @returns the index of the oldest retained item
+    U64 GetFirstIndex() const
+    {
+        return mFirstIndex;
+    }
+    //! @returns the item with the given index, or NULL if out of range or no longer retained
+    const T* Find(U64 index) const
+    {
+        if (index < mFirstIndex || index - mFirstIndex >= mItems.size())
+        {
+            return NULL;
+        }
+        return &mItems[static_cast<size_t>(index - mFirstIndex)];
+    }
+    //! @returns the retained items, oldest first; position 0 holds index GetFirstIndex()
+    const std::vector<T>& GetRetained() const
+    {
+        return mItems;
+    }
+    //! @returns the retained items, oldest first, for updating in place; items must not be added or removed through it
+    std::vector<T>& GetRetained()
+    {
+        return mItems;
+    }
+    //! @returns the approximate number of bytes allocated for the items
+    U64 GetMemoryUsage() const
+    {
+        return mItems.capacity() * sizeof(T);
+    }
+
+  private:
+    //! Retained items, oldest first
+    std::vector<T> mItems;
+    //! The least number of items retained, or 0 to retain every item
+    U64 mMaxItems;
+    //! The index of mItems[0]
+    U64 mFirstIndex;
+};
+
+#endif // MAPLEBUS_RETAINED_RING_H
@@ -1,9 +1,16 @@
 #include "MapleBusSimulationDataGenerator.h"
 #include "MapleBusAnalyzerSettings.h"
+#include "MapleBusGlitchFilter.h"
 
 #include <AnalyzerHelpers.h>
 
+//! Each bit needs 3 edges, each on its own sample
+static const U32 MIN_SAMPLES_PER_BIT = 3;
+//! Number of packets in every 1000 which receive a glitch when a glitch filter is set
+static const U32 SIMULATION_GLITCHES_PER_THOUSAND = 50;
+
 MapleBusSimulationDataGenerator::MapleBusSimulationDataGenerator()
+    : mSettings(NULL), mSimulationSampleRateHz(0), mSerialASimulationData(NULL), mSerialBSimulationData(NULL)
 {
 }
 
@@ -16,18 +23,85 @@ void MapleBusSimulationDataGenerator::Initialize(U32 simulation_sample_rate, Map
     mSimulationSampleRateHz = simulation_sample_rate;
     mSettings = settings;
 
-    mSerialASimulationData.SetChannel(mSettings->mInputChannelA);
-    mSerialASimulationData.SetSampleRate(simulation_sample_rate);
-    mSerialASimulationData.SetInitialBitState(BIT_HIGH);
+    mSerialASimulationData = mSimulationChannels.Add(mSettings->mInputChannelA, simulation_sample_rate, BIT_HIGH);
+    mSerialBSimulationData = mSimulationChannels.Add(mSettings->mInputChannelB, simulation_sample_rate, BIT_HIGH);
+
+    double samplesPerBit = static_cast<double>(simulation_sample_rate) / (mSettings->mSimulationBitRateKbps * 1000.0);
+    if (samplesPerBit < MIN_SAMPLES_PER_BIT)
+    {
+        samplesPerBit = MIN_SAMPLES_PER_BIT;
+    }
+    double gapSamples = static_cast<double>(simulation_sample_rate) * mSettings->mSimulationGapMicroseconds / 1000000.0;
+
+    MapleBusTrafficMix mix;
+    switch (mSettings->mSimulationTraffic)
+    {
+    case MapleBusAnalyzerSettings::SIMULATION_TRAFFIC_CONTROLLER:
+        mix = MAPLE_BUS_TRAFFIC_CONTROLLER;
+        break;
+
+    case MapleBusAnalyzerSettings::SIMULATION_TRAFFIC_STORAGE:
+        mix = MAPLE_BUS_TRAFFIC_STORAGE;
+        break;
 
-    mSerialBSimulationData.SetChannel(mSettings->mInputChannelB);
-    mSerialBSimulationData.SetSampleRate(simulation_sample_rate);
-    mSerialBSimulationData.SetInitialBitState(BIT_HIGH);
+    default:
+    case MapleBusAnalyzerSettings::SIMULATION_TRAFFIC_MIXED:
+        mix = MAPLE_BUS_TRAFFIC_MIXED;
+        break;
+    }
+
+    // Start with an idle bus so the first start sequence is visible
+    mTraffic.reset(new MapleBusTrafficGenerator(mix, samplesPerBit, gapSamples, static_cast<U64>(gapSamples) + 1));
+
+    // With a glitch filter set, some packets receive a pulse of half its width so that the filter has work to do
+    U32 glitchSamplesA = MapleBusGlitchFilter::NanosecondsToSamples(mSettings->mGlitchFilterANs, simulation_sample_rate);
+    U32 glitchSamplesB = MapleBusGlitchFilter::NanosecondsToSamples(mSettings->mGlitchFilterBNs, simulation_sample_rate);
+    if (glitchSamplesB >= 2)
+    {
+        mTraffic->SetGlitches(SIMULATION_GLITCHES_PER_THOUSAND, glitchSamplesB / 2, false);
+    }
+    else if (glitchSamplesA >= 2)
+    {
+        mTraffic->SetGlitches(SIMULATION_GLITCHES_PER_THOUSAND, glitchSamplesA / 2, true);
+    }
 }
 
 U32 MapleBusSimulationDataGenerator::GenerateSimulationData(U64 largest_sample_requested, U32 sample_rate,
                                                             SimulationChannelDescriptor** simulation_channel)
 {
-    // Not supporting this at the moment
-    return 0;
+    U64 adjusted_largest_sample_requested =
+        AnalyzerHelpers::AdjustSimulationTargetSample(largest_sample_requested, sample_rate, mSimulationSampleRateHz);
+
+    while (mSerialASimulationData->GetCurrentSampleNumber() < adjusted_largest_sample_requested)
+    {
+        AddExchange();
+    }
+
+    *simulation_channel = mSimulationChannels.GetArray();
+    return mSimulationChannels.GetCount();
+}
+
+void MapleBusSimulationDataGenerator::AddExchange()
+{
+    mTransitions.clear();
+    mTraffic->AddExchange(mTransitions);
+
+    for (std::vector<MapleBusTransition>::const_iterator iter = mTransitions.begin(); iter != mTransitions.end(); ++iter)
+    {
+        U64 currentSample = mSerialASimulationData->GetCurrentSampleNumber();
+        if (iter->sample > currentSample)
+        {
+            mSimulationChannels.AdvanceAll(static_cast<U32>(iter->sample - currentSample));
+        }
+        mSerialASimulationData->TransitionIfNeeded((iter->lines & MAPLE_BUS_LINE_A) ? BIT_HIGH : BIT_LOW);
+        mSerialBSimulationData->TransitionIfNeeded((iter->lines & MAPLE_BUS_LINE_B) ? BIT_HIGH : BIT_LOW);
+    }
+
+    // Idle until the next exchange begins
+    U64 currentSample = mSerialASimulationData->GetCurrentSampleNumber();
+    U64 nextSample = mTraffic->GetCurrentSample();
+    if (nextSample > currentSample)
+    {
+        mSimulationChannels.AdvanceAll(static_cast<U32>(nextSample - currentSample));
+    }
 }
@@ -1,11 +1,14 @@
 #ifndef MAPLEBUS_SIMULATION_DATA_GENERATOR
 #define MAPLEBUS_SIMULATION_DATA_GENERATOR
 
+#include "MapleBusTrafficGenerator.h"
 #include <SimulationChannelDescriptor.h>
+#include <memory>
 #include <string>
+#include <vector>
 class MapleBusAnalyzerSettings;
 
-// NOT CURRENTLY SUPPORTED
+//! Generates Maple Bus traffic on SDCKA and SDCKB using the packet mix, bit rate and packet gap from the settings
 class MapleBusSimulationDataGenerator
 {
   public:
@@ -15,12 +18,22 @@ class MapleBusSimulationDataGenerator
     void Initialize(U32 simulation_sample_rate, MapleBusAnalyzerSettings* settings);
     U32 GenerateSimulationData(U64 newest_sample_requested, U32 sample_rate, SimulationChannelDescriptor** simulation_channel);
 
+  protected:
+    //! Replays the transitions of the next exchange onto both channels
+    void AddExchange();
+
   protected:
     MapleBusAnalyzerSettings* mSettings;
     U32 mSimulationSampleRateHz;
 
   protected:
-    SimulationChannelDescriptor mSerialASimulationData;
-    SimulationChannelDescriptor mSerialBSimulationData;
+    //! Holds both channels in the array handed back to the host
+    SimulationChannelDescriptorGroup mSimulationChannels;
+    SimulationChannelDescriptor* mSerialASimulationData;
+    SimulationChannelDescriptor* mSerialBSimulationData;
+    //! Produces the packets
+    std::auto_ptr<MapleBusTrafficGenerator> mTraffic;
+    //! Reused transitions of the exchange being replayed
+    std::vector<MapleBusTransition> mTransitions;
 };
-#endif // MAPLEBUS_SIMULATION_DATA_GENERATOR
\ No newline at end of file
+#endif // MAPLEBUS_SIMULATION_DATA_GENERATOR
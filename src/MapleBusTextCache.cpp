@@ -0,0 +1,107 @@
+#include "MapleBusTextCache.h"
+#include <string.h>
+
+//! @returns the smallest power of 2 which is at least the given number
+static size_t RoundUpToPowerOf2(U32 number)
+{
+    size_t power = 1;
+    while (power < number)
+    {
+        power *= 2;
+    }
+    return power;
+}
+
+MapleBusTextCache::MapleBusTextCache(U32 numEntries)
+    : mNumEntries(RoundUpToPowerOf2(numEntries)), mEntries(), mGeneration(0), mNumHits(0), mNumMisses(0)
+{
+}
+
+MapleBusTextCache::~MapleBusTextCache()
+{
+}
+
+void MapleBusTextCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::vector<Entry>().swap(mEntries);
+}
+
+void MapleBusTextCache::SetGeneration(U64 generation)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (generation == mGeneration)
+    {
+        return;
+    }
+    mGeneration = generation;
+    for (std::vector<Entry>::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+    {
+        iter->valid = false;
+    }
+}
+
+bool MapleBusTextCache::Get(U64 index, U32 variant, char* str, U32 len) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mEntries.empty())
+    {
+        const Entry& entry = mEntries[GetSlot(index, variant)];
+        if (entry.valid && entry.index == index && entry.variant == variant)
+        {
+            ++mNumHits;
+            size_t textLen = strlen(entry.text);
+            textLen = (textLen < len) ? textLen : (len - 1);
+            memcpy(str, entry.text, textLen);
+            str[textLen] = '\0';
+            return true;
+        }
+    }
+    ++mNumMisses;
+    return false;
+}
+
+void MapleBusTextCache::Add(U64 index, U32 variant, const char* str)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mEntries.empty())
+    {
+        Entry empty;
+        empty.index = 0;
+        empty.variant = 0;
+        empty.valid = false;
+        empty.text[0] = '\0';
+        mEntries.assign(mNumEntries, empty);
+    }
+
+    Entry& entry = mEntries[GetSlot(index, variant)];
+    entry.index = index;
+    entry.variant = variant;
+    entry.valid = true;
+    strncpy(entry.text, str, MAX_TEXT_LENGTH - 1);
+    entry.text[MAX_TEXT_LENGTH - 1] = '\0';
+}
+
+U64 MapleBusTextCache::GetNumHits() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mNumHits;
+}
+
+U64 MapleBusTextCache::GetNumMisses() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mNumMisses;
+}
+
+U64 MapleBusTextCache::GetMemoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mEntries.capacity() * sizeof(Entry);
+}
+
+size_t MapleBusTextCache::GetSlot(U64 index, U32 variant) const
+{
+    // Variants are spread a fraction of the cache apart so each variant of a screen full of frames fits alongside
+    return static_cast<size_t>(index + static_cast<U64>(variant) * (mNumEntries / 8 + 1)) & (mNumEntries - 1);
+}
@@ -0,0 +1,83 @@
+#ifndef MAPLEBUS_TEXT_CACHE_H
+#define MAPLEBUS_TEXT_CACHE_H
+
+#include <LogicPublicTypes.h>
+#include <mutex>
+#include <vector>
+
+//! Bounded cache of generated text keyed by an item index and a variant, such as a frame index and a display base.
+//!
+//! Entries are direct mapped: each key has exactly one slot, and a new entry simply replaces whatever held that slot.
+//! Consecutive indices map to consecutive slots, so a screen full of neighbouring frames stays cached together while
+//! scrolling. Memory is only allocated once the first entry is added and never grows beyond the given number of
+//! entries. All methods may be called from any thread.
+class MapleBusTextCache
+{
+  public:
+    //! Longest text held, including the terminator; longer text is truncated
+    static const U32 MAX_TEXT_LENGTH = 128;
+
+    //! Constructor
+    //! @param[in] numEntries  the number of entries to hold; rounded up to a power of 2
+    MapleBusTextCache(U32 numEntries = 4096);
+    //! Destructor
+    virtual ~MapleBusTextCache();
+
+    //! Removes all entries and releases their memory
+    void Clear();
+    //! Removes all entries if the generation differs from the last one set, so that text derived from data which may
+    //! since have been dropped is formatted again; memory is kept
+    //! @param[in] generation  any value which changes whenever cached text may no longer hold
+    void SetGeneration(U64 generation);
+    //! Looks up text
+    //! @param[in] index  the item index
+    //! @param[in] variant  the variant of the text
+    //! @param[out] str  set to the text if cached
+    //! @param[in] len  byte length of str
+    //! @returns true iff the text was cached
+    bool Get(U64 index, U32 variant, char* str, U32 len) const;
+    //! Adds text, replacing any entry in its slot
+    //! @param[in] index  the item index
+    //! @param[in] variant  the variant of the text
+    //! @param[in] str  the text
+    void Add(U64 index, U32 variant, const char* str);
+
+    //! @returns the number of lookups which found their text
+    U64 GetNumHits() const;
+    //! @returns the number of lookups which didn't
+    U64 GetNumMisses() const;
+    //! @returns the number of bytes allocated by this cache
+    U64 GetMemoryUsage() const;
+
+  private:
+    //! One cached text
+    struct Entry
+    {
+        //! The item index
+        U64 index;
+        //! The variant of the text
+        U32 variant;
+        //! true iff this entry holds text
+        bool valid;
+        //! The text
+        char text[MAX_TEXT_LENGTH];
+    };
+
+    //! @returns the slot of a key
+    size_t GetSlot(U64 index, U32 variant) const;
+
+    //! Number of entries once allocated
+    const size_t mNumEntries;
+    //! Guards all data
+    mutable std::mutex mMutex;
+    //! Every entry; empty until the first entry is added
+    std::vector<Entry> mEntries;
+    //! The generation the entries were added under
+    U64 mGeneration;
+    //! Number of lookups which found their text
+    mutable U64 mNumHits;
+    //! Number of lookups which didn't
+    mutable U64 mNumMisses;
+};
+
+#endif // MAPLEBUS_TEXT_CACHE_H
@@ -0,0 +1,215 @@
+#include "MapleBusTrafficGenerator.h"
+#include "MapleBusProtocol.h"
+#include <string.h>
+
+//! Number of blocks on a VMU
+static const U16 VMU_NUM_BLOCKS = 256;
+//! Number of words in a VMU block
+static const U32 VMU_BLOCK_WORDS = 128;
+//! Number of write phases needed to write a whole VMU block
+static const U8 VMU_WRITE_PHASES = 4;
+
+//! Controller device info strings; the name is 30 bytes and the license is 60 bytes, padded with spaces
+static const char CONTROLLER_NAME[] = "Dreamcast Controller";
+static const char CONTROLLER_LICENSE[] = "Produced By or Under License From SEGA ENTERPRISES,LTD.";
+
+//! Packs text into payload words in the order it is sent, padded with spaces
+static void AddText(std::vector<U32>& payload, const char* text, U32 numBytes)
+{
+    size_t textLen = strlen(text);
+    for (U32 i = 0; i < numBytes; i += 4)
+    {
+        U32 word = 0;
+        for (U32 j = 0; j < 4; ++j)
+        {
+            U8 c = (i + j < textLen) ? static_cast<U8>(text[i + j]) : ' ';
+            word |= static_cast<U32>(c) << (8 * j);
+        }
+        payload.push_back(word);
+    }
+}
+
+MapleBusTrafficGenerator::MapleBusTrafficGenerator(MapleBusTrafficMix mix, double samplesPerBit, double gapSamples,
+                                                   U64 startSample, U32 seed)
+    : mMix(mix),
+      mGapSamples(gapSamples),
+      mEncoder(samplesPerBit, startSample),
+      mRandomState(seed),
+      mNumPackets(0),
+      mBlock(0),
+      mWritePhase(0),
+      mGlitchesPerThousand(0),
+      mGlitchSamples(0),
+      mGlitchOnLineA(false),
+      mPayload(),
+      mBytes()
+{
+}
+
+MapleBusTrafficGenerator::~MapleBusTrafficGenerator()
+{
+}
+
+void MapleBusTrafficGenerator::SetGlitches(U32 glitchesPerThousand, U32 glitchSamples, bool onLineA)
+{
+    mGlitchesPerThousand = glitchesPerThousand;
+    mGlitchSamples = glitchSamples;
+    mGlitchOnLineA = onLineA;
+}
+
+void MapleBusTrafficGenerator::AddExchange(std::vector<MapleBusTransition>& transitions)
+{
+    switch (mMix)
+    {
+    case MAPLE_BUS_TRAFFIC_CONTROLLER:
+        AddConditionPoll(transitions);
+        break;
+
+    case MAPLE_BUS_TRAFFIC_STORAGE:
+        if ((NextRandom() % 2) == 0)
+        {
+            AddBlockRead(transitions);
+        }
+        else
+        {
+            AddBlockWrite(transitions);
+        }
+        break;
+
+    case MAPLE_BUS_TRAFFIC_MIXED:
+    default:
+    {
+        // Roughly what a game with a VMU attached produces: mostly polls with the occasional save or rescan
+        U32 choice = NextRandom() % 100;
+        if (choice < 85)
+        {
+            AddConditionPoll(transitions);
+        }
+        else if (choice < 90)
+        {
+            AddDeviceInfo(transitions);
+        }
+        else if (choice < 95)
+        {
+            AddBlockRead(transitions);
+        }
+        else
+        {
+            AddBlockWrite(transitions);
+        }
+    }
+    break;
+    }
+}
+
+U64 MapleBusTrafficGenerator::GetCurrentSample() const
+{
+    return mEncoder.GetCurrentSample();
+}
+
+U64 MapleBusTrafficGenerator::GetNumPackets() const
+{
+    return mNumPackets;
+}
+
+void MapleBusTrafficGenerator::AddConditionPoll(std::vector<MapleBusTransition>& transitions)
+{
+    mPayload.clear();
+    mPayload.push_back(MAPLE_BUS_FUNC_CONTROLLER);
+    AddPacket(MAPLE_BUS_CMD_GET_CONDITION, MAPLE_BUS_ADDR_MAIN_PERIPHERAL, MAPLE_BUS_ADDR_HOST, transitions);
+
+    // Buttons are active low; triggers rest at 0 and analog axes rest at 0x80
+    U32 buttons = 0xFFFF & ~(1 << (NextRandom() % 16));
+    U32 triggers = (NextRandom() % 4 == 0) ? (NextRandom() & 0xFF) : 0;
+    U32 axisX = 0x80 + (NextRandom() % 32) - 16;
+    U32 axisY = 0x80 + (NextRandom() % 32) - 16;
+    mPayload.clear();
+    mPayload.push_back(MAPLE_BUS_FUNC_CONTROLLER);
+    mPayload.push_back(buttons | (triggers << 16) | (triggers << 24));
+    mPayload.push_back(axisX | (axisY << 8) | 0x80800000);
+    AddPacket(MAPLE_BUS_CMD_DATA_TRANSFER, MAPLE_BUS_ADDR_HOST, MAPLE_BUS_ADDR_MAIN_PERIPHERAL, transitions);
+}
+
+void MapleBusTrafficGenerator::AddDeviceInfo(std::vector<MapleBusTransition>& transitions)
+{
+    mPayload.clear();
+    AddPacket(MAPLE_BUS_CMD_DEVICE_REQUEST, MAPLE_BUS_ADDR_MAIN_PERIPHERAL, MAPLE_BUS_ADDR_HOST, transitions);
+
+    // Function, 3 function definitions, region and direction then name, license, then standby and max power
+    mPayload.clear();
+    mPayload.push_back(MAPLE_BUS_FUNC_CONTROLLER);
+    mPayload.push_back(0x000F06FE);
+    mPayload.push_back(0);
+    mPayload.push_back(0);
+    mPayload.push_back(0x000000FF | (static_cast<U32>(CONTROLLER_NAME[0]) << 16) |
+                       (static_cast<U32>(CONTROLLER_NAME[1]) << 24));
+    AddText(mPayload, CONTROLLER_NAME + 2, 28);
+    AddText(mPayload, CONTROLLER_LICENSE, 60);
+    mPayload.push_back(0x01F401AE);
+    AddPacket(MAPLE_BUS_CMD_DEVICE_INFO, MAPLE_BUS_ADDR_HOST, MAPLE_BUS_ADDR_MAIN_PERIPHERAL, transitions);
+}
+
+void MapleBusTrafficGenerator::AddBlockRead(std::vector<MapleBusTransition>& transitions)
+{
+    U32 location = mBlock;
+    mBlock = (mBlock + 1) % VMU_NUM_BLOCKS;
+
+    mPayload.clear();
+    mPayload.push_back(MAPLE_BUS_FUNC_STORAGE);
+    mPayload.push_back(location);
+    AddPacket(MAPLE_BUS_CMD_BLOCK_READ, MAPLE_BUS_ADDR_SUB_PERIPHERAL_1, MAPLE_BUS_ADDR_HOST, transitions);
+
+    mPayload.clear();
+    mPayload.push_back(MAPLE_BUS_FUNC_STORAGE);
+    mPayload.push_back(location);
+    for (U32 i = 0; i < VMU_BLOCK_WORDS; ++i)
+    {
+        mPayload.push_back((NextRandom() << 17) ^ NextRandom());
+    }
+    AddPacket(MAPLE_BUS_CMD_DATA_TRANSFER, MAPLE_BUS_ADDR_HOST, MAPLE_BUS_ADDR_SUB_PERIPHERAL_1, transitions);
+}
+
+void MapleBusTrafficGenerator::AddBlockWrite(std::vector<MapleBusTransition>& transitions)
+{
+    // A block is written in phases of a quarter block each
+    U32 location = (static_cast<U32>(mWritePhase) << 16) | mBlock;
+    if (++mWritePhase >= VMU_WRITE_PHASES)
+    {
+        mWritePhase = 0;
+        mBlock = (mBlock + 1) % VMU_NUM_BLOCKS;
+    }
+
+    mPayload.clear();
+    mPayload.push_back(MAPLE_BUS_FUNC_STORAGE);
+    mPayload.push_back(location);
+    for (U32 i = 0; i < VMU_BLOCK_WORDS / VMU_WRITE_PHASES; ++i)
+    {
+        mPayload.push_back((NextRandom() << 17) ^ NextRandom());
+    }
+    AddPacket(MAPLE_BUS_CMD_BLOCK_WRITE, MAPLE_BUS_ADDR_SUB_PERIPHERAL_1, MAPLE_BUS_ADDR_HOST, transitions);
+
+    mPayload.clear();
+    AddPacket(MAPLE_BUS_CMD_ACK, MAPLE_BUS_ADDR_HOST, MAPLE_BUS_ADDR_SUB_PERIPHERAL_1, transitions);
+}
+
+void MapleBusTrafficGenerator::AddPacket(U8 command, U8 recipient, U8 sender, std::vector<MapleBusTransition>& transitions)
+{
+    MapleBusPacketEncoder::BuildPacket(command, recipient, sender, mPayload, mBytes);
+    S32 glitchBit = -1;
+    // Only draws when glitches are enabled, so that traffic without them is unchanged
+    if (mGlitchesPerThousand > 0 && (NextRandom() % 1000) < mGlitchesPerThousand)
+    {
+        // SDCKB carries the data of even bits and SDCKA that of odd bits
+        glitchBit = (static_cast<S32>(mBytes.size()) * 8 / 2) & ~1;
+        glitchBit += mGlitchOnLineA ? 1 : 0;
+    }
+    mEncoder.AddPacket(mBytes, transitions, glitchBit, mGlitchSamples);
+    mEncoder.AddIdle(mGapSamples);
+    ++mNumPackets;
+}
+
+U32 MapleBusTrafficGenerator::NextRandom()
+{
+    mRandomState = mRandomState * 1103515245 + 12345;
+    return (mRandomState >> 16) & 0x7FFF;
+}
@@ -0,0 +1,89 @@
+#ifndef MAPLEBUS_TRAFFIC_GENERATOR_H
+#define MAPLEBUS_TRAFFIC_GENERATOR_H
+
+#include "MapleBusPacketEncoder.h"
+#include <vector>
+
+//! Selects which exchanges MapleBusTrafficGenerator produces
+enum MapleBusTrafficMix
+{
+    //! Controller condition polls only, like a game in progress
+    MAPLE_BUS_TRAFFIC_CONTROLLER = 0,
+    //! Mostly condition polls with the occasional device info request and VMU block read or write
+    MAPLE_BUS_TRAFFIC_MIXED,
+    //! VMU block reads and writes only, like a game save or load
+    MAPLE_BUS_TRAFFIC_STORAGE
+};
+
+//! Produces an endless stream of realistic host commands and device responses as SDCKA and SDCKB transitions,
+//! independent of Saleae's SDK. Output is deterministic for a given seed.
+class MapleBusTrafficGenerator
+{
+  public:
+    //! Constructor
+    //! @param[in] mix  which exchanges to produce
+    //! @param[in] samplesPerBit  the number of samples per bit; at least 3
+    //! @param[in] gapSamples  the number of idle samples after each packet
+    //! @param[in] startSample  the sample number where the first packet begins, with both lines high
+    //! @param[in] seed  random seed
+    MapleBusTrafficGenerator(MapleBusTrafficMix mix, double samplesPerBit, double gapSamples, U64 startSample = 0,
+                             U32 seed = 1);
+    //! Destructor
+    virtual ~MapleBusTrafficGenerator();
+
+    //! Adds a short pulse to some packets so that glitch filtering is exercised; none are added by default
+    //! @param[in] glitchesPerThousand  the number of packets in every 1000 which receive a pulse
+    //! @param[in] glitchSamples  the width of each pulse in samples
+    //! @param[in] onLineA  true to pulse SDCKA, false to pulse SDCKB
+    void SetGlitches(U32 glitchesPerThousand, U32 glitchSamples, bool onLineA);
+
+    //! Appends the next host command, the device response, and the idle gap after each
+    //! @param[out] transitions  the transitions are appended to this
+    void AddExchange(std::vector<MapleBusTransition>& transitions);
+
+    //! @returns the sample number where the next exchange would begin
+    U64 GetCurrentSample() const;
+    //! @returns the number of packets produced so far
+    U64 GetNumPackets() const;
+
+  private:
+    //! Appends a condition poll to the controller and its condition response
+    void AddConditionPoll(std::vector<MapleBusTransition>& transitions);
+    //! Appends a device info request to the controller and its device info response
+    void AddDeviceInfo(std::vector<MapleBusTransition>& transitions);
+    //! Appends a VMU block read and the block data response
+    void AddBlockRead(std::vector<MapleBusTransition>& transitions);
+    //! Appends one phase of a VMU block write and its acknowledgment
+    void AddBlockWrite(std::vector<MapleBusTransition>& transitions);
+    //! Encodes a packet followed by the idle gap
+    void AddPacket(U8 command, U8 recipient, U8 sender, std::vector<MapleBusTransition>& transitions);
+    //! @returns the next pseudo-random value in [0, 0x7FFF]
+    U32 NextRandom();
+
+    //! Which exchanges to produce
+    const MapleBusTrafficMix mMix;
+    //! Idle samples after each packet
+    const double mGapSamples;
+    //! Encodes packets into transitions
+    MapleBusPacketEncoder mEncoder;
+    //! Random state
+    U32 mRandomState;
+    //! Number of packets produced
+    U64 mNumPackets;
+    //! The VMU block which is read or written next
+    U16 mBlock;
+    //! The phase of the next VMU block write
+    U8 mWritePhase;
+    //! Number of packets in every 1000 which receive a glitch
+    U32 mGlitchesPerThousand;
+    //! Width of each glitch in samples
+    U32 mGlitchSamples;
+    //! True to glitch SDCKA, false to glitch SDCKB
+    bool mGlitchOnLineA;
+    //! Reused payload of the packet being built
+    std::vector<U32> mPayload;
+    //! Reused bytes of the packet being built
+    std::vector<U8> mBytes;
+};
+
+#endif // MAPLEBUS_TRAFFIC_GENERATOR_H
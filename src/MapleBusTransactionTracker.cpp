@@ -0,0 +1,188 @@
+#include "MapleBusTransactionTracker.h"
+#include <algorithm>
+
+U64 MapleBusTransactionRecord::GetTurnaroundSamples() const
+{
+    return hasResponse ? (responseStartSample - commandEndSample) : 0;
+}
+
+U64 MapleBusTransactionRecord::GetSpanSamples() const
+{
+    return (hasResponse ? responseEndSample : commandEndSample) - commandStartSample;
+}
+
+U64 MapleBusTransactionRecord::GetBusySamples() const
+{
+    U64 busySamples = commandEndSample - commandStartSample;
+    if (hasResponse)
+    {
+        busySamples += responseEndSample - responseStartSample;
+    }
+    return busySamples;
+}
+
+double MapleBusTransactionRecord::GetUtilization() const
+{
+    U64 spanSamples = GetSpanSamples();
+    return (spanSamples > 0) ? static_cast<double>(GetBusySamples()) / spanSamples : 1.0;
+}
+
+//! Orders transactions by ID for lookup
+static bool TransactionIdLess(const MapleBusTransactionRecord& record, U64 id)
+{
+    return record.id < id;
+}
+
+MapleBusTransactionTracker::MapleBusTransactionTracker(U32 maxPending)
+    : mMaxPending((maxPending > 0) ? maxPending : 1), mTransactions()
+{
+}
+
+MapleBusTransactionTracker::~MapleBusTransactionTracker()
+{
+}
+
+void MapleBusTransactionTracker::Clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mTransactions.Clear();
+    mPending.clear();
+}
+
+void MapleBusTransactionTracker::SetMaxTransactions(U64 maxTransactions)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mTransactions.SetMaxItems(maxTransactions);
+}
+
+U64 MapleBusTransactionTracker::AddPacket(U64 packetIndex, const MapleBusPacketInfo& info, U64 startSample, U64 endSample)
+{
+    MapleBusAddressInfo sender;
+    MapleBusProtocol::InterpretAddress(info.sender, sender);
+    // Without a whole frame word the addresses and command are garbage, so such a packet can neither answer nor displace
+    // a pending command
+    bool isCommand = (info.hasFrameWord && sender.unit == MAPLE_BUS_UNIT_HOST);
+    bool isResponse = (info.hasFrameWord && !isCommand);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (isResponse)
+    {
+        // Oldest matching command first, since a device answers in the order it was asked
+        for (std::vector<PendingCommand>::iterator iter = mPending.begin(); iter != mPending.end(); ++iter)
+        {
+            if (MapleBusProtocol::IsResponseTo(iter->info, info))
+            {
+                MapleBusTransactionRecord& record = mTransactions.GetRetained()[iter->transactionIndex];
+                record.responseIndex = packetIndex;
+                record.responseStartSample = startSample;
+                record.responseEndSample = endSample;
+                record.hasResponse = true;
+                U64 id = record.id;
+                mPending.erase(iter);
+                return id;
+            }
+        }
+    }
+    else if (isCommand)
+    {
+        // A device can't still be working on an earlier command once it is sent another
+        for (std::vector<PendingCommand>::iterator iter = mPending.begin(); iter != mPending.end(); ++iter)
+        {
+            if (iter->info.recipient == info.recipient && iter->info.sender == info.sender)
+            {
+                mPending.erase(iter);
+                break;
+            }
+        }
+        if (mPending.size() >= mMaxPending)
+        {
+            mPending.erase(mPending.begin());
+        }
+    }
+
+    MapleBusTransactionRecord record;
+    record.id = packetIndex;
+    record.responseIndex = 0;
+    record.commandStartSample = startSample;
+    record.commandEndSample = endSample;
+    record.responseStartSample = 0;
+    record.responseEndSample = 0;
+    record.isCommand = isCommand;
+    record.hasResponse = false;
+
+    mTransactions.Add(record);
+    if (isCommand)
+    {
+        PendingCommand pending;
+        pending.info = info;
+        pending.transactionIndex = mTransactions.GetRetained().size() - 1;
+        mPending.push_back(pending);
+    }
+    size_t numDropped = mTransactions.Trim();
+    if (numDropped > 0)
+    {
+        DropPending(numDropped);
+    }
+    return packetIndex;
+}
+
+U64 MapleBusTransactionTracker::GetNumTransactions() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mTransactions.GetNumItems();
+}
+
+U64 MapleBusTransactionTracker::GetFirstTransactionIndex() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mTransactions.GetFirstIndex();
+}
+
+bool MapleBusTransactionTracker::GetTransaction(U64 id, MapleBusTransactionRecord& record) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    const std::vector<MapleBusTransactionRecord>& transactions = mTransactions.GetRetained();
+    std::vector<MapleBusTransactionRecord>::const_iterator iter =
+        std::lower_bound(transactions.begin(), transactions.end(), id, TransactionIdLess);
+    if (iter == transactions.end() || iter->id != id)
+    {
+        return false;
+    }
+    record = *iter;
+    return true;
+}
+
+bool MapleBusTransactionTracker::GetTransactionAt(U64 transactionIndex, MapleBusTransactionRecord& record) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    const MapleBusTransactionRecord* found = mTransactions.Find(transactionIndex);
+    if (found == NULL)
+    {
+        return false;
+    }
+    record = *found;
+    return true;
+}
+
+U64 MapleBusTransactionTracker::GetMemoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mTransactions.GetMemoryUsage() + mPending.capacity() * sizeof(PendingCommand);
+}
+
+void MapleBusTransactionTracker::DropPending(size_t numDropped)
+{
+    // A command whose transaction is dropped can no longer record its response
+    std::vector<PendingCommand>::iterator pendingEnd = mPending.begin();
+    for (std::vector<PendingCommand>::iterator iter = mPending.begin(); iter != mPending.end(); ++iter)
+    {
+        if (iter->transactionIndex >= numDropped)
+        {
+            *pendingEnd = *iter;
+            pendingEnd->transactionIndex -= numDropped;
+            ++pendingEnd;
+        }
+    }
+    mPending.erase(pendingEnd, mPending.end());
+}
@@ -0,0 +1,108 @@
+#ifndef MAPLEBUS_TRANSACTION_TRACKER_H
+#define MAPLEBUS_TRANSACTION_TRACKER_H
+
+#include "MapleBusProtocol.h"
+#include "MapleBusRetainedRing.h"
+#include <mutex>
+#include <vector>
+
+//! One host command along with the device's response, or a lone packet which isn't part of any exchange
+struct MapleBusTransactionRecord
+{
+    //! Transaction ID: the packet index of the first packet
+    U64 id;
+    //! Packet index of the response; only valid if hasResponse is true
+    U64 responseIndex;
+    //! The sample number of the start of the first packet
+    U64 commandStartSample;
+    //! The sample number of the end of the first packet
+    U64 commandEndSample;
+    //! The sample number of the start of the response; only valid if hasResponse is true
+    U64 responseStartSample;
+    //! The sample number of the end of the response; only valid if hasResponse is true
+    U64 responseEndSample;
+    //! true iff the first packet was sent by the host, so a response is expected
+    bool isCommand;
+    //! true iff the response was received
+    bool hasResponse;
+
+    //! @returns the number of samples from the end of the command to the start of the response, or 0 if no response
+    U64 GetTurnaroundSamples() const;
+    //! @returns the number of samples from the start of the first packet to the end of the last packet
+    U64 GetSpanSamples() const;
+    //! @returns the number of samples either packet was being transmitted
+    U64 GetBusySamples() const;
+    //! @returns the fraction of the transaction's span the bus was busy, 0 through 1
+    double GetUtilization() const;
+};
+
+//! Pairs each host command with the device's response as packets are decoded, in the same pass. Responses are matched
+//! to the oldest pending command whose addressing matches; pending commands are held in a small table so that a
+//! missing response can't grow memory. The number of transactions retained may be limited like MapleBusPacketStore's
+//! packets. All methods may be called from any thread.
+class MapleBusTransactionTracker
+{
+  public:
+    //! Constructor
+    //! @param[in] maxPending  the most commands waiting for a response at once; the oldest is dropped beyond this
+    MapleBusTransactionTracker(U32 maxPending = 8);
+    //! Destructor
+    virtual ~MapleBusTransactionTracker();
+
+    //! Removes all transactions
+    void Clear();
+    //! Limits the number of transactions retained, the same way as MapleBusPacketStore::SetMaxPackets()
+    //! @param[in] maxTransactions  the least number of most recent transactions to retain, 0 to retain every transaction
+    void SetMaxTransactions(U64 maxTransactions);
+    //! Adds the next decoded packet
+    //! @param[in] packetIndex  the index of the packet; must increase with each call
+    //! @param[in] info  the protocol level interpretation of the packet
+    //! @param[in] startSample  the sample number of the start of the packet
+    //! @param[in] endSample  the sample number of the end of the packet
+    //! @returns the ID of the transaction the packet belongs to; a packet cut short before its whole frame word is always
+    //!          a lone packet, neither a command nor a response, and leaves pending commands untouched
+    U64 AddPacket(U64 packetIndex, const MapleBusPacketInfo& info, U64 startSample, U64 endSample);
+
+    //! @returns the number of transactions since the last Clear(), including any no longer retained
+    U64 GetNumTransactions() const;
+    //! @returns the position of the oldest retained transaction
+    U64 GetFirstTransactionIndex() const;
+    //! Retrieves a transaction by ID
+    //! @param[in] id  the transaction ID
+    //! @param[out] record  set to the transaction
+    //! @returns false iff no retained transaction has this ID
+    bool GetTransaction(U64 id, MapleBusTransactionRecord& record) const;
+    //! Retrieves a transaction by its position
+    //! @param[in] transactionIndex  the position of the transaction, in order of ID
+    //! @param[out] record  set to the transaction
+    //! @returns false iff transactionIndex is out of range or no longer retained
+    bool GetTransactionAt(U64 transactionIndex, MapleBusTransactionRecord& record) const;
+
+    //! @returns the approximate number of bytes allocated by this tracker
+    U64 GetMemoryUsage() const;
+
+  private:
+    //! A command waiting for its response
+    struct PendingCommand
+    {
+        //! The command's interpretation
+        MapleBusPacketInfo info;
+        //! Position of the command's transaction among those retained
+        size_t transactionIndex;
+    };
+
+    //! Drops any commands still waiting on transactions no longer retained and rebases the rest; the mutex must be locked
+    //! @param[in] numDropped  the number of transactions just dropped
+    void DropPending(size_t numDropped);
+
+    //! The most commands waiting at once
+    const U32 mMaxPending;
+    //! Guards all data; the analyzer adds packets while the UI renders them
+    mutable std::mutex mMutex;
+    //! Retained transactions in order of ID
+    MapleBusRetainedRing<MapleBusTransactionRecord> mTransactions;
+    //! Commands waiting for a response, oldest first
+    std::vector<PendingCommand> mPending;
+};
+
+#endif // MAPLEBUS_TRANSACTION_TRACKER_H
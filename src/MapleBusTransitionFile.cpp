@@ -0,0 +1,310 @@
+#include "MapleBusTransitionFile.h"
+#include <string.h>
+
+const char MapleBusTransitionFile::MAGIC[4] = { 'M', 'B', 'T', 'L' };
+
+//! Writes a little endian value into a buffer
+static void PutLittleEndian(U8* dest, U64 value, U32 numBytes)
+{
+    for (U32 i = 0; i < numBytes; ++i, value = value >> 8)
+    {
+        dest[i] = static_cast<U8>(value & 0xFF);
+    }
+}
+
+//! Reads a little endian value out of a buffer
+static U64 GetLittleEndian(const U8* src, U32 numBytes)
+{
+    U64 value = 0;
+    for (U32 i = numBytes; i > 0; --i)
+    {
+        value = (value << 8) | src[i - 1];
+    }
+    return value;
+}
+
+MapleBusTransitionWriter::MapleBusTransitionWriter()
+    : mFile(NULL), mBuffer(), mLastSample(0), mLastLines(0), mNumTransitions(0), mWriteOk(false)
+{
+    mBuffer.reserve(MapleBusTransitionFile::BUFFER_SIZE);
+}
+
+MapleBusTransitionWriter::~MapleBusTransitionWriter()
+{
+    if (mFile != NULL)
+    {
+        Flush();
+        fclose(mFile);
+    }
+}
+
+bool MapleBusTransitionWriter::Open(const char* path, U32 sampleRateHz, U64 startSample, U8 initialLines)
+{
+    mFile = fopen(path, "wb");
+    if (mFile == NULL)
+    {
+        return false;
+    }
+
+    U8 header[MapleBusTransitionFile::HEADER_SIZE] = {};
+    memcpy(header, MapleBusTransitionFile::MAGIC, sizeof(MapleBusTransitionFile::MAGIC));
+    header[4] = MapleBusTransitionFile::VERSION;
+    header[5] = initialLines & MAPLE_BUS_LINES_AB;
+    PutLittleEndian(&header[8], sampleRateHz, 4);
+    PutLittleEndian(&header[16], startSample, 8);
+
+    mBuffer.clear();
+    mLastSample = startSample;
+    mLastLines = header[5];
+    mNumTransitions = 0;
+    mWriteOk = (fwrite(header, 1, sizeof(header), mFile) == sizeof(header));
+    return mWriteOk;
+}
+
+void MapleBusTransitionWriter::WriteVarint(U64 value)
+{
+    do
+    {
+        U8 b = static_cast<U8>(value & 0x7F);
+        value = value >> 7;
+        if (value != 0)
+        {
+            b |= 0x80;
+        }
+        mBuffer.push_back(b);
+    } while (value != 0);
+
+    if (mBuffer.size() >= MapleBusTransitionFile::BUFFER_SIZE - 16)
+    {
+        Flush();
+    }
+}
+
+void MapleBusTransitionWriter::Flush()
+{
+    if (!mBuffer.empty())
+    {
+        if (fwrite(&mBuffer[0], 1, mBuffer.size(), mFile) != mBuffer.size())
+        {
+            mWriteOk = false;
+        }
+        mBuffer.clear();
+    }
+}
+
+void MapleBusTransitionWriter::AddTransition(U64 sample, U8 lines)
+{
+    U8 changed = (lines ^ mLastLines) & MAPLE_BUS_LINES_AB;
+    if (mFile != NULL && changed != 0 && sample >= mLastSample)
+    {
+        WriteVarint(((sample - mLastSample) << 2) | changed);
+        mLastSample = sample;
+        mLastLines = lines;
+        ++mNumTransitions;
+    }
+}
+
+bool MapleBusTransitionWriter::Close(U64 endSample)
+{
+    if (mFile == NULL)
+    {
+        return false;
+    }
+
+    WriteVarint(0);
+    WriteVarint((endSample > mLastSample) ? (endSample - mLastSample) : 0);
+    Flush();
+    if (fclose(mFile) != 0)
+    {
+        mWriteOk = false;
+    }
+    mFile = NULL;
+    return mWriteOk;
+}
+
+U64 MapleBusTransitionWriter::GetNumTransitions() const
+{
+    return mNumTransitions;
+}
+
+MapleBusTransitionReader::MapleBusTransitionReader()
+    : mFile(NULL),
+      mOwnsFile(false),
+      mBuffer(MapleBusTransitionFile::BUFFER_SIZE),
+      mBufferPos(0),
+      mBufferLen(0),
+      mSampleRateHz(0),
+      mStartSample(0),
+      mEndSample(0),
+      mInitialLines(MAPLE_BUS_LINES_AB),
+      mLastSample(0),
+      mLastLines(MAPLE_BUS_LINES_AB),
+      mEndReached(false),
+      mTruncated(false)
+{
+}
+
+MapleBusTransitionReader::~MapleBusTransitionReader()
+{
+    Close();
+}
+
+bool MapleBusTransitionReader::Open(const char* path)
+{
+    Close();
+
+    if (strcmp(path, "-") == 0)
+    {
+        mFile = stdin;
+        mOwnsFile = false;
+    }
+    else
+    {
+        mFile = fopen(path, "rb");
+        mOwnsFile = true;
+    }
+
+    if (mFile == NULL)
+    {
+        return false;
+    }
+
+    U8 header[MapleBusTransitionFile::HEADER_SIZE];
+    for (U32 i = 0; i < sizeof(header); ++i)
+    {
+        if (!ReadByte(header[i]))
+        {
+            Close();
+            return false;
+        }
+    }
+
+    if (memcmp(header, MapleBusTransitionFile::MAGIC, sizeof(MapleBusTransitionFile::MAGIC)) != 0 ||
+        header[4] != MapleBusTransitionFile::VERSION)
+    {
+        Close();
+        return false;
+    }
+
+    mInitialLines = header[5] & MAPLE_BUS_LINES_AB;
+    mSampleRateHz = static_cast<U32>(GetLittleEndian(&header[8], 4));
+    mStartSample = GetLittleEndian(&header[16], 8);
+    mEndSample = mStartSample;
+    mLastSample = mStartSample;
+    mLastLines = mInitialLines;
+    mEndReached = false;
+    mTruncated = false;
+    return true;
+}
+
+void MapleBusTransitionReader::Close()
+{
+    if (mFile != NULL && mOwnsFile)
+    {
+        fclose(mFile);
+    }
+    mFile = NULL;
+    mOwnsFile = false;
+    mBufferPos = 0;
+    mBufferLen = 0;
+}
+
+U32 MapleBusTransitionReader::GetSampleRate() const
+{
+    return mSampleRateHz;
+}
+
+U64 MapleBusTransitionReader::GetStartSample() const
+{
+    return mStartSample;
+}
+
+U64 MapleBusTransitionReader::GetEndSample() const
+{
+    return mEndSample;
+}
+
+bool MapleBusTransitionReader::IsTruncated() const
+{
+    return mTruncated;
+}
+
+U8 MapleBusTransitionReader::GetInitialLines()
+{
+    return mInitialLines;
+}
+
+bool MapleBusTransitionReader::ReadByte(U8& value)
+{
+    if (mBufferPos >= mBufferLen)
+    {
+        if (mFile == NULL)
+        {
+            return false;
+        }
+        mBufferLen = fread(&mBuffer[0], 1, mBuffer.size(), mFile);
+        mBufferPos = 0;
+        if (mBufferLen == 0)
+        {
+            return false;
+        }
+    }
+    value = mBuffer[mBufferPos++];
+    return true;
+}
+
+bool MapleBusTransitionReader::ReadVarint(U64& value)
+{
+    value = 0;
+    for (U32 shift = 0; shift < 64; shift += 7)
+    {
+        U8 b;
+        if (!ReadByte(b))
+        {
+            return false;
+        }
+        value |= static_cast<U64>(b & 0x7F) << shift;
+        if ((b & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    // Too many continuation bytes
+    return false;
+}
+
+bool MapleBusTransitionReader::GetNextTransition(MapleBusTransition& transition)
+{
+    if (mEndReached)
+    {
+        return false;
+    }
+
+    U64 value;
+    if (!ReadVarint(value))
+    {
+        mEndReached = true;
+        mTruncated = true;
+        mEndSample = mLastSample;
+        return false;
+    }
+
+    if (value == 0)
+    {
+        // End marker
+        U64 endDelta = 0;
+        if (!ReadVarint(endDelta))
+        {
+            mTruncated = true;
+        }
+        mEndSample = mLastSample + endDelta;
+        mEndReached = true;
+        return false;
+    }
+
+    mLastSample += (value >> 2);
+    mLastLines ^= static_cast<U8>(value & MAPLE_BUS_LINES_AB);
+    transition.sample = mLastSample;
+    transition.lines = mLastLines;
+    return true;
+}
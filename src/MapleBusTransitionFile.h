@@ -0,0 +1,146 @@
+#ifndef MAPLEBUS_TRANSITION_FILE_H
+#define MAPLEBUS_TRANSITION_FILE_H
+
+#include "MapleBusTransitionSource.h"
+#include <stdio.h>
+#include <vector>
+
+//! Compact on-disk format which stores only the transitions of SDCKA and SDCKB.
+//!
+//! All multi-byte header fields are little endian.
+//!   0  char[4]  magic "MBTL"
+//!   4  U8       format version (1)
+//!   5  U8       initial state of both lines (see MapleBusLineMask)
+//!   6  U16      reserved (0)
+//!   8  U32      sample rate in Hz (0 if unknown)
+//!  12  U32      reserved (0)
+//!  16  U64      start sample; the first delta is relative to this
+//!
+//! The header is followed by one unsigned LEB128 varint per transition holding
+//! ((sample - previous sample) << 2) | changed line mask. Since the changed line mask of a transition is never 0,
+//! a varint of 0 terminates the list and is followed by a varint holding (end sample - previous sample).
+namespace MapleBusTransitionFile
+{
+    //! File magic
+    extern const char MAGIC[4];
+    //! Current format version
+    const U8 VERSION = 1;
+    //! Byte size of the file header
+    const U32 HEADER_SIZE = 24;
+    //! Byte size of the read and write buffers
+    const U32 BUFFER_SIZE = 64 * 1024;
+}
+
+//! Writes a transition list file
+class MapleBusTransitionWriter
+{
+  public:
+    //! Constructor
+    MapleBusTransitionWriter();
+    //! Destructor; closes the file without writing an end marker if still open
+    virtual ~MapleBusTransitionWriter();
+
+    //! Creates the file and writes its header
+    //! @param[in] path  the file path to write
+    //! @param[in] sampleRateHz  the sample rate of the capture, 0 if unknown
+    //! @param[in] startSample  the first sample number of the capture
+    //! @param[in] initialLines  the state of both lines at startSample (see MapleBusLineMask)
+    //! @returns false iff the file could not be written
+    bool Open(const char* path, U32 sampleRateHz, U64 startSample, U8 initialLines);
+    //! Writes the next transition; ignored if no line changes state
+    //! @param[in] sample  the sample number where the change occurred; must not precede the last transition
+    //! @param[in] lines  the state of both lines starting at sample (see MapleBusLineMask)
+    void AddTransition(U64 sample, U8 lines);
+    //! Writes the end marker and closes the file
+    //! @param[in] endSample  the last sample number of the capture
+    //! @returns false iff any write failed
+    bool Close(U64 endSample);
+
+    //! @returns the number of transitions written so far
+    U64 GetNumTransitions() const;
+
+  private:
+    //! Appends a varint to the write buffer
+    void WriteVarint(U64 value);
+    //! Writes out the buffer
+    void Flush();
+
+    //! The file being written
+    FILE* mFile;
+    //! Pending bytes to write
+    std::vector<U8> mBuffer;
+    //! Sample number of the last transition
+    U64 mLastSample;
+    //! Line state of the last transition
+    U8 mLastLines;
+    //! Number of transitions written
+    U64 mNumTransitions;
+    //! false once any write fails
+    bool mWriteOk;
+};
+
+//! Streams transitions out of a transition list file
+class MapleBusTransitionReader : public MapleBusTransitionSource
+{
+  public:
+    //! Constructor
+    MapleBusTransitionReader();
+    //! Destructor
+    virtual ~MapleBusTransitionReader();
+
+    //! Opens a file and reads its header
+    //! @param[in] path  the file path to read or "-" for standard input
+    //! @returns false iff the file could not be opened or is not a transition list
+    bool Open(const char* path);
+    //! Closes the file
+    void Close();
+
+    //! @returns the sample rate in Hz stored in the header, 0 if unknown
+    U32 GetSampleRate() const;
+    //! @returns the start sample stored in the header
+    U64 GetStartSample() const;
+    //! @returns the end sample of the capture; only valid once all transitions have been read
+    U64 GetEndSample() const;
+    //! @returns true iff the file ended before its end marker or held an invalid value
+    bool IsTruncated() const;
+
+    virtual U8 GetInitialLines();
+    virtual bool GetNextTransition(MapleBusTransition& transition);
+
+  private:
+    //! Reads the next byte from the file
+    //! @returns false iff end of file was reached
+    bool ReadByte(U8& value);
+    //! Reads the next varint from the file
+    //! @returns false iff end of file was reached or the varint is invalid
+    bool ReadVarint(U64& value);
+
+    //! The file being read
+    FILE* mFile;
+    //! true iff mFile must be closed by this object
+    bool mOwnsFile;
+    //! Read buffer
+    std::vector<U8> mBuffer;
+    //! Read position within mBuffer
+    size_t mBufferPos;
+    //! Number of valid bytes in mBuffer
+    size_t mBufferLen;
+    //! Sample rate from the header
+    U32 mSampleRateHz;
+    //! Start sample from the header
+    U64 mStartSample;
+    //! End sample from the end marker
+    U64 mEndSample;
+    //! Initial line state from the header
+    U8 mInitialLines;
+    //! Sample number of the last transition
+    U64 mLastSample;
+    //! Line state of the last transition
+    U8 mLastLines;
+    //! true once the end marker is read
+    bool mEndReached;
+    //! true iff the file ended early or held invalid data
+    bool mTruncated;
+};
+
+#endif // MAPLEBUS_TRANSITION_FILE_H
@@ -0,0 +1,59 @@
+#include "MapleBusTransitionSource.h"
+
+bool MapleBusTransitionSource::GetNextTransitionOfA(U8& lines, MapleBusTransition& transition)
+{
+    while (GetNextTransition(transition))
+    {
+        if (((transition.lines ^ lines) & MAPLE_BUS_LINE_A) != 0)
+        {
+            return true;
+        }
+        lines = transition.lines;
+    }
+    return false;
+}
+
+bool MapleBusTransitionSource::HasTransitionBefore(U64 sample)
+{
+    return true;
+}
+
+MapleBusTransitionArraySource::MapleBusTransitionArraySource(U8 initialLines, const MapleBusTransition* transitions,
+                                                             size_t numTransitions)
+    : mInitialLines(initialLines), mNext(transitions), mEnd(transitions + numTransitions)
+{
+}
+
+MapleBusTransitionArraySource::~MapleBusTransitionArraySource()
+{
+}
+
+U8 MapleBusTransitionArraySource::GetInitialLines()
+{
+    return mInitialLines;
+}
+
+bool MapleBusTransitionArraySource::GetNextTransition(MapleBusTransition& transition)
+{
+    if (mNext >= mEnd)
+    {
+        return false;
+    }
+
+    transition = *mNext++;
+    return true;
+}
+
+bool MapleBusTransitionArraySource::GetNextTransitionOfA(U8& lines, MapleBusTransition& transition)
+{
+    for (; mNext < mEnd; ++mNext)
+    {
+        if (((mNext->lines ^ lines) & MAPLE_BUS_LINE_A) != 0)
+        {
+            transition = *mNext++;
+            return true;
+        }
+        lines = mNext->lines;
+    }
+    return false;
+}
@@ -0,0 +1,81 @@
+#ifndef MAPLEBUS_TRANSITION_SOURCE_H
+#define MAPLEBUS_TRANSITION_SOURCE_H
+
+#include <LogicPublicTypes.h>
+#include <stddef.h>
+
+//! Bit masks of each line within MapleBusTransition::lines
+enum MapleBusLineMask
+{
+    //! SDCKA state bit
+    MAPLE_BUS_LINE_A = 0x01,
+    //! SDCKB state bit
+    MAPLE_BUS_LINE_B = 0x02,
+    //! Both lines; this is also the neutral (idle) state of the bus
+    MAPLE_BUS_LINES_AB = MAPLE_BUS_LINE_A | MAPLE_BUS_LINE_B
+};
+
+//! A change in state of one or both Maple Bus lines
+struct MapleBusTransition
+{
+    //! The sample number where the change occurred
+    U64 sample;
+    //! The state of both lines starting at sample (see MapleBusLineMask)
+    U8 lines;
+};
+
+//! Abstract, time ordered stream of transitions over both Maple Bus lines
+class MapleBusTransitionSource
+{
+  public:
+    //! Destructor
+    virtual ~MapleBusTransitionSource()
+    {
+    }
+
+    //! @returns the state of both lines before the first transition (see MapleBusLineMask)
+    virtual U8 GetInitialLines() = 0;
+    //! Retrieves the next transition
+    //! @param[out] transition  set to the next transition
+    //! @returns false iff no more transitions exist
+    virtual bool GetNextTransition(MapleBusTransition& transition) = 0;
+    //! Skips every transition which only changes SDCKB, up to the next transition which changes SDCKA. Sources which
+    //! can find SDCKA's next edge without visiting SDCKB's edges one by one should override this.
+    //! @param[in,out] lines  the state of both lines before the next transition; set to the state just before the
+    //!                       returned transition
+    //! @param[out] transition  set to the next transition which changes SDCKA
+    //! @returns false iff no more transitions exist
+    virtual bool GetNextTransitionOfA(U8& lines, MapleBusTransition& transition);
+    //! Checks for a transition before the given sample without retrieving it, so that callers looking ahead don't
+    //! block for data beyond it. Sources whose GetNextTransition() never blocks may always return true, as this does.
+    //! @param[in] sample  the sample number to check up to, exclusive; must follow the previous transition
+    //! @returns false only if no transition occurs before sample
+    virtual bool HasTransitionBefore(U64 sample);
+};
+
+//! Transition source over an in-memory array of transitions
+class MapleBusTransitionArraySource : public MapleBusTransitionSource
+{
+  public:
+    //! Constructor
+    //! @param[in] initialLines  the state of both lines before the first transition
+    //! @param[in] transitions  the first transition; must outlive this object
+    //! @param[in] numTransitions  the number of transitions in the array
+    MapleBusTransitionArraySource(U8 initialLines, const MapleBusTransition* transitions, size_t numTransitions);
+    //! Destructor
+    virtual ~MapleBusTransitionArraySource();
+
+    virtual U8 GetInitialLines();
+    virtual bool GetNextTransition(MapleBusTransition& transition);
+    virtual bool GetNextTransitionOfA(U8& lines, MapleBusTransition& transition);
+
+  private:
+    //! The state of both lines before the first transition
+    U8 mInitialLines;
+    //! The next transition to return
+    const MapleBusTransition* mNext;
+    //! One past the last transition
+    const MapleBusTransition* mEnd;
+};
+
+#endif // MAPLEBUS_TRANSITION_SOURCE_H
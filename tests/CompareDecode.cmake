@@ -0,0 +1,22 @@
+# Runs the offline decoder on a capture and compares what it prints with the expected output
+#
+# DECODE    path of MapleBusDecode
+# ARGS      options given before the capture, separated by spaces
+# CAPTURE   the capture to decode
+# EXPECTED  the expected output
+# OUTPUT    where to write the actual output
+
+separate_arguments(ARGS)
+execute_process(COMMAND ${DECODE} ${ARGS} ${CAPTURE} OUTPUT_FILE ${OUTPUT} RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "MapleBusDecode ${ARGS} ${CAPTURE} failed: ${result}")
+endif()
+
+# Line endings depend on the platform the output was written on
+file(READ ${OUTPUT} actual)
+file(READ ${EXPECTED} expected)
+string(REPLACE "\r\n" "\n" actual "${actual}")
+string(REPLACE "\r\n" "\n" expected "${expected}")
+if(NOT actual STREQUAL expected)
+    message(FATAL_ERROR "${OUTPUT} differs from ${EXPECTED}")
+endif()
@@ -0,0 +1,633 @@
+// Maple Bus decoder tests
+//
+// Checks the decoder core without the Logic application. Captures are built with MapleBusPacketEncoder and
+// MapleBusTrafficGenerator, which are deterministic, so every run decodes the same transitions. Each test is run by
+// name, such as "MapleBusTests decoder", and ctest runs each one separately; with no name, every test runs.
+//
+// The offline decoder's output for the captures under tests/data is checked against the expected output stored with
+// them by tests/CompareDecode.cmake, serially and in parallel.
+
+#include "MapleBusDecoder.h"
+#include "MapleBusErrorLog.h"
+#include "MapleBusFrameLayout.h"
+#include "MapleBusGlitchFilter.h"
+#include "MapleBusPacketEncoder.h"
+#include "MapleBusPacketFile.h"
+#include "MapleBusPacketStore.h"
+#include "MapleBusParallelDecoder.h"
+#include "MapleBusProtocol.h"
+#include "MapleBusRetainedRing.h"
+#include "MapleBusTrafficGenerator.h"
+#include "MapleBusTransactionTracker.h"
+#include "MapleBusTransitionSource.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+//! Number of failed checks so far
+static U32 gNumFailures = 0;
+
+//! Prints and counts a failed check
+#define CHECK(condition)                                                                                               \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);                              \
+            ++gNumFailures;                                                                                            \
+        }                                                                                                              \
+    } while (0)
+
+//! Samples per bit of every capture, the same as MapleBusBench
+static const double SAMPLES_PER_BIT = 12;
+//! Idle samples after each packet
+static const double GAP_SAMPLES = 80;
+
+//! Keeps everything the decoder reports: each complete packet along with the bytes and words reported while it was
+//! received, each error, and a line of text per event so that two decodes may be compared
+class RecordingListener : public MapleBusDecoderListener
+{
+  public:
+    RecordingListener() : mPackets(), mPacketBytes(), mPacketWords(), mErrors(), mEvents(), mBytes(), mWords()
+    {
+    }
+
+    virtual void OnPacketStart(U64 startSample, U64 endSample)
+    {
+        mBytes.clear();
+        mWords.clear();
+        char event[64];
+        snprintf(event, sizeof(event), "start %llu %llu", startSample, endSample);
+        mEvents.push_back(event);
+    }
+
+    virtual void OnByte(const MapleBusDecodedByte& decodedByte)
+    {
+        mBytes.push_back(decodedByte);
+    }
+
+    virtual void OnWord(const MapleBusDecodedWord& decodedWord)
+    {
+        mWords.push_back(decodedWord);
+    }
+
+    virtual void OnPacketEnd(const MapleBusPacket& packet)
+    {
+        mPackets.push_back(packet);
+        mPacketBytes.push_back(mBytes);
+        mPacketWords.push_back(mWords);
+
+        char event[64];
+        snprintf(event, sizeof(event), "packet %llu %llu", packet.startSample, packet.endSample);
+        std::string line = event;
+        for (size_t i = 0; i < packet.bytes.size(); ++i)
+        {
+            snprintf(event, sizeof(event), " %02X", packet.bytes[i]);
+            line += event;
+        }
+        line += packet.crcValid ? "" : " bad CRC";
+        mEvents.push_back(line);
+    }
+
+    virtual void OnError(const MapleBusDecodeError& error)
+    {
+        mErrors.push_back(error);
+        char event[128];
+        snprintf(event, sizeof(event), "error %d %llu %llu %u %u %u %u", static_cast<int>(error.type), error.sample,
+                 error.startSample, error.byteIndex, error.bitIndex, error.expectedEdges, error.observedEdges);
+        mEvents.push_back(event);
+    }
+
+    virtual void OnResync(U64 errorSample, U64 resumeSample)
+    {
+        char event[64];
+        snprintf(event, sizeof(event), "resync %llu %llu", errorSample, resumeSample);
+        mEvents.push_back(event);
+    }
+
+    //! Every complete packet
+    std::vector<MapleBusPacket> mPackets;
+    //! The bytes reported while receiving each complete packet
+    std::vector<std::vector<MapleBusDecodedByte> > mPacketBytes;
+    //! The words reported while receiving each complete packet
+    std::vector<std::vector<MapleBusDecodedWord> > mPacketWords;
+    //! Every error
+    std::vector<MapleBusDecodeError> mErrors;
+    //! A line of text per packet start, packet, error and resync
+    std::vector<std::string> mEvents;
+
+  private:
+    //! Bytes of the packet being received
+    std::vector<MapleBusDecodedByte> mBytes;
+    //! Words of the packet being received
+    std::vector<MapleBusDecodedWord> mWords;
+};
+
+//! Decodes transitions serially
+//! @param[in] transitions  the transitions to decode, beginning with both lines high
+//! @param[out] listener  receives everything decoded
+static void Decode(const std::vector<MapleBusTransition>& transitions, RecordingListener& listener)
+{
+    MapleBusDecoder decoder(&listener);
+    MapleBusTransitionArraySource source(MAPLE_BUS_LINES_AB, &transitions[0], transitions.size());
+    decoder.Run(&source);
+}
+
+//! Builds mixed traffic with the occasional glitch on each line
+//! @param[in] numPackets  the least number of packets to build
+//! @param[out] transitions  set to the transitions, beginning with both lines high
+static void BuildMixedTraffic(U64 numPackets, std::vector<MapleBusTransition>& transitions)
+{
+    transitions.clear();
+    MapleBusTrafficGenerator traffic(MAPLE_BUS_TRAFFIC_MIXED, SAMPLES_PER_BIT, GAP_SAMPLES);
+    while (traffic.GetNumPackets() < numPackets)
+    {
+        // Alternate lines so that glitches land on both
+        traffic.SetGlitches(20, 1, (traffic.GetNumPackets() / 100) % 2 == 0);
+        traffic.AddExchange(transitions);
+    }
+}
+
+//! The CRC is the XOR of every byte before it and the decoder checks it
+static void TestCrc()
+{
+    std::vector<U32> payload(1, MAPLE_BUS_FUNC_CONTROLLER);
+    std::vector<U8> bytes;
+    MapleBusPacketEncoder::BuildPacket(MAPLE_BUS_CMD_GET_CONDITION, MAPLE_BUS_ADDR_MAIN_PERIPHERAL, MAPLE_BUS_ADDR_HOST,
+                                       payload, bytes);
+    const U8 expected[] = {0x01, 0x00, 0x20, 0x09, 0x01, 0x00, 0x00, 0x00, 0x29};
+    CHECK(bytes.size() == sizeof(expected));
+    CHECK(memcmp(&bytes[0], expected, sizeof(expected)) == 0);
+    CHECK(MapleBusPacketEncoder::ComputeCrc(expected, sizeof(expected) - 1) == 0x29);
+
+    // The same packet with a good then a bad CRC byte
+    MapleBusPacketEncoder encoder(SAMPLES_PER_BIT);
+    std::vector<MapleBusTransition> transitions;
+    encoder.AddPacket(bytes, transitions);
+    encoder.AddIdle(GAP_SAMPLES);
+    bytes.back() ^= 0xFF;
+    encoder.AddPacket(bytes, transitions);
+    encoder.AddIdle(GAP_SAMPLES);
+
+    RecordingListener listener;
+    Decode(transitions, listener);
+    CHECK(listener.mPackets.size() == 2);
+    CHECK(listener.mErrors.empty());
+    if (listener.mPackets.size() == 2)
+    {
+        CHECK(listener.mPackets[0].crcValid);
+        CHECK(!listener.mPackets[1].crcValid);
+        CHECK(listener.mPackets[1].bytes == bytes);
+    }
+
+    MapleBusPacketStore store;
+    MapleBusErrorLog errors;
+    for (size_t i = 0; i < listener.mPackets.size(); ++i)
+    {
+        store.AddPacket(listener.mPackets[i]);
+        errors.CountPacket(listener.mPackets[i]);
+    }
+    CHECK(store.GetNumCrcErrors() == 1);
+    CHECK(errors.GetCount(MAPLE_BUS_ERROR_BAD_CRC) == 1);
+}
+
+//! Packets decode to the bytes encoded, where they were encoded, and a glitch fails only its own packet unless filtered
+static void TestDecoder()
+{
+    MapleBusPacketEncoder encoder(SAMPLES_PER_BIT);
+    std::vector<MapleBusTransition> transitions;
+    std::vector<std::vector<U8> > sent;
+    std::vector<U64> startSamples;
+    const U32 numWords[] = {0, 1, 3, 48, 255};
+    for (U32 i = 0; i < sizeof(numWords) / sizeof(numWords[0]); ++i)
+    {
+        std::vector<U32> payload;
+        for (U32 j = 0; j < numWords[i]; ++j)
+        {
+            payload.push_back(0x01020304 * (j + 1));
+        }
+        std::vector<U8> bytes;
+        MapleBusPacketEncoder::BuildPacket(MAPLE_BUS_CMD_DATA_TRANSFER, MAPLE_BUS_ADDR_HOST, MAPLE_BUS_ADDR_MAIN_PERIPHERAL,
+                                           payload, bytes);
+        sent.push_back(bytes);
+        startSamples.push_back(encoder.GetCurrentSample());
+        encoder.AddPacket(bytes, transitions);
+        encoder.AddIdle(GAP_SAMPLES);
+
+        // Then the same packet with a one sample glitch part way through
+        encoder.AddPacket(bytes, transitions, static_cast<S32>(bytes.size()) * 4 + 1);
+        encoder.AddIdle(GAP_SAMPLES);
+    }
+
+    RecordingListener listener;
+    Decode(transitions, listener);
+    CHECK(listener.mPackets.size() == sent.size());
+    CHECK(listener.mErrors.size() == sent.size());
+    for (size_t i = 0; i < listener.mPackets.size() && i < sent.size(); ++i)
+    {
+        const MapleBusPacket& packet = listener.mPackets[i];
+        CHECK(packet.bytes == sent[i]);
+        CHECK(packet.crcValid);
+        CHECK(packet.startSample == startSamples[i]);
+        CHECK(packet.byteEndSamples.size() == packet.bytes.size());
+        CHECK(packet.dataStartSample > packet.startSample && packet.endSample > packet.byteEndSamples.back());
+        CHECK(packet.timing.minPeriod == SAMPLES_PER_BIT && packet.timing.maxPeriod == SAMPLES_PER_BIT);
+    }
+    for (size_t i = 0; i < listener.mErrors.size(); ++i)
+    {
+        CHECK(listener.mErrors[i].type == MAPLE_BUS_ERROR_DATA_EDGES);
+    }
+
+    // A filter 2 samples wide removes every glitch but no real edge
+    RecordingListener filtered;
+    MapleBusDecoder decoder(&filtered);
+    MapleBusTransitionArraySource source(MAPLE_BUS_LINES_AB, &transitions[0], transitions.size());
+    MapleBusGlitchFilter filter(&source, 2, 2);
+    decoder.Run(&filter);
+    CHECK(filtered.mPackets.size() == 2 * sent.size());
+    CHECK(filtered.mErrors.empty());
+    CHECK(filter.GetNumGlitches() == sent.size());
+    for (size_t i = 0; i < filtered.mPackets.size(); ++i)
+    {
+        CHECK(filtered.mPackets[i].bytes == sent[i / 2]);
+    }
+}
+
+//! Commands are paired with the oldest matching response, and short or unanswered packets stand alone
+static void TestTransactionTracker()
+{
+    // Host polls the controller, which answers; a packet cut short before its frame word falls between a command and
+    // its response; then a command goes unanswered and the controller is polled again
+    std::vector<U32> poll(1, MAPLE_BUS_FUNC_CONTROLLER);
+    std::vector<U32> condition(3, MAPLE_BUS_FUNC_CONTROLLER);
+    std::vector<U8> command;
+    std::vector<U8> response;
+    MapleBusPacketEncoder::BuildPacket(MAPLE_BUS_CMD_GET_CONDITION, MAPLE_BUS_ADDR_MAIN_PERIPHERAL, MAPLE_BUS_ADDR_HOST,
+                                       poll, command);
+    MapleBusPacketEncoder::BuildPacket(MAPLE_BUS_CMD_DATA_TRANSFER, MAPLE_BUS_ADDR_HOST, MAPLE_BUS_ADDR_MAIN_PERIPHERAL,
+                                       condition, response);
+    std::vector<U8> cutShort(response.begin(), response.begin() + 2);
+    const std::vector<U8>* packets[] = {&command, &response, &command, &cutShort, &response, &command, &command};
+    const U32 numPackets = sizeof(packets) / sizeof(packets[0]);
+
+    MapleBusPacketStore store;
+    MapleBusTransactionTracker tracker;
+    for (U32 i = 0; i < numPackets; ++i)
+    {
+        MapleBusPacket packet;
+        packet.startSample = 1000 * i;
+        packet.dataStartSample = packet.startSample + 100;
+        packet.endSample = packet.startSample + 500;
+        packet.bytes = *packets[i];
+        for (size_t j = 0; j < packet.bytes.size(); ++j)
+        {
+            packet.byteEndSamples.push_back(packet.dataStartSample + 8 * (j + 1));
+        }
+        packet.crcValid = (packet.bytes.size() > 4);
+        packet.timing.Clear();
+
+        U64 packetIndex = store.AddPacket(packet);
+        MapleBusPacketInfo info;
+        CHECK(store.GetPacketInfo(packetIndex, info));
+        tracker.AddPacket(packetIndex, info, packet.startSample, packet.endSample);
+    }
+
+    // Transactions 0 and 2 were answered by packets 1 and 4; 3, 5 and 6 stand alone
+    const U64 expectedIds[] = {0, 2, 3, 5, 6};
+    const U32 numExpected = sizeof(expectedIds) / sizeof(expectedIds[0]);
+    CHECK(tracker.GetNumTransactions() == numExpected);
+    for (U32 i = 0; i < numExpected; ++i)
+    {
+        MapleBusTransactionRecord record;
+        CHECK(tracker.GetTransactionAt(i, record));
+        CHECK(record.id == expectedIds[i]);
+    }
+
+    MapleBusTransactionRecord record;
+    CHECK(tracker.GetTransaction(0, record) && record.isCommand && record.hasResponse && record.responseIndex == 1);
+    CHECK(record.GetTurnaroundSamples() == 500);
+    CHECK(tracker.GetTransaction(2, record) && record.hasResponse && record.responseIndex == 4);
+    CHECK(record.GetTurnaroundSamples() == 1500);
+    CHECK(tracker.GetTransaction(3, record) && !record.isCommand && !record.hasResponse);
+    CHECK(tracker.GetTransaction(5, record) && record.isCommand && !record.hasResponse);
+    CHECK(tracker.GetTransaction(6, record) && record.isCommand && !record.hasResponse);
+    CHECK(!tracker.GetTransaction(1, record));
+
+    // Once trimmed, the oldest transactions are gone but IDs are kept
+    MapleBusTransactionTracker bounded;
+    bounded.SetMaxTransactions(2);
+    for (U64 i = 0; i < 10; ++i)
+    {
+        MapleBusPacketInfo info;
+        CHECK(store.GetPacketInfo(i % numPackets, info));
+        bounded.AddPacket(i, info, 1000 * i, 1000 * i + 500);
+    }
+    CHECK(bounded.GetNumTransactions() > 2);
+    CHECK(bounded.GetFirstTransactionIndex() > 0);
+    CHECK(!bounded.GetTransactionAt(0, record));
+    CHECK(bounded.GetTransactionAt(bounded.GetNumTransactions() - 1, record) && record.id == 9);
+}
+
+//! Items are dropped in batches once twice the limit are retained, and indices stay valid
+static void TestRetainedRing()
+{
+    MapleBusRetainedRing<U32> ring;
+    ring.SetMaxItems(3);
+    for (U32 i = 0; i < 5; ++i)
+    {
+        CHECK(ring.Add(i * 10) == i);
+        CHECK(ring.Trim() == 0);
+    }
+    CHECK(ring.Add(50) == 5);
+    CHECK(ring.Trim() == 3);
+    CHECK(ring.GetFirstIndex() == 3);
+    CHECK(ring.GetNumItems() == 6);
+    CHECK(ring.GetRetained().size() == 3);
+    CHECK(ring.Find(2) == NULL);
+    CHECK(ring.Find(3) != NULL && *ring.Find(3) == 30);
+    CHECK(ring.Find(5) != NULL && *ring.Find(5) == 50);
+    CHECK(ring.Find(6) == NULL);
+
+    ring.Clear();
+    CHECK(ring.GetNumItems() == 0 && ring.GetFirstIndex() == 0);
+    ring.SetMaxItems(0);
+    for (U32 i = 0; i < 100; ++i)
+    {
+        ring.Add(i);
+        CHECK(ring.Trim() == 0);
+    }
+
+    // The store's byte arenas are rebased along with its records
+    std::vector<MapleBusTransition> transitions;
+    BuildMixedTraffic(300, transitions);
+    RecordingListener listener;
+    Decode(transitions, listener);
+    MapleBusPacketStore store;
+    store.SetMaxPackets(50);
+    for (size_t i = 0; i < listener.mPackets.size(); ++i)
+    {
+        store.AddPacket(listener.mPackets[i]);
+    }
+    CHECK(store.GetNumPackets() == listener.mPackets.size());
+    CHECK(store.GetFirstPacketIndex() >= listener.mPackets.size() - 100);
+    MapleBusPacketRecord record;
+    CHECK(!store.GetPacket(store.GetFirstPacketIndex() - 1, record));
+    for (U64 i = store.GetFirstPacketIndex(); i < store.GetNumPackets(); ++i)
+    {
+        MapleBusPacket packet;
+        CHECK(store.GetDecodedPacket(i, packet));
+        const MapleBusPacket& expected = listener.mPackets[static_cast<size_t>(i)];
+        CHECK(packet.bytes == expected.bytes);
+        CHECK(packet.byteEndSamples == expected.byteEndSamples);
+        CHECK(packet.startSample == expected.startSample && packet.endSample == expected.endSample);
+    }
+}
+
+//! @returns the little endian value at a byte offset of a file's contents
+static U64 ReadValue(const std::vector<U8>& file, U64 offset, U32 numBytes)
+{
+    U64 value = 0;
+    for (U32 i = 0; i < numBytes && offset + i < file.size(); ++i)
+    {
+        value |= static_cast<U64>(file[static_cast<size_t>(offset + i)]) << (8 * i);
+    }
+    return value;
+}
+
+//! Every column of a packet file holds what was stored
+static void TestPacketFile()
+{
+    std::vector<MapleBusTransition> transitions;
+    BuildMixedTraffic(500, transitions);
+    RecordingListener listener;
+    Decode(transitions, listener);
+    MapleBusPacketStore store;
+    for (size_t i = 0; i < listener.mPackets.size(); ++i)
+    {
+        store.AddPacket(listener.mPackets[i]);
+    }
+
+    const char* path = "MapleBusTests_packets.mbp";
+    const U32 sampleRateHz = 24000000;
+    const U64 triggerSample = 1234;
+    MapleBusPacketFileWriter writer;
+    CHECK(writer.Open(path, store.GetNumPackets(), sampleRateHz, triggerSample));
+    std::vector<U8> bytes;
+    MapleBusPacketRecord record;
+    for (U64 i = 0; i < store.GetNumPackets(); ++i)
+    {
+        store.GetPacket(i, record);
+        store.GetPacketBytes(i, bytes);
+        writer.AddPacket(record, bytes);
+    }
+    CHECK(writer.Close());
+
+    std::vector<U8> file;
+    FILE* f = fopen(path, "rb");
+    CHECK(f != NULL);
+    if (f == NULL)
+    {
+        return;
+    }
+    U8 buffer[4096];
+    size_t numRead = 0;
+    while ((numRead = fread(buffer, 1, sizeof(buffer), f)) > 0)
+    {
+        file.insert(file.end(), buffer, buffer + numRead);
+    }
+    fclose(f);
+    remove(path);
+
+    CHECK(file.size() >= MapleBusPacketFile::HEADER_SIZE);
+    if (file.size() < MapleBusPacketFile::HEADER_SIZE)
+    {
+        return;
+    }
+    CHECK(memcmp(&file[0], MapleBusPacketFile::MAGIC, 4) == 0);
+    CHECK(file[4] == MapleBusPacketFile::VERSION);
+    CHECK(ReadValue(file, 6, 2) == MapleBusPacketFile::NUM_COLUMNS);
+    CHECK(ReadValue(file, 8, 4) == sampleRateHz);
+    CHECK(ReadValue(file, 16, 8) == triggerSample);
+    U64 numPackets = ReadValue(file, 24, 8);
+    CHECK(numPackets == store.GetNumPackets());
+
+    U64 columns[MapleBusPacketFile::NUM_COLUMNS];
+    for (U32 i = 0; i < MapleBusPacketFile::NUM_COLUMNS; ++i)
+    {
+        columns[i] = ReadValue(file, 48 + 8 * i, 8);
+        CHECK(columns[i] % 8 == 0 && columns[i] <= file.size());
+    }
+    CHECK(columns[MapleBusPacketFile::NUM_COLUMNS - 1] + ReadValue(file, 32, 8) <= file.size());
+
+    for (U64 i = 0; i < numPackets && i < store.GetNumPackets(); ++i)
+    {
+        store.GetPacket(i, record);
+        store.GetPacketBytes(i, bytes);
+        U64 payloadOffset = ReadValue(file, columns[2] + 8 * i, 8);
+        U64 payloadSize = ReadValue(file, columns[5] + 4 * i, 4);
+        U8 flags = static_cast<U8>(ReadValue(file, columns[7] + i, 1));
+        bool crcReceived = (record.numBytes > 4);
+        CHECK(ReadValue(file, columns[0] + 8 * i, 8) == record.startSample);
+        CHECK(ReadValue(file, columns[1] + 8 * i, 8) == record.endSample);
+        CHECK(ReadValue(file, columns[3] + 4 * i, 4) == record.frameWord);
+        CHECK(ReadValue(file, columns[4] + 4 * i, 4) == record.function);
+        CHECK(payloadSize == (crcReceived ? record.numBytes - 5 : 0));
+        CHECK(!crcReceived || ReadValue(file, columns[6] + i, 1) == record.crc);
+        CHECK(((flags & MAPLE_BUS_PACKET_FILE_CRC_RECEIVED) != 0) == crcReceived);
+        CHECK(((flags & MAPLE_BUS_PACKET_FILE_CRC_VALID) != 0) == record.crcValid);
+        CHECK(ReadValue(file, columns[8] + 8 * i, 8) == record.timing.sumPeriods);
+        CHECK(ReadValue(file, columns[10] + 4 * i, 4) == record.timing.numPeriods);
+        for (U64 j = 0; j < payloadSize; ++j)
+        {
+            CHECK(ReadValue(file, columns[14] + payloadOffset + j, 1) == bytes[static_cast<size_t>(4 + j)]);
+        }
+    }
+}
+
+//! Checks one laid out frame against what the decoder reported
+static bool FrameMatches(const MapleBusFrameSpec& frame, U64 startSample, U64 endSample, U64 value, S32 numLeft,
+                         MapleBusFrameKind kind, MapleBusDataType type, bool error)
+{
+    return frame.startSample == startSample && frame.endSample == endSample && frame.value == value &&
+           frame.numLeft == numLeft && frame.kind == kind && frame.type == type && frame.error == error;
+}
+
+//! Frames laid out from stored packets are the frames the analyzer used to add as the decoder reported each byte and
+//! word: every byte for Each Byte; every word plus the CRC byte and any bytes beyond it for the word styles
+static void TestFrameLayout()
+{
+    std::vector<MapleBusTransition> transitions;
+    BuildMixedTraffic(2000, transitions);
+    // Some packets one byte long or with a byte beyond the CRC byte, which only the frame word's count can tell apart
+    MapleBusPacketEncoder encoder(SAMPLES_PER_BIT, transitions.back().sample + static_cast<U64>(GAP_SAMPLES));
+    const U8 odd[][6] = {{0x02}, {0x00, 0x20, 0x00, 0x07, 0x27, 0x55}, {0x01, 0x00, 0x20, 0x09, 0x28}};
+    const U32 oddSizes[] = {1, 6, 5};
+    for (U32 i = 0; i < 3; ++i)
+    {
+        encoder.AddPacket(std::vector<U8>(odd[i], odd[i] + oddSizes[i]), transitions);
+        encoder.AddIdle(GAP_SAMPLES);
+    }
+
+    RecordingListener listener;
+    Decode(transitions, listener);
+    CHECK(listener.mPackets.size() > 1900);
+
+    std::vector<MapleBusFrameSpec> frames;
+    for (size_t i = 0; i < listener.mPackets.size(); ++i)
+    {
+        const MapleBusPacket& packet = listener.mPackets[i];
+        const std::vector<MapleBusDecodedByte>& reportedBytes = listener.mPacketBytes[i];
+        const std::vector<MapleBusDecodedWord>& reportedWords = listener.mPacketWords[i];
+
+        MapleBusFrameLayout::LayOut(packet, i, MAPLE_BUS_FRAMES_EACH_BYTE, frames);
+        CHECK(frames.size() == reportedBytes.size());
+        for (size_t j = 0; j < frames.size() && j < reportedBytes.size(); ++j)
+        {
+            const MapleBusDecodedByte& b = reportedBytes[j];
+            bool error = (b.type == MAPLE_BUS_DATA_CRC && !b.crcValid);
+            CHECK(FrameMatches(frames[j], b.startSample, b.endSample, b.value, b.numBytesLeft, MAPLE_BUS_FRAME_KIND_BYTE,
+                               b.type, error));
+            CHECK(frames[j].startsPacket == (j == 0));
+        }
+
+        // Words in the order reported, each byte ending the packet just before the word it completes, if any
+        MapleBusFrameLayout::LayOut(packet, i, MAPLE_BUS_FRAMES_EACH_WORD, frames);
+        size_t frameIndex = 0;
+        size_t wordIndex = 0;
+        for (size_t j = 0; j < reportedBytes.size(); ++j)
+        {
+            const MapleBusDecodedByte& b = reportedBytes[j];
+            if (b.numBytesLeft == 0)
+            {
+                bool error = (b.type == MAPLE_BUS_DATA_CRC && !b.crcValid);
+                CHECK(frameIndex < frames.size() && FrameMatches(frames[frameIndex], b.startSample, b.endSample, b.value, 0,
+                                                                 MAPLE_BUS_FRAME_KIND_BYTE, b.type, error));
+                ++frameIndex;
+            }
+            if ((j + 1) % 4 == 0 && wordIndex < reportedWords.size())
+            {
+                const MapleBusDecodedWord& w = reportedWords[wordIndex++];
+                CHECK(frameIndex < frames.size() && FrameMatches(frames[frameIndex], w.startSample, w.endSample, w.value,
+                                                                 w.numWordsLeft, MAPLE_BUS_FRAME_KIND_WORD, w.type, false));
+                ++frameIndex;
+            }
+        }
+        CHECK(wordIndex == reportedWords.size());
+        CHECK(frameIndex == frames.size());
+
+        MapleBusFrameLayout::LayOut(packet, i, MAPLE_BUS_FRAMES_EACH_PACKET, frames);
+        CHECK(frames.size() == 1);
+        CHECK(FrameMatches(frames[0], packet.startSample, packet.endSample, i, static_cast<S32>(packet.bytes.size()),
+                           MAPLE_BUS_FRAME_KIND_PACKET, MAPLE_BUS_DATA_PAYLOAD, !packet.crcValid));
+    }
+}
+
+//! Decoding in parallel chunks reports exactly what decoding serially does, in the same order
+static void TestParallelDecode()
+{
+    std::vector<MapleBusTransition> transitions;
+    BuildMixedTraffic(6000, transitions);
+    RecordingListener serial;
+    Decode(transitions, serial);
+    CHECK(!serial.mErrors.empty());
+
+    const U32 numThreads[] = {2, 3, 4, 8};
+    for (U32 i = 0; i < sizeof(numThreads) / sizeof(numThreads[0]); ++i)
+    {
+        RecordingListener parallel;
+        MapleBusParallelDecoder decoder(&parallel);
+        decoder.Run(MAPLE_BUS_LINES_AB, &transitions[0], transitions.size(), numThreads[i]);
+        CHECK(decoder.GetNumChunks() > 1);
+        CHECK(parallel.mEvents.size() == serial.mEvents.size());
+        size_t numDifferent = 0;
+        for (size_t j = 0; j < parallel.mEvents.size() && j < serial.mEvents.size(); ++j)
+        {
+            if (parallel.mEvents[j] != serial.mEvents[j] && numDifferent++ == 0)
+            {
+                fprintf(stderr, "%u threads, event %zu: \"%s\", serially \"%s\"\n", numThreads[i], j,
+                        parallel.mEvents[j].c_str(), serial.mEvents[j].c_str());
+            }
+        }
+        CHECK(numDifferent == 0);
+    }
+}
+
+//! A named test
+struct Test
+{
+    //! Name to run the test by
+    const char* name;
+    //! Runs the test
+    void (*run)();
+};
+
+static const Test TESTS[] = {{"crc", TestCrc},
+                             {"decoder", TestDecoder},
+                             {"transaction_tracker", TestTransactionTracker},
+                             {"retained_ring", TestRetainedRing},
+                             {"packet_file", TestPacketFile},
+                             {"frame_layout", TestFrameLayout},
+                             {"parallel_decode", TestParallelDecode}};
+
+int main(int argc, char** argv)
+{
+    const U32 numTests = sizeof(TESTS) / sizeof(TESTS[0]);
+    bool found = false;
+    for (U32 i = 0; i < numTests; ++i)
+    {
+        if (argc < 2 || strcmp(argv[1], TESTS[i].name) == 0)
+        {
+            U32 numFailuresBefore = gNumFailures;
+            TESTS[i].run();
+            printf("%s: %s\n", TESTS[i].name, (gNumFailures == numFailuresBefore) ? "passed" : "FAILED");
+            found = true;
+        }
+    }
+    if (!found)
+    {
+        fprintf(stderr, "Unknown test: %s\n", argv[1]);
+        return 1;
+    }
+    return (gNumFailures == 0) ? 0 : 1;
+}
@@ -0,0 +1,957 @@
+// Maple Bus decode benchmark
+//
+// Decodes a synthetic heavy-traffic capture while keeping results the way the analyzer does. First decodes in every
+// output style and prints packets and edges per second, result memory, and the process's peak resident set size so far.
+// Styles run from least to most result memory so the peak reflects each one. Then decodes in the "Word Bytes (little
+// endian)" output style (one frame per word and CRC byte, start and stop markers per packet, and a marker per bit
+// depending on the bit marker setting) and prints result memory and decode time for each bit marker setting. Finally
+// decodes in the "Each Byte" output style under each commit schedule and prints commits and frames per second. A
+// commit is modelled as taking a lock and publishing the frame count; the host's own work per commit is not included,
+// so real savings are larger.
+//
+// Packets decoded once are then laid out again in every output style, timing how long switching styles takes compared
+// with decoding the capture again. The same packets are then searched through the packet index, by fields and by time,
+// and the time is compared with scanning the packet store.
+//
+// Glitched packets carry a one sample pulse, so the capture is decoded once more through a glitch filter twice that
+// width, which should remove every pulse and leave no errors.
+//
+// Results of each output style are also exported the way the analyzer's export does: with hex numbers on one thread and
+// on every hardware thread, then with decimal numbers on every hardware thread. The export size and MB per second are
+// printed. Exports go to the null device unless -x names a file, so formatting rather than the disk is measured by
+// default.
+//
+// Pass -m to decode the realistic exchanges of the simulation data generator, or -f to replay a recorded transition list
+// file, instead of the default synthetic capture. -w writes the capture being decoded to a transition list file.
+
+#include "MapleBusCommitScheduler.h"
+#include "MapleBusDecoder.h"
+#include "MapleBusErrorLog.h"
+#include "MapleBusExportPipeline.h"
+#include "MapleBusExportWriter.h"
+#include "MapleBusFrameLayout.h"
+#include "MapleBusGlitchFilter.h"
+#include "MapleBusPacketEncoder.h"
+#include "MapleBusPacketIndex.h"
+#include "MapleBusPacketStore.h"
+#include "MapleBusTrafficGenerator.h"
+#include "MapleBusTransitionFile.h"
+#include "MapleBusTransitionSource.h"
+#include <chrono>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+//! Same as the analyzer's output styles
+enum ModelOutputStyle
+{
+    MODEL_STYLE_EACH_BYTE = 0,
+    MODEL_STYLE_EACH_WORD,
+    MODEL_STYLE_WORD_BYTES,
+    MODEL_STYLE_WORD_BYTES_LE,
+    MODEL_STYLE_EACH_PACKET
+};
+
+//! Same as MapleBusAnalyzerResults::FrameDataType
+enum ModelFrameType
+{
+    MODEL_FRAME_PAYLOAD = 0,
+    MODEL_FRAME_FRAME,
+    MODEL_FRAME_CRC,
+    MODEL_FRAME_PACKET,
+    MODEL_FRAME_ERROR
+};
+
+//! Same as the SDK's DISPLAY_AS_ERROR_FLAG
+const U8 MODEL_ERROR_FLAG = 0x80;
+
+//! Same layout as the SDK's Frame
+struct ModelFrame
+{
+    U64 mStartingSampleInclusive;
+    U64 mEndingSampleInclusive;
+    U64 mData1;
+    U64 mData2;
+    U8 mType;
+    U8 mFlags;
+};
+
+//! A marker as handed to AnalyzerResults::AddMarker()
+struct ModelMarker
+{
+    U64 sample;
+    U32 type;
+    U32 channel;
+};
+
+//! Keeps results the same way MapleBusAnalyzer does
+class ResultsModel : public MapleBusDecoderListener
+{
+  public:
+    //! Constructor
+    //! @param[in] style  decides which frames are added
+    //! @param[in] scheduler  decides when to commit, or NULL to never commit
+    ResultsModel(ModelOutputStyle style, MapleBusCommitScheduler* scheduler)
+        : mErrors(), mNumBitMarkers(0), mNumPackets(0), mNumCommittedFrames(0), mStyle(style), mScheduler(scheduler),
+          mPartialPacket(), mPacketFrames()
+    {
+    }
+
+    virtual void OnPacketStart(U64 startSample, U64 endSample)
+    {
+        AddMarker(startSample, 0);
+        AddMarker(startSample, 1);
+        mPartialPacket.startSample = startSample;
+        mPartialPacket.dataStartSample = endSample;
+        mPartialPacket.endSample = endSample;
+        mPartialPacket.bytes.clear();
+        mPartialPacket.byteEndSamples.clear();
+        mPartialPacket.crcValid = false;
+    }
+
+    virtual void OnBit(U64 clockEdgeSample, bool clockIsA, bool value)
+    {
+        AddMarker(clockEdgeSample, clockIsA ? 0 : 1);
+        ++mNumBitMarkers;
+    }
+
+    virtual void OnByte(const MapleBusDecodedByte& decodedByte)
+    {
+        mPartialPacket.bytes.push_back(decodedByte.value);
+        mPartialPacket.byteEndSamples.push_back(decodedByte.endSample);
+        if (decodedByte.type == MAPLE_BUS_DATA_CRC && decodedByte.crcValid)
+        {
+            mPartialPacket.crcValid = true;
+        }
+    }
+
+    virtual void OnPacketEnd(const MapleBusPacket& packet)
+    {
+        U64 packetIndex = mStore.AddPacket(packet);
+        MapleBusPacketInfo info;
+        mStore.GetPacketInfo(packetIndex, info);
+        mIndex.AddPacket(packet.startSample, packet.endSample, info);
+        mErrors.CountPacket(packet);
+        ++mNumPackets;
+        AddPacketFrames(packet, packetIndex);
+        mPartialPacket.bytes.clear();
+        mPartialPacket.byteEndSamples.clear();
+        AddMarker(packet.endSample, 0);
+        AddMarker(packet.endSample, 1);
+        if (mScheduler != NULL && mScheduler->EndPacket())
+        {
+            Commit();
+        }
+    }
+
+    virtual void OnError(const MapleBusDecodeError& error)
+    {
+        mErrors.AddError(error);
+        if (mStyle != MODEL_STYLE_EACH_PACKET)
+        {
+            AddPacketFrames(mPartialPacket, 0);
+        }
+        mPartialPacket.bytes.clear();
+        mPartialPacket.byteEndSamples.clear();
+        AddMarker(error.sample, 0);
+        AddMarker(error.sample, 1);
+    }
+
+    virtual void OnResync(U64 errorSample, U64 resumeSample)
+    {
+        if (resumeSample > errorSample)
+        {
+            AddMarker(resumeSample, 0);
+            AddMarker(resumeSample, 1);
+        }
+        else
+        {
+            resumeSample = errorSample;
+        }
+        mErrors.EndError(resumeSample);
+        AddFrame(errorSample, resumeSample, mErrors.GetNumErrors() - 1, 0, MODEL_FRAME_ERROR, MODEL_ERROR_FLAG);
+    }
+
+    //! Adds the frames of a packet the same way MapleBusAnalyzer::AddPacketFrames() does
+    void AddPacketFrames(const MapleBusPacket& packet, U64 packetIndex)
+    {
+        MapleBusFrameLayout::LayOut(packet, packetIndex, GetFrameStyle(mStyle), mPacketFrames);
+        for (std::vector<MapleBusFrameSpec>::const_iterator iter = mPacketFrames.begin(); iter != mPacketFrames.end(); ++iter)
+        {
+            U8 type = MODEL_FRAME_PAYLOAD;
+            if (iter->kind == MAPLE_BUS_FRAME_KIND_PACKET)
+            {
+                type = MODEL_FRAME_PACKET;
+            }
+            else if (iter->type == MAPLE_BUS_DATA_FRAME)
+            {
+                type = MODEL_FRAME_FRAME;
+            }
+            else if (iter->type == MAPLE_BUS_DATA_CRC)
+            {
+                type = MODEL_FRAME_CRC;
+            }
+            AddFrame(iter->startSample, iter->endSample, iter->value, iter->numLeft, type, iter->error ? MODEL_ERROR_FLAG : 0);
+        }
+    }
+
+    //! @returns the frame style of an output style, the same as MapleBusAnalyzer::SetupResults()
+    static MapleBusFrameStyle GetFrameStyle(ModelOutputStyle style)
+    {
+        if (style == MODEL_STYLE_EACH_BYTE)
+        {
+            return MAPLE_BUS_FRAMES_EACH_BYTE;
+        }
+        else if (style == MODEL_STYLE_EACH_PACKET)
+        {
+            return MAPLE_BUS_FRAMES_EACH_PACKET;
+        }
+        return MAPLE_BUS_FRAMES_EACH_WORD;
+    }
+
+    //! Limits the packets and errors retained, the same way as MapleBusAnalyzer::SetupResults()
+    void SetMaxPackets(U64 maxPackets)
+    {
+        mStore.SetMaxPackets(maxPackets);
+        mIndex.SetMaxPackets(maxPackets);
+        mErrors.SetMaxErrors(maxPackets);
+    }
+
+    //! @returns the number of bytes held by the packet and error records, which are bounded by SetMaxPackets()
+    U64 GetRecordMemoryUsage() const
+    {
+        return mStore.GetMemoryUsage() + mIndex.GetMemoryUsage() + mErrors.GetMemoryUsage();
+    }
+
+    //! @returns the number of bytes held by all results
+    U64 GetMemoryUsage() const
+    {
+        return mFrames.capacity() * sizeof(ModelFrame) + mMarkers.capacity() * sizeof(ModelMarker) + GetRecordMemoryUsage();
+    }
+
+    std::vector<ModelFrame> mFrames;
+    std::vector<ModelMarker> mMarkers;
+    MapleBusPacketStore mStore;
+    MapleBusPacketIndex mIndex;
+    MapleBusErrorLog mErrors;
+    U64 mNumBitMarkers;
+    U64 mNumPackets;
+    //! Number of frames visible to the host
+    size_t mNumCommittedFrames;
+
+  private:
+    void AddFrame(U64 startSample, U64 endSample, U64 data1, S32 data2, U8 type, U8 flags)
+    {
+        ModelFrame frame;
+        frame.mStartingSampleInclusive = startSample;
+        frame.mEndingSampleInclusive = endSample;
+        frame.mData1 = data1;
+        frame.mData2 = data2;
+        frame.mType = type;
+        frame.mFlags = flags;
+        mFrames.push_back(frame);
+        if (mScheduler != NULL && mScheduler->AddFrame())
+        {
+            Commit();
+        }
+    }
+
+    void Commit()
+    {
+        std::lock_guard<std::mutex> lock(mHostMutex);
+        mNumCommittedFrames = mFrames.size();
+        mScheduler->Committed();
+    }
+
+    void AddMarker(U64 sample, U32 channel)
+    {
+        ModelMarker marker;
+        marker.sample = sample;
+        marker.type = 0;
+        marker.channel = channel;
+        mMarkers.push_back(marker);
+    }
+
+  public:
+    const ModelOutputStyle mStyle;
+
+  private:
+    MapleBusCommitScheduler* mScheduler;
+    //! Stands in for the host's lock over committed results
+    std::mutex mHostMutex;
+    //! Bytes of the packet being received
+    MapleBusPacket mPartialPacket;
+    //! Frames of the latest packet
+    std::vector<MapleBusFrameSpec> mPacketFrames;
+};
+
+//! Exports results the same way MapleBusAnalyzerResults::GenerateExportFile() does
+class ModelExportFormatter : public MapleBusExportBlockFormatter
+{
+  public:
+    //! Constructor
+    //! @param[in] results  the results to export
+    //! @param[in] hex  true for hex numbers, false for decimal
+    //! @param[in] sampleRateHz  the sample rate used for times
+    //! @param[in] numSlots  the number of pipeline slots
+    ModelExportFormatter(const ResultsModel& results, bool hex, U32 sampleRateHz, U32 numSlots)
+        : mResults(results), mHex(hex), mSampleRateHz(sampleRateHz), mBlocks(numSlots), mPreviousNumItemsLeft(0),
+          mPreviousType(MODEL_FRAME_PAYLOAD)
+    {
+    }
+
+    //! @returns the number of blocks to export
+    U64 GetNumBlocks() const
+    {
+        return (mResults.mFrames.size() + BLOCK_FRAMES - 1) / BLOCK_FRAMES;
+    }
+
+    virtual void PrepareBlock(U64 blockIndex, U32 slot)
+    {
+        // Frames are copied as the analyzer fetches them from the host
+        Block& block = mBlocks[slot];
+        size_t firstFrame = static_cast<size_t>(blockIndex * BLOCK_FRAMES);
+        size_t numFrames = mResults.mFrames.size() - firstFrame;
+        numFrames = (numFrames < BLOCK_FRAMES) ? numFrames : BLOCK_FRAMES;
+        block.frames.assign(mResults.mFrames.begin() + firstFrame, mResults.mFrames.begin() + firstFrame + numFrames);
+        block.lineStarts.resize(numFrames);
+        for (size_t i = 0; i < numFrames; ++i)
+        {
+            const ModelFrame& frame = block.frames[i];
+            U32 numItemsLeft = static_cast<U32>(frame.mData2);
+            block.lineStarts[i] = (mResults.mStyle == MODEL_STYLE_EACH_PACKET || firstFrame + i == 0 ||
+                                   frame.mType == MODEL_FRAME_ERROR || mPreviousType == MODEL_FRAME_ERROR ||
+                                   (numItemsLeft > 0 && mPreviousNumItemsLeft == 0) ||
+                                   (mPreviousNumItemsLeft > 0 && mPreviousNumItemsLeft - 1 != numItemsLeft) ||
+                                   (mPreviousType == MODEL_FRAME_CRC && frame.mType != MODEL_FRAME_CRC));
+            mPreviousNumItemsLeft = numItemsLeft;
+            mPreviousType = frame.mType;
+        }
+    }
+
+    virtual void FormatBlock(U32 slot, MapleBusExportWriter& text)
+    {
+        const Block& block = mBlocks[slot];
+        std::vector<U8> bytes;
+        MapleBusErrorRecord record;
+        for (size_t i = 0; i < block.frames.size(); ++i)
+        {
+            const ModelFrame& frame = block.frames[i];
+            if (block.lineStarts[i])
+            {
+                text.AddChar('\n');
+                text.AddTime(frame.mStartingSampleInclusive, 0, mSampleRateHz);
+                text.AddChar(',');
+            }
+            if (frame.mType == MODEL_FRAME_ERROR)
+            {
+                if (mResults.mErrors.GetError(frame.mData1, record))
+                {
+                    char description_str[128];
+                    MapleBusErrorLog::GetDescription(record, description_str, sizeof(description_str));
+                    text.AddString(description_str);
+                }
+            }
+            else if (mResults.mStyle == MODEL_STYLE_EACH_PACKET)
+            {
+                AddPacket(text, frame, bytes);
+            }
+            else
+            {
+                AddFrameData(text, frame);
+                text.AddChar(',');
+                if ((frame.mFlags & MODEL_ERROR_FLAG) != 0)
+                {
+                    text.AddString("bad CRC,", 8);
+                }
+            }
+        }
+    }
+
+    virtual bool OnBlockWritten(U64 numBlocksWritten)
+    {
+        return false;
+    }
+
+  private:
+    //! Number of frames in each block, same as the analyzer
+    static const size_t BLOCK_FRAMES = 16384;
+
+    //! Frames of one block
+    struct Block
+    {
+        std::vector<ModelFrame> frames;
+        std::vector<bool> lineStarts;
+    };
+
+    void AddPacket(MapleBusExportWriter& text, const ModelFrame& frame, std::vector<U8>& bytes) const
+    {
+        MapleBusPacketInfo info;
+        mResults.mStore.GetPacketInfo(frame.mData1, info);
+        char command_str[32];
+        char sender_str[16];
+        char recipient_str[16];
+        MapleBusProtocol::GetCommandString(info.command, command_str, sizeof(command_str));
+        MapleBusProtocol::GetAddressString(info.sender, sender_str, sizeof(sender_str));
+        MapleBusProtocol::GetAddressString(info.recipient, recipient_str, sizeof(recipient_str));
+        text.AddString(command_str);
+        text.AddChar(',');
+        text.AddString(sender_str);
+        text.AddChar(',');
+        text.AddString(recipient_str);
+        text.AddChar(',');
+        if (info.hasFunction)
+        {
+            char function_str[128];
+            MapleBusProtocol::GetFunctionString(info.function, function_str, sizeof(function_str));
+            text.AddString(function_str);
+        }
+        text.AddChar(',');
+
+        mResults.mStore.GetPacketBytes(frame.mData1, bytes);
+        for (size_t j = 0; j < bytes.size(); ++j)
+        {
+            if (j > 0)
+            {
+                text.AddChar(',');
+            }
+            AddNumber(text, bytes[j], 8);
+        }
+        if ((frame.mFlags & MODEL_ERROR_FLAG) != 0)
+        {
+            text.AddString(",bad CRC", 8);
+        }
+    }
+
+    void AddFrameData(MapleBusExportWriter& text, const ModelFrame& frame) const
+    {
+        ModelOutputStyle style = mResults.mStyle;
+        if (style == MODEL_STYLE_EACH_BYTE || frame.mType == MODEL_FRAME_CRC)
+        {
+            AddNumber(text, frame.mData1, 8);
+            if (frame.mType == MODEL_FRAME_CRC && (style == MODEL_STYLE_WORD_BYTES || style == MODEL_STYLE_WORD_BYTES_LE))
+            {
+                text.AddString(",,,", 3);
+            }
+        }
+        else if (style == MODEL_STYLE_EACH_WORD)
+        {
+            AddNumber(text, frame.mData1, 32);
+        }
+        else
+        {
+            bool lsbFirst = (style == MODEL_STYLE_WORD_BYTES);
+            for (U32 j = 0; j < 4; ++j)
+            {
+                U32 shift = lsbFirst ? (8 * j) : (8 * (3 - j));
+                if (j > 0)
+                {
+                    text.AddChar(',');
+                }
+                AddNumber(text, (frame.mData1 >> shift) & 0xFF, 8);
+            }
+        }
+    }
+
+    void AddNumber(MapleBusExportWriter& text, U64 value, U32 numBits) const
+    {
+        if (mHex)
+        {
+            text.AddHex(value, numBits);
+        }
+        else
+        {
+            text.AddDecimal(value);
+        }
+    }
+
+    const ResultsModel& mResults;
+    bool mHex;
+    U32 mSampleRateHz;
+    std::vector<Block> mBlocks;
+    U32 mPreviousNumItemsLeft;
+    U8 mPreviousType;
+};
+
+//! Exports results through the export pipeline
+//! @param[in] results  the results to export
+//! @param[in] hex  true for hex numbers, false for decimal
+//! @param[in] sampleRateHz  the sample rate used for times
+//! @param[in] numThreads  the number of formatting threads, 0 for one per hardware thread
+//! @param[in] path  the file to write
+//! @returns the number of bytes written, or 0 if the file could not be written
+static U64 ExportResults(const ResultsModel& results, bool hex, U32 sampleRateHz, U32 numThreads, const char* path)
+{
+    MapleBusExportWriter writer;
+    if (!writer.Open(path))
+    {
+        return 0;
+    }
+    writer.AddString("Time [s],Data & CRC ->");
+
+    MapleBusExportPipeline pipeline(numThreads);
+    ModelExportFormatter formatter(results, hex, sampleRateHz, pipeline.GetNumSlots());
+    pipeline.Run(&formatter, formatter.GetNumBlocks(), writer);
+    U64 numBytes = writer.GetNumBytesWritten();
+    return writer.Close() ? numBytes : 0;
+}
+
+//! Small deterministic generator so every run decodes the same capture
+static U32 NextRandom(U32& state)
+{
+    state = state * 1103515245 + 12345;
+    return (state >> 16) & 0x7FFF;
+}
+
+//! @returns the peak resident set size of this process so far in MB
+static double GetPeakRssMegabytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return counters.PeakWorkingSetSize / 1e6;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+#ifdef __APPLE__
+    // Bytes on macOS
+    return usage.ru_maxrss / 1e6;
+#else
+    // Kilobytes elsewhere
+    return usage.ru_maxrss * 1024 / 1e6;
+#endif
+#endif
+}
+
+//! Width of the pulse in each glitched packet of the synthetic capture; a quarter of a phase at 12 samples per bit
+static const U32 BENCH_GLITCH_SAMPLES = 1;
+
+static void PrintUsage(const char* exe)
+{
+    fprintf(stderr,
+            "Usage: %s [-n <packets>] [-e <glitched packets per 1000>] [-m controller|mixed|storage] [-f <transition file>]\n"
+            "          [-w <transition file>] [-x <export file>]\n",
+            exe);
+}
+
+//! Finds packets by fields and by time through the packet index and by scanning the packet store, printing the time of
+//! each
+static void SearchPackets(const MapleBusPacketStore& store, const MapleBusPacketIndex& index)
+{
+    // Lookups by time are slow to scan for, so only a sample of packets is looked up
+    const U64 numTimeLookups = 256;
+    U64 numPackets = store.GetNumPackets();
+    printf("\n%-28s %12s %12s %14s\n", "search stored packets", "matches", "index ms", "store scan ms");
+
+    // Every block write to the first port's first sub-peripheral
+    MapleBusPacketQuery query;
+    query.fields = MAPLE_BUS_QUERY_COMMAND | MAPLE_BUS_QUERY_RECIPIENT;
+    query.command = MAPLE_BUS_CMD_BLOCK_WRITE;
+    query.recipient = MAPLE_BUS_ADDR_SUB_PERIPHERAL_1;
+    std::vector<U64> matches;
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    index.FindPackets(query, 0, 0, matches);
+    double indexMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+    U64 numScanMatches = 0;
+    startTime = std::chrono::steady_clock::now();
+    for (U64 i = 0; i < numPackets; ++i)
+    {
+        MapleBusPacketInfo info;
+        store.GetPacketInfo(i, info);
+        if (info.command == query.command && info.recipient == query.recipient)
+        {
+            ++numScanMatches;
+        }
+    }
+    double scanMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    printf("%-28s %12zu %12.3f %14.3f\n", "Block Write to A Sub 1", matches.size(), indexMs, scanMs);
+
+    // The packet spanning the middle of each of a sample of packets
+    U64 step = (numPackets > numTimeLookups) ? numPackets / numTimeLookups : 1;
+    U64 numFound = 0;
+    startTime = std::chrono::steady_clock::now();
+    for (U64 i = 0; i < numPackets; i += step)
+    {
+        MapleBusPacketIndexEntry entry;
+        index.GetEntry(i, entry);
+        U64 packetIndex = 0;
+        if (index.FindPacketAt(entry.startSample + entry.numSamples / 2, packetIndex))
+        {
+            ++numFound;
+        }
+    }
+    indexMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+    U64 numScanFound = 0;
+    startTime = std::chrono::steady_clock::now();
+    for (U64 i = 0; i < numPackets; i += step)
+    {
+        MapleBusPacketRecord target;
+        store.GetPacket(i, target);
+        U64 sample = target.startSample + (target.endSample - target.startSample) / 2;
+        MapleBusPacketRecord record;
+        for (U64 j = 0; j < numPackets && store.GetPacket(j, record) && record.startSample <= sample; ++j)
+        {
+            if (sample <= record.endSample)
+            {
+                ++numScanFound;
+                break;
+            }
+        }
+    }
+    scanMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    printf("%-28s %12llu %12.3f %14.3f\n", "Packet at sample", numFound, indexMs, scanMs);
+    if (numScanFound != numFound || numScanMatches != matches.size())
+    {
+        fprintf(stderr, "Packet index and store scan disagree\n");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    U32 numPackets = 200000;
+    U32 errorsPerThousand = 10;
+    const char* mixName = NULL;
+    const char* inPath = NULL;
+    const char* outPath = NULL;
+#ifdef _WIN32
+    const char* exportPath = "NUL";
+#else
+    const char* exportPath = "/dev/null";
+#endif
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            numPackets = static_cast<U32>(strtoul(argv[++i], NULL, 10));
+        }
+        else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc)
+        {
+            errorsPerThousand = static_cast<U32>(strtoul(argv[++i], NULL, 10));
+        }
+        else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+        {
+            mixName = argv[++i];
+        }
+        else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+        {
+            inPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+        {
+            outPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-x") == 0 && i + 1 < argc)
+        {
+            exportPath = argv[++i];
+        }
+        else
+        {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    // 12 samples per bit with 80 idle samples after each packet
+    const double samplesPerBit = 12;
+    const double gapSamples = 80;
+    std::vector<MapleBusTransition> transitions;
+    U8 initialLines = MAPLE_BUS_LINES_AB;
+    U64 endSample = 0;
+    // Only used for export times; a rate Logic commonly captures at
+    U32 sampleRateHz = 100000000;
+    if (inPath != NULL)
+    {
+        // Recorded traffic; all transitions are loaded up front so file reads aren't timed
+        MapleBusTransitionReader reader;
+        if (!reader.Open(inPath))
+        {
+            fprintf(stderr, "Failed to open transition file: %s\n", inPath);
+            return 1;
+        }
+        initialLines = reader.GetInitialLines();
+        MapleBusTransition transition;
+        while (reader.GetNextTransition(transition))
+        {
+            transitions.push_back(transition);
+        }
+        endSample = reader.GetEndSample();
+        sampleRateHz = (reader.GetSampleRate() > 0) ? reader.GetSampleRate() : sampleRateHz;
+        numPackets = 0;
+    }
+    else if (mixName != NULL)
+    {
+        // Realistic exchanges from the simulation data generator
+        MapleBusTrafficMix mix;
+        if (strcmp(mixName, "controller") == 0)
+        {
+            mix = MAPLE_BUS_TRAFFIC_CONTROLLER;
+        }
+        else if (strcmp(mixName, "mixed") == 0)
+        {
+            mix = MAPLE_BUS_TRAFFIC_MIXED;
+        }
+        else if (strcmp(mixName, "storage") == 0)
+        {
+            mix = MAPLE_BUS_TRAFFIC_STORAGE;
+        }
+        else
+        {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+
+        MapleBusTrafficGenerator traffic(mix, samplesPerBit, gapSamples);
+        while (traffic.GetNumPackets() < numPackets)
+        {
+            traffic.AddExchange(transitions);
+        }
+        numPackets = static_cast<U32>(traffic.GetNumPackets());
+        endSample = traffic.GetCurrentSample();
+    }
+    else
+    {
+        // Controller traffic is mostly short condition packets with the occasional larger transfer
+        MapleBusPacketEncoder encoder(samplesPerBit);
+        U32 randomState = 1;
+        std::vector<U32> payload;
+        std::vector<U8> bytes;
+        for (U32 i = 0; i < numPackets; ++i)
+        {
+            U32 numWords = ((NextRandom(randomState) % 8) == 0) ? (NextRandom(randomState) % 48) : 3;
+            payload.clear();
+            for (U32 j = 0; j < numWords; ++j)
+            {
+                U32 word = 0;
+                for (U32 k = 0; k < 4; ++k)
+                {
+                    word |= static_cast<U32>(NextRandom(randomState) & 0xFF) << (8 * k);
+                }
+                payload.push_back(word);
+            }
+            MapleBusPacketEncoder::BuildPacket(0x09, 0x00, 0x20, payload, bytes);
+
+            bool glitch = ((NextRandom(randomState) % 1000) < errorsPerThousand);
+            encoder.AddPacket(bytes, transitions, glitch ? (static_cast<S32>(bytes.size()) * 8) / 2 + 3 : -1,
+                              BENCH_GLITCH_SAMPLES);
+            encoder.AddIdle(gapSamples);
+        }
+        endSample = encoder.GetCurrentSample();
+    }
+
+    if (transitions.empty())
+    {
+        fprintf(stderr, "No transitions to decode\n");
+        return 1;
+    }
+
+    if (outPath != NULL)
+    {
+        MapleBusTransitionWriter writer;
+        bool writeOk = writer.Open(outPath, 0, 0, initialLines);
+        for (size_t i = 0; writeOk && i < transitions.size(); ++i)
+        {
+            writer.AddTransition(transitions[i].sample, transitions[i].lines);
+        }
+        if (!writeOk || !writer.Close(endSample))
+        {
+            fprintf(stderr, "Failed to write transition file: %s\n", outPath);
+            return 1;
+        }
+    }
+
+    if (inPath != NULL)
+    {
+        printf("%s, %zu transitions\n", inPath, transitions.size());
+    }
+    else
+    {
+        printf("%u packets, %zu transitions\n", numPackets, transitions.size());
+    }
+    printf("peak RSS before decoding: %.1f MB\n\n", GetPeakRssMegabytes());
+    printf("%-28s %10s %14s %14s %12s %14s\n", "output style", "packets", "packets/s", "edges/s", "result MB",
+           "peak RSS MB");
+
+    const ModelOutputStyle styles[] = {MODEL_STYLE_EACH_PACKET, MODEL_STYLE_EACH_WORD, MODEL_STYLE_WORD_BYTES,
+                                       MODEL_STYLE_WORD_BYTES_LE, MODEL_STYLE_EACH_BYTE};
+    const char* styleNames[] = {"Each Packet", "Each Word (little endian)", "Word Bytes", "Word Bytes (little endian)",
+                                "Each Byte"};
+    const U32 numStyles = sizeof(styles) / sizeof(styles[0]);
+    // Hex on one thread, hex on every thread, then decimal on every thread
+    const U32 numExports = 3;
+    double exportMegabytes[numStyles] = {};
+    double exportMegabytesPerS[numStyles][numExports] = {};
+    for (U32 i = 0; i < numStyles; ++i)
+    {
+        // Bit markers are left at the default so results match an out of the box analyzer
+        MapleBusCommitScheduler scheduler(MAPLE_BUS_COMMIT_BATCHED, 1000, 100);
+        ResultsModel results(styles[i], &scheduler);
+        MapleBusDecoder decoder(&results);
+        MapleBusTransitionArraySource source(initialLines, &transitions[0], transitions.size());
+
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        decoder.Run(&source);
+        double elapsedS = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        printf("%-28s %10llu %14.0f %14.0f %12.1f %14.1f\n", styleNames[i], results.mNumPackets,
+               results.mNumPackets / elapsedS, transitions.size() / elapsedS, results.GetMemoryUsage() / 1e6,
+               GetPeakRssMegabytes());
+
+        for (U32 j = 0; j < numExports; ++j)
+        {
+            bool hex = (j < 2);
+            startTime = std::chrono::steady_clock::now();
+            U64 numBytes = ExportResults(results, hex, sampleRateHz, (j == 0) ? 1 : 0, exportPath);
+            elapsedS = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            if (numBytes == 0)
+            {
+                fprintf(stderr, "Failed to write export file: %s\n", exportPath);
+                return 1;
+            }
+            if (j == 0)
+            {
+                exportMegabytes[i] = numBytes / 1e6;
+            }
+            exportMegabytesPerS[i][j] = numBytes / 1e6 / elapsedS;
+        }
+    }
+
+    U32 numThreads = std::thread::hardware_concurrency();
+    char threadsHeader[32];
+    snprintf(threadsHeader, sizeof(threadsHeader), "hex %u thread MB/s", (numThreads > 0) ? numThreads : 1);
+    printf("\n%-28s %10s %18s %18s %14s\n", "export", "hex MB", "hex 1 thread MB/s", threadsHeader, "decimal MB/s");
+    for (U32 i = 0; i < numStyles; ++i)
+    {
+        printf("%-28s %10.1f %18.1f %18.1f %14.1f\n", styleNames[i], exportMegabytes[i], exportMegabytesPerS[i][0],
+               exportMegabytesPerS[i][1], exportMegabytesPerS[i][2]);
+    }
+
+    // Packets are stored independent of output style, so switching styles only needs the frames laid out again
+    printf("\n%-28s %12s %12s %12s\n", "restyle stored packets", "frames", "lay out ms", "decode ms");
+    {
+        ResultsModel decoded(MODEL_STYLE_EACH_PACKET, NULL);
+        MapleBusDecoder decoder(&decoded);
+        MapleBusTransitionArraySource source(initialLines, &transitions[0], transitions.size());
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        decoder.Run(&source);
+        double decodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+        MapleBusPacket packet;
+        for (U32 i = 0; i < numStyles; ++i)
+        {
+            ResultsModel restyled(styles[i], NULL);
+            startTime = std::chrono::steady_clock::now();
+            for (U64 j = 0; j < decoded.mNumPackets; ++j)
+            {
+                decoded.mStore.GetDecodedPacket(j, packet);
+                restyled.AddPacketFrames(packet, j);
+            }
+            double layOutMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+            printf("%-28s %12zu %12.1f %12.1f\n", styleNames[i], restyled.mFrames.size(), layOutMs, decodeMs);
+        }
+
+        SearchPackets(decoded.mStore, decoded.mIndex);
+    }
+
+    printf("\n%-12s %12s %12s %12s %10s %12s\n", "bit markers", "markers", "frames", "result MB", "errors", "decode ms");
+
+    const MapleBusBitReporting modes[] = {MAPLE_BUS_BITS_ALL, MAPLE_BUS_BITS_NONE, MAPLE_BUS_BITS_ON_ERROR};
+    const char* modeNames[] = {"All Bits", "None", "Errors Only"};
+    for (U32 i = 0; i < sizeof(modes) / sizeof(modes[0]); ++i)
+    {
+        ResultsModel results(MODEL_STYLE_WORD_BYTES_LE, NULL);
+        MapleBusDecoder decoder(&results);
+        decoder.SetBitReporting(modes[i]);
+        MapleBusTransitionArraySource source(initialLines, &transitions[0], transitions.size());
+
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        decoder.Run(&source);
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+        printf("%-12s %12zu %12zu %12.1f %10llu %12.1f\n", modeNames[i], results.mMarkers.size(), results.mFrames.size(),
+               results.GetMemoryUsage() / 1e6, results.mErrors.GetNumErrors(), elapsedMs);
+    }
+
+    // Glitches are far shorter than a phase, so a filter which still passes every real phase removes them all
+    printf("\n%-12s %12s %10s %12s %12s\n", "glitch filter", "packets", "errors", "removed", "decode ms");
+
+    const U32 glitchFilterSamples[] = {0, 2 * BENCH_GLITCH_SAMPLES};
+    for (U32 i = 0; i < sizeof(glitchFilterSamples) / sizeof(glitchFilterSamples[0]); ++i)
+    {
+        ResultsModel results(MODEL_STYLE_EACH_PACKET, NULL);
+        MapleBusDecoder decoder(&results);
+        decoder.SetBitReporting(MAPLE_BUS_BITS_NONE);
+        MapleBusTransitionArraySource source(initialLines, &transitions[0], transitions.size());
+        MapleBusGlitchFilter filter(&source, glitchFilterSamples[i], glitchFilterSamples[i]);
+
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        decoder.Run((glitchFilterSamples[i] > 0) ? static_cast<MapleBusTransitionSource*>(&filter) : &source);
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+        char widthStr[32];
+        snprintf(widthStr, sizeof(widthStr), (glitchFilterSamples[i] > 0) ? "%u samples" : "Off", glitchFilterSamples[i]);
+        printf("%-12s %12llu %10llu %12llu %12.1f\n", widthStr, results.mNumPackets, results.mErrors.GetNumErrors(),
+               filter.GetNumGlitches(), elapsedMs);
+    }
+
+    // The host's frames can't be dropped, so only the records behind them shrink with retention
+    printf("\n%-16s %12s %12s %12s %12s\n", "retained", "frames", "record MB", "result MB", "decode ms");
+
+    const U64 retainedPackets[] = {0, 100000, 1000};
+    for (U32 i = 0; i < sizeof(retainedPackets) / sizeof(retainedPackets[0]); ++i)
+    {
+        ResultsModel results(MODEL_STYLE_EACH_PACKET, NULL);
+        results.SetMaxPackets(retainedPackets[i]);
+        MapleBusDecoder decoder(&results);
+        decoder.SetBitReporting(MAPLE_BUS_BITS_NONE);
+        MapleBusTransitionArraySource source(initialLines, &transitions[0], transitions.size());
+
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        decoder.Run(&source);
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+        char retainedStr[32];
+        snprintf(retainedStr, sizeof(retainedStr), (retainedPackets[i] > 0) ? "%llu packets" : "all", retainedPackets[i]);
+        printf("%-16s %12zu %12.1f %12.1f %12.1f\n", retainedStr, results.mFrames.size(), results.GetRecordMemoryUsage() / 1e6,
+               results.GetMemoryUsage() / 1e6, elapsedMs);
+    }
+
+    printf("\n%-24s %12s %12s %14s\n", "commit results", "commits", "frames", "frames/s");
+
+    const MapleBusCommitPolicy policies[] = {MAPLE_BUS_COMMIT_EACH_FRAME, MAPLE_BUS_COMMIT_EACH_PACKET, MAPLE_BUS_COMMIT_BATCHED};
+    const char* policyNames[] = {"Each Frame", "Each Packet", "Batched (1000, 100 ms)"};
+    for (U32 i = 0; i < sizeof(policies) / sizeof(policies[0]); ++i)
+    {
+        MapleBusCommitScheduler scheduler(policies[i], 1000, 100);
+        ResultsModel results(MODEL_STYLE_EACH_BYTE, &scheduler);
+        MapleBusDecoder decoder(&results);
+        decoder.SetBitReporting(MAPLE_BUS_BITS_NONE);
+        MapleBusTransitionArraySource source(initialLines, &transitions[0], transitions.size());
+
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        decoder.Run(&source);
+        double elapsedS = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        printf("%-24s %12llu %12zu %14.0f\n", policyNames[i], scheduler.GetNumCommits(), results.mFrames.size(),
+               results.mFrames.size() / elapsedS);
+    }
+
+    return 0;
+}
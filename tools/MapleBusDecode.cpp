@@ -0,0 +1,656 @@
+// Offline Maple Bus decoder
+//
+// Decodes a transition list file (see MapleBusTransitionFile.h) or a raw digital capture without the Logic application
+// and prints one line per packet: start sample, end sample, then each byte in hex. A summary with decode throughput and
+// command to response turnaround is printed to stderr. Raw captures may also be converted into transition list files,
+// and decoded packets may also be written to a columnar packet file (see MapleBusPacketFile.h). The summary also counts
+// errors of each type (see MapleBusErrorType) and the bit timing of all packets; -t also prints each packet's bit timing.
+// Every packet is indexed as it is decoded, and -f prints the packets matching a time range and field query. -m bounds
+// memory for long or endless captures by only keeping the most recent packets, transactions and errors; the counts
+// and bit timing summary still cover the whole capture. -o streams every packet to a file or named pipe as it is
+// decoded, whatever -m keeps (see MapleBusPacketStream.h).
+
+#include "MapleBusDecoder.h"
+#include "MapleBusErrorLog.h"
+#include "MapleBusPacketFile.h"
+#include "MapleBusPacketIndex.h"
+#include "MapleBusPacketStream.h"
+#include "MapleBusGlitchFilter.h"
+#include "MapleBusParallelDecoder.h"
+#include "MapleBusProtocol.h"
+#include "MapleBusRawCaptureReader.h"
+#include "MapleBusTransactionTracker.h"
+#include "MapleBusTransitionFile.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+//! Counts the transitions pulled out of another source
+class CountingTransitionSource : public MapleBusTransitionSource
+{
+  public:
+    CountingTransitionSource(MapleBusTransitionSource* source) : mSource(source), mNumTransitions(0)
+    {
+    }
+
+    virtual U8 GetInitialLines()
+    {
+        return mSource->GetInitialLines();
+    }
+
+    virtual bool GetNextTransition(MapleBusTransition& transition)
+    {
+        if (mSource->GetNextTransition(transition))
+        {
+            ++mNumTransitions;
+            return true;
+        }
+        return false;
+    }
+
+    MapleBusTransitionSource* mSource;
+    U64 mNumTransitions;
+};
+
+//! Copies each transition pulled out of another source into a transition list file
+class RecordingTransitionSource : public MapleBusTransitionSource
+{
+  public:
+    RecordingTransitionSource(MapleBusTransitionSource* source, MapleBusTransitionWriter* writer)
+        : mSource(source), mWriter(writer)
+    {
+    }
+
+    virtual U8 GetInitialLines()
+    {
+        return mSource->GetInitialLines();
+    }
+
+    virtual bool GetNextTransition(MapleBusTransition& transition)
+    {
+        if (mSource->GetNextTransition(transition))
+        {
+            mWriter->AddTransition(transition.sample, transition.lines);
+            return true;
+        }
+        return false;
+    }
+
+    MapleBusTransitionSource* mSource;
+    MapleBusTransitionWriter* mWriter;
+};
+
+//! Prints each decoded packet
+class PacketPrinter : public MapleBusDecoderListener
+{
+  public:
+    PacketPrinter(bool quiet, bool timing, MapleBusPacketStore* store, MapleBusPacketStreamWriter* stream)
+        : mQuiet(quiet), mPrintTiming(timing), mNumPackets(0), mNumCrcErrors(0), mErrors(), mTransactions(), mStore(store),
+          mStream(stream)
+    {
+        mTiming.Clear();
+    }
+
+    virtual void OnPacketEnd(const MapleBusPacket& packet)
+    {
+        if (mStore != NULL)
+        {
+            mStore->AddPacket(packet);
+        }
+        if (mStream != NULL)
+        {
+            mStream->AddPacket(packet);
+        }
+        MapleBusPacketInfo info;
+        MapleBusProtocol::InterpretPacket(GetWord(packet, 0), GetWord(packet, 4), packet.bytes.size(), info);
+        mIndex.AddPacket(packet.startSample, packet.endSample, info);
+        mTransactions.AddPacket(mNumPackets, info, packet.startSample, packet.endSample);
+        ++mNumPackets;
+        mErrors.CountPacket(packet);
+        mTiming.Merge(packet.timing);
+        if (!packet.crcValid)
+        {
+            ++mNumCrcErrors;
+        }
+        if (!mQuiet)
+        {
+            printf("%llu,%llu,", packet.startSample, packet.endSample);
+            for (size_t i = 0; i < packet.bytes.size(); ++i)
+            {
+                printf((i == 0) ? "%02X" : " %02X", packet.bytes[i]);
+            }
+            if (mPrintTiming)
+            {
+                const MapleBusBitTiming& timing = packet.timing;
+                printf(",%u/%.1f/%u,%.1f,", (timing.numPeriods > 0) ? timing.minPeriod : 0, timing.GetMeanPeriod(),
+                       timing.maxPeriod, timing.GetJitter());
+                if (timing.minSetup != MapleBusBitTiming::NO_SETUP)
+                {
+                    printf("%u", timing.minSetup);
+                }
+            }
+            printf(packet.crcValid ? "\n" : ",bad CRC\n");
+        }
+    }
+
+    virtual void OnError(const MapleBusDecodeError& error)
+    {
+        mErrors.AddError(error);
+    }
+
+    virtual void OnResync(U64 errorSample, U64 resumeSample)
+    {
+        mErrors.EndError(resumeSample);
+    }
+
+    bool mQuiet;
+    //! Prints the bit timing of each packet
+    bool mPrintTiming;
+    U64 mNumPackets;
+    U64 mNumCrcErrors;
+    //! Every decode failure along with counts of each error type
+    MapleBusErrorLog mErrors;
+    //! Bit timing of every packet
+    MapleBusBitTiming mTiming;
+    MapleBusTransactionTracker mTransactions;
+    //! Start and searchable fields of every retained packet, indexed by packet number
+    MapleBusPacketIndex mIndex;
+    //! Keeps every retained packet when not NULL
+    MapleBusPacketStore* mStore;
+    //! Streams every packet as it is decoded when not NULL
+    MapleBusPacketStreamWriter* mStream;
+
+  private:
+    //! @returns the word starting at the given byte offset, built little endian, or 0 if the packet is too short
+    static U32 GetWord(const MapleBusPacket& packet, size_t offset)
+    {
+        if (packet.bytes.size() < offset + 4)
+        {
+            return 0;
+        }
+        return packet.bytes[offset] | (packet.bytes[offset + 1] << 8) | (packet.bytes[offset + 2] << 16) |
+               (static_cast<U32>(packet.bytes[offset + 3]) << 24);
+    }
+};
+
+//! Prints the start sample, end sample and description of every packet matching a query
+static void PrintMatchingPackets(const MapleBusPacketIndex& index, const MapleBusPacketQuery& query)
+{
+    std::vector<U64> matches;
+    index.FindPackets(query, 0, 0, matches);
+    for (size_t i = 0; i < matches.size(); ++i)
+    {
+        MapleBusPacketIndexEntry entry;
+        index.GetEntry(matches[i], entry);
+        MapleBusPacketInfo info;
+        info.command = entry.command;
+        info.recipient = entry.recipient;
+        info.sender = entry.sender;
+        info.numWords = entry.numWords;
+        info.hasFrameWord = entry.hasFrameWord;
+        info.hasFunction = entry.hasFunction;
+        info.function = entry.function;
+        char description[256];
+        MapleBusProtocol::GetDescription(info, description, sizeof(description));
+        printf("%llu,%llu,%s, %u words\n", entry.startSample, entry.startSample + entry.numSamples, description, entry.numWords);
+    }
+    fprintf(stderr, "%llu packets match", static_cast<U64>(matches.size()));
+    if (index.GetFirstPacketIndex() > 0)
+    {
+        fprintf(stderr, " in the last %llu packets", index.GetNumPackets() - index.GetFirstPacketIndex());
+    }
+    fprintf(stderr, "\n");
+}
+
+//! Prints command to response turnaround over all retained transactions
+static void PrintTransactionSummary(const MapleBusTransactionTracker& transactions, U32 sampleRateHz)
+{
+    U64 numCommands = 0;
+    U64 numAnswered = 0;
+    U64 minTurnaround = 0;
+    U64 maxTurnaround = 0;
+    U64 totalTurnaround = 0;
+    MapleBusTransactionRecord record;
+    U64 firstTransaction = transactions.GetFirstTransactionIndex();
+    for (U64 i = firstTransaction; transactions.GetTransactionAt(i, record); ++i)
+    {
+        if (!record.isCommand)
+        {
+            continue;
+        }
+        ++numCommands;
+        if (record.hasResponse)
+        {
+            U64 turnaround = record.GetTurnaroundSamples();
+            minTurnaround = (numAnswered == 0 || turnaround < minTurnaround) ? turnaround : minTurnaround;
+            maxTurnaround = (turnaround > maxTurnaround) ? turnaround : maxTurnaround;
+            totalTurnaround += turnaround;
+            ++numAnswered;
+        }
+    }
+
+    fprintf(stderr, "%llu commands, %llu unanswered", numCommands, numCommands - numAnswered);
+    if (firstTransaction > 0)
+    {
+        fprintf(stderr, " in the last %llu transactions", transactions.GetNumTransactions() - firstTransaction);
+    }
+    if (numAnswered > 0)
+    {
+        double avgTurnaround = static_cast<double>(totalTurnaround) / numAnswered;
+        if (sampleRateHz > 0)
+        {
+            double usPerSample = 1000000.0 / sampleRateHz;
+            fprintf(stderr, ", turnaround min/avg/max %.3f/%.3f/%.3f us", minTurnaround * usPerSample, avgTurnaround * usPerSample,
+                    maxTurnaround * usPerSample);
+        }
+        else
+        {
+            fprintf(stderr, ", turnaround min/avg/max %llu/%.1f/%llu samples", minTurnaround, avgTurnaround, maxTurnaround);
+        }
+    }
+    fprintf(stderr, "\n");
+}
+
+//! Prints the bit period, bit rate, jitter, shortest setup time and bits out of tolerance over every packet
+static void PrintBitTimingSummary(const MapleBusBitTiming& timing, U32 sampleRateHz)
+{
+    if (timing.numPeriods == 0)
+    {
+        return;
+    }
+
+    if (sampleRateHz > 0)
+    {
+        double usPerSample = 1000000.0 / sampleRateHz;
+        fprintf(stderr, "%.3f Mbit/s, bit period min/avg/max %.3f/%.3f/%.3f us, jitter %.3f us",
+                sampleRateHz / timing.GetMeanPeriod() / 1000000.0, timing.minPeriod * usPerSample, timing.GetMeanPeriod() * usPerSample,
+                timing.maxPeriod * usPerSample, timing.GetJitter() * usPerSample);
+        if (timing.minSetup != MapleBusBitTiming::NO_SETUP)
+        {
+            fprintf(stderr, ", min setup %.3f us", timing.minSetup * usPerSample);
+        }
+    }
+    else
+    {
+        fprintf(stderr, "bit period min/avg/max %u/%.1f/%u samples, jitter %.1f samples", timing.minPeriod, timing.GetMeanPeriod(),
+                timing.maxPeriod, timing.GetJitter());
+        if (timing.minSetup != MapleBusBitTiming::NO_SETUP)
+        {
+            fprintf(stderr, ", min setup %u samples", timing.minSetup);
+        }
+    }
+    if (timing.numOutOfTolerance > 0)
+    {
+        fprintf(stderr, ", %u bits out of tolerance", timing.numOutOfTolerance);
+    }
+    fprintf(stderr, "\n");
+}
+
+static void PrintUsage(const char* exe)
+{
+    fprintf(stderr, "Usage: %s [-q] [-t] [-b <percent> | -B <percent>] [-g <ns>[:<ns B>]] [-f <query>] [-j <threads>]\n"
+                    "          [-m <packets>] [-r <bytes>:<bitA>:<bitB>[:<header bytes>]] [-s <rate>] [-w <out.mbtl>] [-p <out.mbpk>]\n"
+                    "          [-o <out | pipe>] <file | ->\n",
+            exe);
+    fprintf(stderr, "  -q  only print the summary\n");
+    fprintf(stderr, "  -t  also print each packet's min/avg/max bit period, jitter and shortest setup time in samples\n");
+    fprintf(stderr, "  -b  count bits whose period is more than the given percent plus one sample from nominal\n");
+    fprintf(stderr, "  -B  fail packets at the first bit whose period is more than the given percent plus one sample from nominal\n");
+    fprintf(stderr, "  -f  print only the packets matching a query of comma separated fields: cmd=<code>, to=<address>,\n"
+                    "      from=<address>, func=<function mask>, words=<min>[-<max>], start=<sample> and end=<sample>\n");
+    fprintf(stderr, "  -g  remove pulses shorter than the given ns on SDCKA, and on SDCKB if no second width is given\n");
+    fprintf(stderr, "  -j  load all transitions then decode in chunks across threads; 0 for one per hardware thread\n");
+    fprintf(stderr, "  -m  keep at least the given number of recent packets, transactions and errors, dropping older ones\n");
+    fprintf(stderr, "  -r  read a raw capture of 1, 2, 4 or 8 byte samples with SDCKA and SDCKB at the given bits\n");
+    fprintf(stderr, "  -s  sample rate in Hz of a raw capture, stored when converting, or of a transition file without one\n");
+    fprintf(stderr, "  -w  also write the transitions of a raw capture to a transition list file\n");
+    fprintf(stderr, "  -p  also write every decoded packet, or only those still kept with -m, to a columnar packet file\n");
+    fprintf(stderr, "  -o  also stream every decoded packet to a file or named pipe as it is decoded, whatever -m keeps\n");
+}
+
+//! Parses the -f argument
+//! @returns false iff the argument is malformed
+static bool ParseQuery(const char* arg, MapleBusPacketQuery& query)
+{
+    std::vector<char> text(arg, arg + strlen(arg) + 1);
+    for (char* field = strtok(&text[0], ","); field != NULL; field = strtok(NULL, ","))
+    {
+        char* value = strchr(field, '=');
+        if (value == NULL)
+        {
+            return false;
+        }
+        *value++ = '\0';
+        char* end = NULL;
+        unsigned long long number = strtoull(value, &end, 0);
+        if (end == value)
+        {
+            return false;
+        }
+
+        if (strcmp(field, "cmd") == 0)
+        {
+            query.fields |= MAPLE_BUS_QUERY_COMMAND;
+            query.command = static_cast<U8>(number);
+        }
+        else if (strcmp(field, "to") == 0)
+        {
+            query.fields |= MAPLE_BUS_QUERY_RECIPIENT;
+            query.recipient = static_cast<U8>(number);
+        }
+        else if (strcmp(field, "from") == 0)
+        {
+            query.fields |= MAPLE_BUS_QUERY_SENDER;
+            query.sender = static_cast<U8>(number);
+        }
+        else if (strcmp(field, "func") == 0)
+        {
+            query.fields |= MAPLE_BUS_QUERY_FUNCTION;
+            query.function = static_cast<U32>(number);
+        }
+        else if (strcmp(field, "words") == 0)
+        {
+            query.fields |= MAPLE_BUS_QUERY_NUM_WORDS;
+            query.minWords = static_cast<U8>(number);
+            query.maxWords = (*end == '-') ? static_cast<U8>(strtoul(end + 1, NULL, 0)) : query.minWords;
+        }
+        else if (strcmp(field, "start") == 0)
+        {
+            query.startSample = number;
+        }
+        else if (strcmp(field, "end") == 0)
+        {
+            query.endSample = number;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//! Parses the -r argument
+//! @returns false iff the argument is malformed
+static bool ParseRawFormat(const char* arg, U32& bytesPerSample, U32& channelABit, U32& channelBBit, U64& headerBytes)
+{
+    unsigned int bytes = 0;
+    unsigned int bitA = 0;
+    unsigned int bitB = 0;
+    unsigned long long header = 0;
+    int numParsed = sscanf(arg, "%u:%u:%u:%llu", &bytes, &bitA, &bitB, &header);
+    if (numParsed < 3)
+    {
+        return false;
+    }
+    bytesPerSample = bytes;
+    channelABit = bitA;
+    channelBBit = bitB;
+    headerBytes = header;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    bool quiet = false;
+    bool timing = false;
+    MapleBusTimingCheck timingCheck = MAPLE_BUS_TIMING_OFF;
+    U32 tolerancePercent = 0;
+    bool search = false;
+    MapleBusPacketQuery query;
+    U32 glitchNsA = 0;
+    U32 glitchNsB = 0;
+    U32 numThreads = 1;
+    U64 maxPackets = 0;
+    bool raw = false;
+    U32 bytesPerSample = 1;
+    U32 channelABit = 0;
+    U32 channelBBit = 1;
+    U64 headerBytes = 0;
+    U32 sampleRateHz = 0;
+    const char* outPath = NULL;
+    const char* packetPath = NULL;
+    const char* streamPath = NULL;
+    const char* path = NULL;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-q") == 0)
+        {
+            quiet = true;
+        }
+        else if (strcmp(argv[i], "-t") == 0)
+        {
+            timing = true;
+        }
+        else if ((strcmp(argv[i], "-b") == 0 || strcmp(argv[i], "-B") == 0) && i + 1 < argc)
+        {
+            timingCheck = (argv[i][1] == 'b') ? MAPLE_BUS_TIMING_FLAG : MAPLE_BUS_TIMING_REJECT;
+            tolerancePercent = static_cast<U32>(strtoul(argv[++i], NULL, 10));
+        }
+        else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+        {
+            if (!ParseQuery(argv[++i], query))
+            {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            search = true;
+            quiet = true;
+        }
+        else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc)
+        {
+            unsigned int widthA = 0;
+            unsigned int widthB = 0;
+            int numParsed = sscanf(argv[++i], "%u:%u", &widthA, &widthB);
+            if (numParsed < 1)
+            {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            glitchNsA = widthA;
+            glitchNsB = (numParsed > 1) ? widthB : widthA;
+        }
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+        {
+            numThreads = static_cast<U32>(strtoul(argv[++i], NULL, 10));
+        }
+        else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+        {
+            maxPackets = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+        {
+            if (!ParseRawFormat(argv[++i], bytesPerSample, channelABit, channelBBit, headerBytes))
+            {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            raw = true;
+        }
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+        {
+            sampleRateHz = static_cast<U32>(strtoul(argv[++i], NULL, 10));
+        }
+        else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+        {
+            outPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+        {
+            packetPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        {
+            streamPath = argv[++i];
+        }
+        else if (path == NULL)
+        {
+            path = argv[i];
+        }
+        else
+        {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (path == NULL || (outPath != NULL && !raw))
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    MapleBusTransitionReader reader;
+    MapleBusRawCaptureReader rawReader;
+    MapleBusTransitionWriter writer;
+    MapleBusTransitionSource* input = NULL;
+    if (raw)
+    {
+        if (!rawReader.Open(path, bytesPerSample, channelABit, channelBBit, headerBytes))
+        {
+            fprintf(stderr, "Failed to map raw capture: %s\n", path);
+            return 1;
+        }
+        input = &rawReader;
+    }
+    else
+    {
+        if (!reader.Open(path))
+        {
+            fprintf(stderr, "Failed to open transition file: %s\n", path);
+            return 1;
+        }
+        input = &reader;
+    }
+
+    RecordingTransitionSource recorder(input, &writer);
+    if (outPath != NULL)
+    {
+        if (!writer.Open(outPath, sampleRateHz, 0, rawReader.GetInitialLines()))
+        {
+            fprintf(stderr, "Failed to create transition file: %s\n", outPath);
+            return 1;
+        }
+        input = &recorder;
+    }
+
+    MapleBusPacketStreamWriter stream;
+    if (streamPath != NULL && !stream.Open(streamPath))
+    {
+        fprintf(stderr, "Failed to open packet stream: %s\n", streamPath);
+        return 1;
+    }
+
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+    U32 captureSampleRateHz = (raw || reader.GetSampleRate() == 0) ? sampleRateHz : reader.GetSampleRate();
+    if ((glitchNsA > 0 || glitchNsB > 0) && captureSampleRateHz == 0)
+    {
+        fprintf(stderr, "The sample rate must be known to filter glitches\n");
+        return 1;
+    }
+
+    CountingTransitionSource source(input);
+    MapleBusGlitchFilter filter(&source, MapleBusGlitchFilter::NanosecondsToSamples(glitchNsA, captureSampleRateHz),
+                                MapleBusGlitchFilter::NanosecondsToSamples(glitchNsB, captureSampleRateHz));
+    MapleBusTransitionSource* decodeSource = (glitchNsA > 0 || glitchNsB > 0) ? static_cast<MapleBusTransitionSource*>(&filter) : &source;
+    MapleBusPacketStore store;
+    PacketPrinter printer(quiet, timing, (packetPath != NULL) ? &store : NULL, (streamPath != NULL) ? &stream : NULL);
+    store.SetMaxPackets(maxPackets);
+    printer.mIndex.SetMaxPackets(maxPackets);
+    printer.mTransactions.SetMaxTransactions(maxPackets);
+    printer.mErrors.SetMaxErrors(maxPackets);
+    if (numThreads == 1)
+    {
+        MapleBusDecoder decoder(&printer);
+        decoder.SetTimingCheck(timingCheck, tolerancePercent);
+        decoder.Run(decodeSource);
+    }
+    else
+    {
+        U8 initialLines = decodeSource->GetInitialLines();
+        std::vector<MapleBusTransition> transitions;
+        MapleBusTransition transition;
+        while (decodeSource->GetNextTransition(transition))
+        {
+            transitions.push_back(transition);
+        }
+
+        MapleBusParallelDecoder decoder(&printer);
+        decoder.SetTimingCheck(timingCheck, tolerancePercent);
+        decoder.Run(initialLines, transitions.empty() ? NULL : &transitions[0], transitions.size(), numThreads);
+        fprintf(stderr, "%u chunks, %u decoded again serially\n", decoder.GetNumChunks(), decoder.GetNumResyncs());
+    }
+
+    double elapsedS = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    if (streamPath != NULL && !stream.Close())
+    {
+        fprintf(stderr, "Failed to write packet stream: %s\n", streamPath);
+        return 1;
+    }
+
+    if (outPath != NULL && !writer.Close(rawReader.GetNumSamples() - 1))
+    {
+        fprintf(stderr, "Failed to write transition file: %s\n", outPath);
+        return 1;
+    }
+    if (!raw && reader.IsTruncated())
+    {
+        fprintf(stderr, "Warning: transition file is truncated\n");
+    }
+    fprintf(stderr, "%llu packets, %llu errors (%llu samples skipped), %llu CRC errors, %llu transitions in %.3f s",
+            printer.mNumPackets, printer.mErrors.GetNumErrors(), printer.mErrors.GetNumSkippedSamples(), printer.mNumCrcErrors,
+            source.mNumTransitions, elapsedS);
+    if (elapsedS > 0)
+    {
+        fprintf(stderr, " (%.0f packets/s, %.0f transitions/s", printer.mNumPackets / elapsedS, source.mNumTransitions / elapsedS);
+        if (raw)
+        {
+            fprintf(stderr, ", %.0f samples/s", rawReader.GetNumSamples() / elapsedS);
+        }
+        fprintf(stderr, ")");
+    }
+    fprintf(stderr, "\n");
+    if (glitchNsA > 0 || glitchNsB > 0)
+    {
+        fprintf(stderr, "%llu glitches filtered\n", filter.GetNumGlitches());
+    }
+    fprintf(stderr, "Errors by type:");
+    for (U32 i = 0; i < MAPLE_BUS_NUM_ERROR_TYPES; ++i)
+    {
+        char typeStr[32];
+        MapleBusErrorLog::GetTypeString(static_cast<MapleBusErrorType>(i), typeStr, sizeof(typeStr));
+        fprintf(stderr, "%s %s %llu", (i > 0) ? "," : "", typeStr, printer.mErrors.GetCount(static_cast<MapleBusErrorType>(i)));
+    }
+    fprintf(stderr, "\n");
+    PrintTransactionSummary(printer.mTransactions, captureSampleRateHz);
+    PrintBitTimingSummary(printer.mTiming, captureSampleRateHz);
+    if (search)
+    {
+        PrintMatchingPackets(printer.mIndex, query);
+    }
+
+    if (packetPath != NULL)
+    {
+        MapleBusPacketFileWriter packetWriter;
+        bool writeOk = packetWriter.Open(packetPath, store.GetNumPackets() - store.GetFirstPacketIndex(), captureSampleRateHz, 0);
+        MapleBusPacketRecord record;
+        std::vector<U8> bytes;
+        for (U64 i = store.GetFirstPacketIndex(); writeOk && i < store.GetNumPackets(); ++i)
+        {
+            store.GetPacket(i, record);
+            store.GetPacketBytes(i, bytes);
+            packetWriter.AddPacket(record, bytes);
+        }
+        if (!writeOk || !packetWriter.Close())
+        {
+            fprintf(stderr, "Failed to write packet file: %s\n", packetPath);
+            return 1;
+        }
+    }
+
+    return 0;
+}